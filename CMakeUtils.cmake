@@ -68,3 +68,17 @@ macro(add_subdirectories)
         add_subdirectory(${SUB_DIR})
     endforeach()
 endmacro()
+
+# Recompiles a 6502 image to C++ with emos_recompile and adds the source to the target. The image is usually
+# built by another target, which must be passed as well. Remaining arguments are passed to emos_recompile.
+function(target_add_recompiled_image TARGET_NAME IMAGE_TARGET IMAGE_PATH PROGRAM_NAME)
+    set(OUTPUT_DIR ${CMAKE_CURRENT_BINARY_DIR}/recompiled)
+    set(OUTPUT_PATH ${OUTPUT_DIR}/${PROGRAM_NAME}.cpp)
+    add_custom_command(
+        OUTPUT ${OUTPUT_PATH}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+        COMMAND emos_recompile ${ARGN} -n ${PROGRAM_NAME} -o ${OUTPUT_PATH} ${IMAGE_PATH}
+        DEPENDS emos_recompile ${IMAGE_TARGET} ${IMAGE_PATH}
+    )
+    target_sources(${TARGET_NAME} PRIVATE ${OUTPUT_PATH})
+endfunction()
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "src/types.h"
+
+#include <vector>
+
+// Execute breakpoints and read/write watchpoints, stored as bitmaps with one bit per address. Bitmaps are
+// allocated with the first point, so processors without any points do not pay for them.
+//
+// Execute breakpoints are checked before the instruction is fetched, so the processor stops at the exact
+// instruction. Watchpoints are hit during an instruction, which is always completed, and the processor stops
+// before the next one. The breakpoint, which stopped the processor, is skipped once, so execution can be resumed.
+class Breakpoints {
+public:
+    enum class Type {
+        Execute,
+        Read,
+        Write,
+        COUNT,
+    };
+
+    void set(Type type, u16 address) {
+        if (bitmaps.empty()) {
+            bitmaps.resize(typesCount * wordsPerBitmap);
+        }
+        if (!isSet(type, address)) {
+            getWord(type, address) |= getBit(address);
+            pointsCount[static_cast<u32>(type)]++;
+        }
+    }
+
+    void clear(Type type, u16 address) {
+        if (isSet(type, address)) {
+            getWord(type, address) &= ~getBit(address);
+            pointsCount[static_cast<u32>(type)]--;
+        }
+    }
+
+    bool isSet(Type type, u16 address) const {
+        return !bitmaps.empty() && (bitmaps[getWordIndex(type, address)] & getBit(address)) != 0;
+    }
+
+    bool hasBreakpoints() const { return pointsCount[static_cast<u32>(Type::Execute)] > 0; }
+    bool hasWatchpoints() const { return pointsCount[static_cast<u32>(Type::Read)] + pointsCount[static_cast<u32>(Type::Write)] > 0; }
+
+    // Called before every instruction. Returns true, if the processor should stop.
+    bool shouldBreakAt(u16 pc) {
+        const bool resuming = resumePending && resumeAddress == pc;
+        resumePending = false;
+        if (resuming || !isSet(Type::Execute, pc)) {
+            return false;
+        }
+        resumePending = true;
+        resumeAddress = pc;
+        return true;
+    }
+
+    // Called for every memory access. Only the first hit of an instruction is remembered.
+    void access(Type type, u16 address) {
+        if (!watchpointHit && isSet(type, address)) {
+            watchpointHit = true;
+            watchpointHitType = type;
+            watchpointHitAddress = address;
+        }
+    }
+
+    bool isWatchpointHit() const { return watchpointHit; }
+    Type getWatchpointHitType() const { return watchpointHitType; }
+    u16 getWatchpointHitAddress() const { return watchpointHitAddress; }
+    void clearWatchpointHit() { watchpointHit = false; }
+
+    void resetHits() {
+        resumePending = false;
+        watchpointHit = false;
+    }
+
+private:
+    constexpr static u32 typesCount = static_cast<u32>(Type::COUNT);
+    constexpr static u32 wordsPerBitmap = 64 * 1024 / 64;
+
+    static u32 getWordIndex(Type type, u16 address) { return static_cast<u32>(type) * wordsPerBitmap + address / 64; }
+    static u64 getBit(u16 address) { return u64{1} << (address % 64); }
+    u64 &getWord(Type type, u16 address) { return bitmaps[getWordIndex(type, address)]; }
+
+    std::vector<u64> bitmaps = {};
+    u32 pointsCount[typesCount] = {};
+
+    bool resumePending = false;
+    u16 resumeAddress = 0;
+
+    bool watchpointHit = false;
+    Type watchpointHitType = Type::Read;
+    u16 watchpointHitAddress = 0;
+};
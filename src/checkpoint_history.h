@@ -0,0 +1,112 @@
+#pragma once
+
+#include "src/counters.h"
+#include "src/error.h"
+#include "src/memory.h"
+#include "src/registers.h"
+
+#include <bitset>
+#include <deque>
+#include <vector>
+
+// Checkpoints are used to go back in time during execution. Each checkpoint stores registers and counters at
+// a given instruction index. Instead of copying whole memory, it shares original memory pages which were
+// modified after the checkpoint had been taken. Memory copies them on write, so saving a page is cheap.
+// Restoring a checkpoint undoes page modifications of all newer checkpoints, so the memory looks exactly as
+// it did when the checkpoint was taken.
+class CheckpointHistory {
+public:
+    void setup(u32 newCheckpointInterval, u32 newMaxCheckpointsCount) {
+        FATAL_ERROR_IF(newCheckpointInterval == 0, "Checkpoint interval cannot be 0");
+        FATAL_ERROR_IF(newMaxCheckpointsCount == 0, "Checkpoints count cannot be 0");
+        checkpointInterval = newCheckpointInterval;
+        maxCheckpointsCount = newMaxCheckpointsCount;
+        reset();
+    }
+
+    void reset() {
+        checkpoints.clear();
+    }
+
+    bool isCheckpointNeeded(u32 instructionIndex) const {
+        return checkpoints.empty() || instructionIndex >= checkpoints.back().instructionIndex + checkpointInterval;
+    }
+
+    void takeCheckpoint(const Registers &regs, const Counters &counters) {
+        if (checkpoints.size() == maxCheckpointsCount) {
+            checkpoints.pop_front();
+        }
+
+        Checkpoint &checkpoint = checkpoints.emplace_back();
+        checkpoint.instructionIndex = counters.instructionsProcessed;
+        checkpoint.regs = regs;
+        checkpoint.counters = counters;
+    }
+
+    void beforeWrite(u16 address, Memory &memory) {
+        if (checkpoints.empty()) {
+            return;
+        }
+
+        Checkpoint &checkpoint = checkpoints.back();
+        const u32 pageIndex = address / Memory::pageSize;
+        if (checkpoint.savedPagesMask[pageIndex]) {
+            return;
+        }
+
+        SavedPage &page = checkpoint.savedPages.emplace_back();
+        page.pageIndex = pageIndex;
+        page.data = memory.sharePage(pageIndex);
+        checkpoint.savedPagesMask[pageIndex] = true;
+    }
+
+    // Brings memory back to the state of the newest checkpoint taken at or before the target instruction index.
+    // All newer checkpoints are discarded. Returns nullptr if the target is older than the oldest checkpoint.
+    const Registers *restore(u32 targetInstructionIndex, Counters &outCounters, Memory &memory) {
+        if (checkpoints.empty() || checkpoints.front().instructionIndex > targetInstructionIndex) {
+            return nullptr;
+        }
+
+        while (true) {
+            Checkpoint &checkpoint = checkpoints.back();
+            for (const SavedPage &page : checkpoint.savedPages) {
+                memory.mapPage(page.pageIndex, page.data);
+            }
+            checkpoint.savedPages.clear();
+            checkpoint.savedPagesMask.reset();
+
+            if (checkpoint.instructionIndex <= targetInstructionIndex) {
+                outCounters = checkpoint.counters;
+                return &checkpoint.regs;
+            }
+            checkpoints.pop_back();
+        }
+    }
+
+    std::vector<u32> getCheckpointIndices() const {
+        std::vector<u32> result{};
+        result.reserve(checkpoints.size());
+        for (const Checkpoint &checkpoint : checkpoints) {
+            result.push_back(checkpoint.instructionIndex);
+        }
+        return result;
+    }
+
+private:
+    struct SavedPage {
+        u32 pageIndex;
+        std::shared_ptr<const u8> data;
+    };
+
+    struct Checkpoint {
+        u32 instructionIndex = 0;
+        Registers regs = {};
+        Counters counters = {};
+        std::bitset<Memory::pagesCount> savedPagesMask = {};
+        std::vector<SavedPage> savedPages = {};
+    };
+
+    u32 checkpointInterval = 0;
+    u32 maxCheckpointsCount = 0;
+    std::deque<Checkpoint> checkpoints = {};
+};
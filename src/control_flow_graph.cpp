@@ -0,0 +1,468 @@
+#include "control_flow_graph.h"
+
+#include "src/disassembler.h"
+#include "src/error.h"
+#include "src/processor.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+using Terminator = ControlFlowGraph::Terminator;
+
+constexpr u16 nmiVectorAddress = 0xFFFA;
+constexpr u16 resetVectorAddress = 0xFFFC;
+constexpr u16 irqVectorAddress = 0xFFFE;
+
+// Instructions ending a block are classified once for every opcode. Instructions, which do not transfer
+// the control, are marked as Fallthrough.
+const std::array<Terminator, 256> &getTerminators() {
+    static const std::array<Terminator, 256> terminators = []() {
+        std::array<Terminator, 256> result{};
+        for (u32 opCode = 0; opCode < result.size(); opCode++) {
+            Terminator &terminator = result[opCode];
+            terminator = Terminator::Fallthrough;
+            if (!Processor::isInstructionSupported(static_cast<u8>(opCode))) {
+                terminator = Terminator::InvalidOpCode;
+            } else if (Processor::getAddressingMode(static_cast<u8>(opCode)) == AddressingMode::Relative) {
+                terminator = Terminator::Branch;
+            } else {
+                switch (static_cast<OpCode>(opCode)) {
+                case OpCode::JMP_abs:
+                    terminator = Terminator::Jump;
+                    break;
+                case OpCode::JMP_i:
+                    terminator = Terminator::IndirectJump;
+                    break;
+                case OpCode::JSR:
+                    terminator = Terminator::Call;
+                    break;
+                case OpCode::RTS:
+                    terminator = Terminator::Return;
+                    break;
+                case OpCode::RTI:
+                    terminator = Terminator::ReturnFromInterrupt;
+                    break;
+                case OpCode::BRK:
+                    terminator = Terminator::Interrupt;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        return result;
+    }();
+    return terminators;
+}
+
+u16 read16(const Memory &memory, u16 address) {
+    return static_cast<u16>(memory.read(address) | memory.read(static_cast<u16>(address + 1)) << 8);
+}
+
+void appendFormat(std::string &output, const char *format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    const int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    output.append(buffer, std::min(static_cast<size_t>(length), sizeof(buffer) - 1));
+}
+
+// Escapes characters, which have a special meaning in strings of both DOT and JSON
+void appendEscaped(std::string &output, std::string_view text) {
+    for (const char character : text) {
+        if (character == '"' || character == '\\') {
+            output.push_back('\\');
+        }
+        output.push_back(character);
+    }
+}
+
+const char *findExactLabel(const SymbolTable *symbols, u16 address) {
+    u16 offset = 0;
+    const char *label = symbols != nullptr ? symbols->findLabel(address, offset) : nullptr;
+    return offset == 0 ? label : nullptr;
+}
+} // namespace
+
+void ControlFlowGraph::addEntryPoint(u16 address, EntryKind kind) {
+    entryPoints.push_back(EntryPoint{address, kind});
+}
+
+void ControlFlowGraph::addVectorEntryPoints(const Memory &memory) {
+    addEntryPoint(read16(memory, resetVectorAddress), EntryKind::Reset);
+    addEntryPoint(read16(memory, irqVectorAddress), EntryKind::Irq);
+    addEntryPoint(read16(memory, nmiVectorAddress), EntryKind::Nmi);
+}
+
+void ControlFlowGraph::build(const Memory &memory) {
+    blocks.clear();
+    edges.clear();
+    isInstruction.assign(memorySize, false);
+    isBlockStart.assign(memorySize, false);
+    pendingEdges.clear();
+
+    discoverInstructions(memory);
+    createBlocks(memory);
+    connectBlocks();
+
+    isInstruction = {};
+    isBlockStart = {};
+    pendingEdges = {};
+}
+
+u32 ControlFlowGraph::findBlock(u16 start) const {
+    auto it = std::lower_bound(blocks.begin(), blocks.end(), start, [](const BasicBlock &block, u16 value) {
+        return block.start < value;
+    });
+    if (it == blocks.end() || it->start != start) {
+        return invalidBlock;
+    }
+    return static_cast<u32>(it - blocks.begin());
+}
+
+void ControlFlowGraph::discoverInstructions(const Memory &memory) {
+    const std::array<Terminator, 256> &terminators = getTerminators();
+
+    std::vector<u16> workList{};
+    auto addBlockStart = [&](u16 address) {
+        if (!isBlockStart[address]) {
+            isBlockStart[address] = true;
+            workList.push_back(address);
+        }
+    };
+    for (const EntryPoint &entryPoint : entryPoints) {
+        addBlockStart(entryPoint.address);
+    }
+
+    // Decode instructions linearly from every block start until the control is transferred. Targets of
+    // the transfers are new block starts. Decoding stops at already decoded instructions, but the instruction
+    // has to start a block then, because it's reached from two places.
+    while (!workList.empty()) {
+        u16 address = workList.back();
+        workList.pop_back();
+
+        while (true) {
+            if (isInstruction[address]) {
+                isBlockStart[address] = true;
+                break;
+            }
+            isInstruction[address] = true;
+
+            const u8 opCode = memory.read(address);
+            const u16 next = static_cast<u16>(address + Disassembler::getInstructionSize(opCode));
+            const Terminator terminator = terminators[opCode];
+            if (terminator == Terminator::Fallthrough) {
+                if (isBlockStart[next]) {
+                    break;
+                }
+                address = next;
+                continue;
+            }
+
+            switch (terminator) {
+            case Terminator::Branch: {
+                const u16 target = static_cast<u16>(next + static_cast<i8>(memory.read(static_cast<u16>(address + 1))));
+                pendingEdges.push_back(PendingEdge{address, target, EdgeKind::Branch});
+                addBlockStart(target);
+                addBlockStart(next);
+                break;
+            }
+            case Terminator::Jump: {
+                const u16 target = read16(memory, static_cast<u16>(address + 1));
+                pendingEdges.push_back(PendingEdge{address, target, EdgeKind::Jump});
+                addBlockStart(target);
+                break;
+            }
+            case Terminator::Call: {
+                const u16 target = read16(memory, static_cast<u16>(address + 1));
+                pendingEdges.push_back(PendingEdge{address, target, EdgeKind::Call});
+                addBlockStart(target);
+                addBlockStart(next);
+                break;
+            }
+            case Terminator::Interrupt: {
+                const u16 target = read16(memory, irqVectorAddress);
+                pendingEdges.push_back(PendingEdge{address, target, EdgeKind::Interrupt});
+                addBlockStart(target);
+                break;
+            }
+            default:
+                break;
+            }
+            break;
+        }
+    }
+}
+
+void ControlFlowGraph::createBlocks(const Memory &memory) {
+    const std::array<Terminator, 256> &terminators = getTerminators();
+
+    for (u32 start = 0; start < memorySize; start++) {
+        if (!isBlockStart[start]) {
+            continue;
+        }
+
+        BasicBlock block{};
+        block.start = static_cast<u16>(start);
+        block.end = start;
+        block.lastInstruction = static_cast<u16>(start);
+        block.terminator = Terminator::Fallthrough;
+        while (true) {
+            const u16 address = static_cast<u16>(block.end);
+            const u8 opCode = memory.read(address);
+            block.terminator = terminators[opCode];
+            if (block.terminator == Terminator::InvalidOpCode) {
+                break;
+            }
+
+            block.lastInstruction = address;
+            block.instructionsCount++;
+            block.end += Disassembler::getInstructionSize(opCode);
+            if (block.terminator != Terminator::Fallthrough || isBlockStart[static_cast<u16>(block.end)]) {
+                break;
+            }
+        }
+        blocks.push_back(block);
+    }
+}
+
+void ControlFlowGraph::connectBlocks() {
+    std::sort(pendingEdges.begin(), pendingEdges.end(), [](const PendingEdge &a, const PendingEdge &b) {
+        return a.sourceInstruction < b.sourceInstruction;
+    });
+
+    // Successors of every block, in order: edges to targets of the last instruction and then the fallthrough
+    std::vector<std::vector<Edge>> successors(blocks.size());
+    for (u32 blockIndex = 0; blockIndex < blocks.size(); blockIndex++) {
+        const BasicBlock &block = blocks[blockIndex];
+        if (block.instructionsCount == 0) {
+            continue;
+        }
+
+        auto [first, last] = std::equal_range(pendingEdges.begin(), pendingEdges.end(), PendingEdge{block.lastInstruction, 0, EdgeKind::Jump},
+                                              [](const PendingEdge &a, const PendingEdge &b) { return a.sourceInstruction < b.sourceInstruction; });
+        for (auto it = first; it != last; ++it) {
+            successors[blockIndex].push_back(Edge{findBlock(it->target), it->kind});
+        }
+
+        const bool hasFallthrough = block.terminator == Terminator::Fallthrough || block.terminator == Terminator::Branch || block.terminator == Terminator::Call;
+        if (hasFallthrough) {
+            successors[blockIndex].push_back(Edge{findBlock(static_cast<u16>(block.end)), EdgeKind::Fallthrough});
+        }
+    }
+
+    addReturnEdges(successors);
+
+    for (u32 blockIndex = 0; blockIndex < blocks.size(); blockIndex++) {
+        blocks[blockIndex].firstEdge = static_cast<u32>(edges.size());
+        blocks[blockIndex].edgesCount = static_cast<u32>(successors[blockIndex].size());
+        edges.insert(edges.end(), successors[blockIndex].begin(), successors[blockIndex].end());
+    }
+}
+
+void ControlFlowGraph::addReturnEdges(std::vector<std::vector<Edge>> &successors) const {
+    // Gather return sites of every subroutine. Return site is the fallthrough of the calling block.
+    std::vector<std::vector<u32>> returnSites(blocks.size());
+    for (u32 blockIndex = 0; blockIndex < blocks.size(); blockIndex++) {
+        if (blocks[blockIndex].terminator != Terminator::Call) {
+            continue;
+        }
+        u32 target = invalidBlock;
+        u32 returnSite = invalidBlock;
+        for (const Edge &edge : successors[blockIndex]) {
+            if (edge.kind == EdgeKind::Call) {
+                target = edge.targetBlock;
+            } else if (edge.kind == EdgeKind::Fallthrough) {
+                returnSite = edge.targetBlock;
+            }
+        }
+        std::vector<u32> &targetReturnSites = returnSites[target];
+        if (std::find(targetReturnSites.begin(), targetReturnSites.end(), returnSite) == targetReturnSites.end()) {
+            targetReturnSites.push_back(returnSite);
+        }
+    }
+
+    // Find RTS instructions reachable from every subroutine without going through other calls. Nested calls
+    // are followed through their return sites.
+    std::vector<u32> visitedStamps(blocks.size(), invalidBlock);
+    std::vector<u32> workList{};
+    for (u32 subroutine = 0; subroutine < blocks.size(); subroutine++) {
+        if (returnSites[subroutine].empty()) {
+            continue;
+        }
+
+        workList.push_back(subroutine);
+        visitedStamps[subroutine] = subroutine;
+        while (!workList.empty()) {
+            const u32 blockIndex = workList.back();
+            workList.pop_back();
+
+            if (blocks[blockIndex].terminator == Terminator::Return) {
+                std::vector<Edge> &blockSuccessors = successors[blockIndex];
+                for (const u32 returnSite : returnSites[subroutine]) {
+                    const bool isDuplicate = std::any_of(blockSuccessors.begin(), blockSuccessors.end(), [&](const Edge &edge) {
+                        return edge.targetBlock == returnSite;
+                    });
+                    if (!isDuplicate) {
+                        blockSuccessors.push_back(Edge{returnSite, EdgeKind::Return});
+                    }
+                }
+                continue;
+            }
+
+            for (const Edge &edge : successors[blockIndex]) {
+                const bool isIntraProcedural = edge.kind == EdgeKind::Fallthrough || edge.kind == EdgeKind::Branch || edge.kind == EdgeKind::Jump;
+                if (isIntraProcedural && visitedStamps[edge.targetBlock] != subroutine) {
+                    visitedStamps[edge.targetBlock] = subroutine;
+                    workList.push_back(edge.targetBlock);
+                }
+            }
+        }
+    }
+}
+
+void ControlFlowGraph::writeDot(const Memory &memory, const SymbolTable *symbols, std::string &output) const {
+    Disassembler disassembler{symbols};
+
+    output.append("digraph cfg {\n");
+    output.append("    node [shape=box, fontname=\"monospace\"];\n");
+    for (const BasicBlock &block : blocks) {
+        // Label has the names of the block and lines of disassembled instructions, aligned to the left
+        appendFormat(output, "    b%04x [label=\"", block.start);
+        for (const EntryPoint &entryPoint : entryPoints) {
+            if (entryPoint.address == block.start) {
+                appendFormat(output, "[%s] ", getEntryKindName(entryPoint.kind));
+            }
+        }
+        if (const char *label = findExactLabel(symbols, block.start); label != nullptr) {
+            appendEscaped(output, label);
+            output.append(":");
+        }
+        output.append("\\l");
+        for (u32 address = block.start; address < block.end;) {
+            const u8 bytes[Disassembler::maxInstructionSize] = {
+                memory.read(static_cast<u16>(address)),
+                memory.read(static_cast<u16>(address + 1)),
+                memory.read(static_cast<u16>(address + 2)),
+            };
+            u32 size = 0;
+            const std::string_view instruction = disassembler.disassembleInstruction(static_cast<u16>(address), bytes, &size);
+            appendFormat(output, "%04x  ", static_cast<u16>(address));
+            appendEscaped(output, instruction);
+            output.append("\\l");
+            address += size;
+        }
+        if (block.terminator == Terminator::InvalidOpCode) {
+            appendFormat(output, "%04x  invalid opcode\\l", static_cast<u16>(block.end));
+        }
+        output.append("\"];\n");
+    }
+
+    for (const BasicBlock &block : blocks) {
+        const Edge *successors = getSuccessors(block);
+        for (u32 edgeIndex = 0; edgeIndex < block.edgesCount; edgeIndex++) {
+            const Edge &edge = successors[edgeIndex];
+            const char *style = "solid";
+            if (edge.kind == EdgeKind::Call || edge.kind == EdgeKind::Interrupt) {
+                style = "dashed";
+            } else if (edge.kind == EdgeKind::Return) {
+                style = "dotted";
+            }
+            appendFormat(output, "    b%04x -> b%04x [label=\"%s\", style=%s];\n", block.start, blocks[edge.targetBlock].start,
+                         edge.kind == EdgeKind::Fallthrough ? "" : getEdgeKindName(edge.kind), style);
+        }
+    }
+    output.append("}\n");
+}
+
+void ControlFlowGraph::writeJson(const SymbolTable *symbols, std::string &output) const {
+    output.append("{\n  \"entryPoints\": [");
+    for (size_t entryIndex = 0; entryIndex < entryPoints.size(); entryIndex++) {
+        const EntryPoint &entryPoint = entryPoints[entryIndex];
+        appendFormat(output, "%s\n    {\"address\": %u, \"kind\": \"%s\"}", entryIndex == 0 ? "" : ",", entryPoint.address, getEntryKindName(entryPoint.kind));
+    }
+    output.append("\n  ],\n  \"blocks\": [");
+
+    for (size_t blockIndex = 0; blockIndex < blocks.size(); blockIndex++) {
+        const BasicBlock &block = blocks[blockIndex];
+        appendFormat(output, "%s\n    {\"start\": %u, \"end\": %u, \"instructions\": %u, \"terminator\": \"%s\"", blockIndex == 0 ? "" : ",",
+                     block.start, block.end, block.instructionsCount, getTerminatorName(block.terminator));
+        if (const char *label = findExactLabel(symbols, block.start); label != nullptr) {
+            output.append(", \"label\": \"");
+            appendEscaped(output, label);
+            output.append("\"");
+        }
+
+        output.append(", \"successors\": [");
+        const Edge *successors = getSuccessors(block);
+        for (u32 edgeIndex = 0; edgeIndex < block.edgesCount; edgeIndex++) {
+            const Edge &edge = successors[edgeIndex];
+            appendFormat(output, "%s{\"start\": %u, \"kind\": \"%s\"}", edgeIndex == 0 ? "" : ", ", blocks[edge.targetBlock].start, getEdgeKindName(edge.kind));
+        }
+        output.append("]}");
+    }
+    output.append("\n  ]\n}\n");
+}
+
+const char *ControlFlowGraph::getEntryKindName(EntryKind kind) {
+    switch (kind) {
+    case EntryKind::Reset:
+        return "reset";
+    case EntryKind::Irq:
+        return "irq";
+    case EntryKind::Nmi:
+        return "nmi";
+    case EntryKind::Custom:
+        return "custom";
+    default:
+        UNREACHABLE_CODE();
+    }
+}
+
+const char *ControlFlowGraph::getEdgeKindName(EdgeKind kind) {
+    switch (kind) {
+    case EdgeKind::Fallthrough:
+        return "fallthrough";
+    case EdgeKind::Branch:
+        return "branch";
+    case EdgeKind::Jump:
+        return "jump";
+    case EdgeKind::Call:
+        return "call";
+    case EdgeKind::Return:
+        return "return";
+    case EdgeKind::Interrupt:
+        return "interrupt";
+    default:
+        UNREACHABLE_CODE();
+    }
+}
+
+const char *ControlFlowGraph::getTerminatorName(Terminator terminator) {
+    switch (terminator) {
+    case Terminator::Fallthrough:
+        return "fallthrough";
+    case Terminator::Branch:
+        return "branch";
+    case Terminator::Jump:
+        return "jump";
+    case Terminator::IndirectJump:
+        return "indirect_jump";
+    case Terminator::Call:
+        return "call";
+    case Terminator::Return:
+        return "return";
+    case Terminator::ReturnFromInterrupt:
+        return "return_from_interrupt";
+    case Terminator::Interrupt:
+        return "interrupt";
+    case Terminator::InvalidOpCode:
+        return "invalid_opcode";
+    default:
+        UNREACHABLE_CODE();
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "src/memory.h"
+#include "src/symbol_table.h"
+
+#include <string>
+#include <vector>
+
+// Control flow graph recovered statically from a memory image. Code is disassembled recursively from the
+// entry points, following branches, jumps, subroutine calls and BRK, so data between code is never decoded
+// as instructions. Instructions are divided into basic blocks, which start at every entry point and jump
+// target and at every instruction following a branch or a call.
+//
+// Subroutines are assumed to return to the instruction after JSR. Every RTS gets a return edge to each
+// return site of the subroutines it can be reached from without going through another call. Targets of
+// indirect jumps are not known statically, so blocks ending with them have no successors. Invalid opcodes
+// end the block as well.
+//
+// Instruction metadata is taken from the processor, so opcodes supported by the processor are the only ones
+// treated as code.
+class ControlFlowGraph {
+public:
+    static constexpr u32 invalidBlock = 0xFFFFFFFF;
+
+    enum class EntryKind : u8 {
+        Reset,
+        Irq,
+        Nmi,
+        Custom,
+    };
+
+    enum class EdgeKind : u8 {
+        Fallthrough,
+        Branch, // taken conditional branch
+        Jump,
+        Call,
+        Return,
+        Interrupt, // BRK to the IRQ handler
+    };
+
+    enum class Terminator : u8 {
+        Fallthrough, // block ends, because the next instruction starts another block
+        Branch,
+        Jump,
+        IndirectJump,
+        Call,
+        Return,
+        ReturnFromInterrupt,
+        Interrupt,
+        InvalidOpCode,
+    };
+
+    struct EntryPoint {
+        u16 address;
+        EntryKind kind;
+    };
+
+    struct Edge {
+        u32 targetBlock;
+        EdgeKind kind;
+    };
+
+    struct BasicBlock {
+        u16 start;
+        u32 end; // address after the last instruction, can be past the memory for code wrapping around
+        u16 lastInstruction;
+        u32 instructionsCount;
+        Terminator terminator;
+        u32 firstEdge; // successors are stored contiguously in the edges vector
+        u32 edgesCount;
+    };
+
+    void addEntryPoint(u16 address, EntryKind kind = EntryKind::Custom);
+    void addVectorEntryPoints(const Memory &memory); // reset, IRQ and NMI vectors
+    void build(const Memory &memory);
+
+    const std::vector<EntryPoint> &getEntryPoints() const { return entryPoints; }
+    const std::vector<BasicBlock> &getBlocks() const { return blocks; } // sorted by start address
+    const std::vector<Edge> &getEdges() const { return edges; }
+    const Edge *getSuccessors(const BasicBlock &block) const { return edges.data() + block.firstEdge; }
+    u32 findBlock(u16 start) const; // invalidBlock, if no block starts at the address
+
+    // Graph is appended to the output. Symbols are optional and are used to name the blocks.
+    void writeDot(const Memory &memory, const SymbolTable *symbols, std::string &output) const;
+    void writeJson(const SymbolTable *symbols, std::string &output) const;
+
+    static const char *getEntryKindName(EntryKind kind);
+    static const char *getEdgeKindName(EdgeKind kind);
+    static const char *getTerminatorName(Terminator terminator);
+
+private:
+    struct PendingEdge {
+        u16 sourceInstruction;
+        u16 target;
+        EdgeKind kind;
+    };
+
+    void discoverInstructions(const Memory &memory);
+    void createBlocks(const Memory &memory);
+    void connectBlocks();
+    void addReturnEdges(std::vector<std::vector<Edge>> &successors) const;
+
+    std::vector<EntryPoint> entryPoints = {};
+    std::vector<BasicBlock> blocks = {};
+    std::vector<Edge> edges = {};
+
+    // State of the analysis, indexed by address
+    std::vector<bool> isInstruction = {};
+    std::vector<bool> isBlockStart = {};
+    std::vector<PendingEdge> pendingEdges = {};
+};
@@ -6,4 +6,5 @@
 struct Counters {
     u32 bytesProcessed = 0;
     u32 cyclesProcessed = 0;
+    u32 instructionsProcessed = 0;
 };
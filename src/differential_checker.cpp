@@ -0,0 +1,137 @@
+#include "differential_checker.h"
+
+#include "src/error.h"
+
+#include <algorithm>
+
+bool LockstepExecutionEngine::executeInstructions(u32 instructionCount) {
+    engine.executeInstructions(instructionCount);
+    return !engine.isLaneFaulted(lane);
+}
+
+DifferentialChecker::DifferentialChecker(ExecutionEngine &reference, ExecutionEngine &tested, u32 batchSize)
+    : reference(reference),
+      tested(tested),
+      batchSize(batchSize) {
+    FATAL_ERROR_IF(batchSize == 0, "Batch size cannot be 0");
+}
+
+DifferentialChecker::Result DifferentialChecker::executeInstructions(u32 instructionCount) {
+    while (result == Result::Match && instructionCount > 0) {
+        const u32 currentBatchSize = std::min(instructionCount, batchSize);
+        result = batchSize == 1 ? executeStep() : executeBatch(currentBatchSize);
+        instructionCount -= currentBatchSize;
+    }
+    return result;
+}
+
+DifferentialChecker::Result DifferentialChecker::executeBatch(u32 instructionCount) {
+    ProcessorState referenceStartState = reference.saveState();
+    ProcessorState testedStartState = tested.saveState();
+
+    // Tested engine executes exactly as many instructions as the reference engine did.
+    const bool referenceSucceeded = execute(reference, instructionCount);
+    ProcessorState referenceEndState = reference.saveState();
+    const u32 executedCount = referenceEndState.counters.instructionsProcessed - referenceStartState.counters.instructionsProcessed;
+    const bool testedSucceeded = executedCount == 0 || execute(tested, executedCount);
+    if (referenceSucceeded && testedSucceeded) {
+        ProcessorState testedEndState = tested.saveState();
+        if (compareStates(referenceEndState, testedEndState, nullptr)) {
+            return Result::Match;
+        }
+    }
+
+    // Something went wrong in this batch. Execute it again, one instruction at a time.
+    reference.restoreState(referenceStartState);
+    tested.restoreState(testedStartState);
+    for (u32 instructionIndex = 0; instructionIndex < instructionCount; instructionIndex++) {
+        const Result stepResult = executeStep();
+        if (stepResult != Result::Match) {
+            return stepResult;
+        }
+    }
+
+    divergence = {};
+    divergence.instructionIndex = referenceStartState.counters.instructionsProcessed;
+    divergence.pc = referenceStartState.regs.pc;
+    divergence.opCode = referenceStartState.memory.read(divergence.pc);
+    divergence.description = "States differed after the batch, but not when executing one instruction at a time\n";
+    return Result::Divergence;
+}
+
+DifferentialChecker::Result DifferentialChecker::executeStep() {
+    ProcessorState referenceStartState = reference.saveState();
+    divergence = {};
+    divergence.instructionIndex = referenceStartState.counters.instructionsProcessed;
+    divergence.pc = referenceStartState.regs.pc;
+    divergence.opCode = referenceStartState.memory.read(divergence.pc);
+
+    const bool referenceSucceeded = execute(reference, 1);
+    const bool testedSucceeded = execute(tested, 1);
+    if (!referenceSucceeded && !testedSucceeded) {
+        divergence.description = "Both engines raised an error\n";
+        return Result::Fault;
+    }
+    if (!referenceSucceeded) {
+        divergence.description = "Reference engine raised an error\n";
+        return Result::Divergence;
+    }
+    if (!testedSucceeded) {
+        divergence.description = "Tested engine raised an error\n";
+        return Result::Divergence;
+    }
+
+    ProcessorState referenceEndState = reference.saveState();
+    ProcessorState testedEndState = tested.saveState();
+    if (compareStates(referenceEndState, testedEndState, &divergence.description)) {
+        return Result::Match;
+    }
+    return Result::Divergence;
+}
+
+bool DifferentialChecker::execute(ExecutionEngine &engine, u32 instructionCount) {
+    return engine.executeInstructions(instructionCount);
+}
+
+bool DifferentialChecker::compareStates(const ProcessorState &referenceState, const ProcessorState &testedState, std::string *outDescription) {
+    bool result = true;
+    char line[64];
+    auto compare = [&](const char *name, u32 referenceValue, u32 testedValue) {
+        if (referenceValue != testedValue) {
+            result = false;
+            if (outDescription != nullptr) {
+                snprintf(line, sizeof(line), "%s: 0x%02x != 0x%02x\n", name, referenceValue, testedValue);
+                *outDescription += line;
+            }
+        }
+    };
+
+    const Registers &referenceRegs = referenceState.regs;
+    const Registers &testedRegs = testedState.regs;
+    compare("a", referenceRegs.a, testedRegs.a);
+    compare("x", referenceRegs.x, testedRegs.x);
+    compare("y", referenceRegs.y, testedRegs.y);
+    compare("sp", referenceRegs.sp, testedRegs.sp);
+    compare("pc", referenceRegs.pc, testedRegs.pc);
+    compare("flags", referenceRegs.flags.toU8(), testedRegs.flags.toU8());
+
+    const Counters &referenceCounters = referenceState.counters;
+    const Counters &testedCounters = testedState.counters;
+    compare("bytesProcessed", referenceCounters.bytesProcessed, testedCounters.bytesProcessed);
+    compare("cyclesProcessed", referenceCounters.cyclesProcessed, testedCounters.cyclesProcessed);
+    compare("instructionsProcessed", referenceCounters.instructionsProcessed, testedCounters.instructionsProcessed);
+
+    // Compare whole memory first, which skips shared pages. Look for exact addresses only when describing the difference.
+    if (!referenceState.memory.isEqual(testedState.memory)) {
+        result = false;
+        if (outDescription != nullptr) {
+            for (u32 address = 0; address < memorySize; address++) {
+                char name[16];
+                snprintf(name, sizeof(name), "[0x%04x]", address);
+                compare(name, referenceState.memory.read(static_cast<u16>(address)), testedState.memory.read(static_cast<u16>(address)));
+            }
+        }
+    }
+
+    return result;
+}
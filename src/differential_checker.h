@@ -0,0 +1,83 @@
+#pragma once
+
+#include "src/lockstep_engine.h"
+#include "src/processor.h"
+
+#include <string>
+
+// Common interface of engines executing guest code, so they can be compared with each other. Execution
+// returns false, if the guest raised an error, including invalid opcodes.
+class ExecutionEngine {
+public:
+    virtual ~ExecutionEngine() = default;
+    virtual bool executeInstructions(u32 instructionCount) = 0;
+    virtual ProcessorState saveState() = 0;
+    virtual void restoreState(ProcessorState &state) = 0;
+};
+
+class ProcessorExecutionEngine : public ExecutionEngine {
+public:
+    explicit ProcessorExecutionEngine(Processor &processor) : processor(processor) {}
+    bool executeInstructions(u32 instructionCount) override {
+        const StopReason stopReason = processor.executeInstructions(instructionCount).stopReason;
+        return stopReason != StopReason::InvalidOpcode && stopReason != StopReason::GuestError;
+    }
+    ProcessorState saveState() override { return processor.saveState(); }
+    void restoreState(ProcessorState &state) override { processor.restoreState(state); }
+
+private:
+    Processor &processor;
+};
+
+// Exposes one lane of a LockstepEngine. All lanes are executed together, so it's best used with one lane.
+class LockstepExecutionEngine : public ExecutionEngine {
+public:
+    LockstepExecutionEngine(LockstepEngine &engine, u32 lane) : engine(engine), lane(lane) {}
+    bool executeInstructions(u32 instructionCount) override;
+    ProcessorState saveState() override { return engine.saveState(lane); }
+    void restoreState(ProcessorState &state) override { engine.restoreState(lane, state); }
+
+private:
+    LockstepEngine &engine;
+    const u32 lane;
+};
+
+// Runs two engines side by side and compares registers, counters and memory. Instructions are executed
+// in batches and compared at the end of each batch, which keeps the overhead low. When states differ, both
+// engines go back to the beginning of the batch and execute it again one instruction at a time, to find
+// the first divergent instruction. Batch size of 1 compares after every instruction.
+class DifferentialChecker {
+public:
+    enum class Result {
+        Match,      // states of both engines are the same
+        Divergence, // states differ or only one engine raised an error
+        Fault,      // both engines raised an error on the same instruction
+    };
+
+    struct Divergence {
+        u32 instructionIndex = 0;
+        u16 pc = 0;
+        u8 opCode = 0;
+        std::string description = {}; // one line for each difference
+    };
+
+    DifferentialChecker(ExecutionEngine &reference, ExecutionEngine &tested, u32 batchSize);
+
+    // Executes given number of instructions on both engines. After a divergence or a fault, engines stay
+    // in the state right after the offending instruction and the same result is returned on all subsequent calls.
+    Result executeInstructions(u32 instructionCount);
+
+    const Divergence &getDivergence() const { return divergence; }
+
+private:
+    Result executeBatch(u32 instructionCount);
+    Result executeStep();
+    static bool execute(ExecutionEngine &engine, u32 instructionCount);
+    static bool compareStates(const ProcessorState &referenceState, const ProcessorState &testedState, std::string *outDescription);
+
+    ExecutionEngine &reference;
+    ExecutionEngine &tested;
+    const u32 batchSize;
+    Result result = Result::Match;
+    Divergence divergence = {};
+};
@@ -0,0 +1,232 @@
+#include "disassembler.h"
+
+#include "src/error.h"
+#include "src/processor.h"
+
+#include <array>
+#include <cstring>
+
+namespace {
+enum class OperandType : u8 {
+    None,
+    Immediate,
+    ZeroPage,
+    Absolute,
+    Relative,
+    OpCode, // unsupported opcodes are rendered as data
+};
+
+struct InstructionFormat {
+    char prefix[8] = {}; // mnemonic and everything before the operand, e.g. "LDA ("
+    u8 prefixLength = 0;
+    char suffix[4] = {}; // e.g. ",X)"
+    u8 suffixLength = 0;
+    OperandType operandType = OperandType::None;
+    u8 size = 1;
+};
+
+InstructionFormat createInstructionFormat(u8 opCode) {
+    InstructionFormat format{};
+    const char *mnemonic = Processor::getMnemonic(opCode);
+    const char *prefix = " ";
+    const char *suffix = "";
+    if (mnemonic == nullptr) {
+        mnemonic = ".byte";
+        format.operandType = OperandType::OpCode;
+    } else {
+        switch (Processor::getAddressingMode(opCode)) {
+        case AddressingMode::Accumulator:
+            prefix = " A";
+            break;
+        case AddressingMode::Implied:
+            prefix = "";
+            break;
+        case AddressingMode::Immediate:
+            prefix = " #";
+            format.operandType = OperandType::Immediate;
+            break;
+        case AddressingMode::ZeroPage:
+            format.operandType = OperandType::ZeroPage;
+            break;
+        case AddressingMode::ZeroPageX:
+            suffix = ",X";
+            format.operandType = OperandType::ZeroPage;
+            break;
+        case AddressingMode::ZeroPageY:
+            suffix = ",Y";
+            format.operandType = OperandType::ZeroPage;
+            break;
+        case AddressingMode::Absolute:
+            format.operandType = OperandType::Absolute;
+            break;
+        case AddressingMode::AbsoluteX:
+            suffix = ",X";
+            format.operandType = OperandType::Absolute;
+            break;
+        case AddressingMode::AbsoluteY:
+            suffix = ",Y";
+            format.operandType = OperandType::Absolute;
+            break;
+        case AddressingMode::IndexedIndirectX:
+            prefix = " (";
+            suffix = ",X)";
+            format.operandType = OperandType::ZeroPage;
+            break;
+        case AddressingMode::IndirectIndexedY:
+            prefix = " (";
+            suffix = "),Y";
+            format.operandType = OperandType::ZeroPage;
+            break;
+        case AddressingMode::Indirect:
+            prefix = " (";
+            suffix = ")";
+            format.operandType = OperandType::Absolute;
+            break;
+        case AddressingMode::Relative:
+            format.operandType = OperandType::Relative;
+            break;
+        default:
+            UNREACHABLE_CODE();
+        }
+    }
+
+    format.prefixLength = static_cast<u8>(snprintf(format.prefix, sizeof(format.prefix), "%s%s", mnemonic, prefix));
+    format.suffixLength = static_cast<u8>(snprintf(format.suffix, sizeof(format.suffix), "%s", suffix));
+    switch (format.operandType) {
+    case OperandType::Immediate:
+    case OperandType::ZeroPage:
+    case OperandType::Relative:
+        format.size = 2;
+        break;
+    case OperandType::Absolute:
+        format.size = 3;
+        break;
+    default:
+        format.size = 1;
+        break;
+    }
+    return format;
+}
+
+const std::array<InstructionFormat, 256> &getInstructionFormats() {
+    static const std::array<InstructionFormat, 256> formats = []() {
+        std::array<InstructionFormat, 256> result{};
+        for (u32 opCode = 0; opCode < result.size(); opCode++) {
+            result[opCode] = createInstructionFormat(static_cast<u8>(opCode));
+        }
+        return result;
+    }();
+    return formats;
+}
+} // namespace
+
+Disassembler::Disassembler(const SymbolTable *symbols) : symbols(symbols) {
+    getInstructionFormats();
+}
+
+u32 Disassembler::getInstructionSize(u8 opCode) {
+    return getInstructionFormats()[opCode].size;
+}
+
+std::string_view Disassembler::disassembleInstruction(u16 address, const u8 *bytes, u32 *outSize) {
+    output.clear();
+    appendInstruction(address, bytes);
+    if (outSize != nullptr) {
+        *outSize = getInstructionSize(bytes[0]);
+    }
+    return output;
+}
+
+std::string_view Disassembler::disassembleRange(const Memory &memory, u16 start, u32 size) {
+    FATAL_ERROR_IF(start + size > memorySize, "Disassembled range out of memory bounds");
+
+    // Lines have about 24 characters and the average instruction has 2 bytes
+    output.clear();
+    output.reserve(size * 12);
+
+    for (u32 offset = 0; offset < size;) {
+        const u16 address = static_cast<u16>(start + offset);
+        const u8 bytes[maxInstructionSize] = {
+            memory.read(address),
+            memory.read(static_cast<u16>(address + 1)),
+            memory.read(static_cast<u16>(address + 2)),
+        };
+        const u32 instructionSize = getInstructionFormats()[bytes[0]].size;
+
+        u16 labelOffset = 0;
+        const char *label = symbols != nullptr ? symbols->findLabel(address, labelOffset) : nullptr;
+        if (label != nullptr && labelOffset == 0) {
+            output.append(label);
+            output.append(":\n");
+        }
+
+        // Address and bytes are followed by the instruction in a fixed column
+        appendHex(address, 4);
+        output.append("  ");
+        for (u32 i = 0; i < maxInstructionSize; i++) {
+            if (i < instructionSize) {
+                appendHex(bytes[i], 2);
+                output.push_back(' ');
+            } else {
+                output.append("   ");
+            }
+        }
+        output.push_back(' ');
+        appendInstruction(address, bytes);
+        output.push_back('\n');
+
+        offset += instructionSize;
+    }
+    return output;
+}
+
+void Disassembler::appendInstruction(u16 address, const u8 *bytes) {
+    const InstructionFormat &format = getInstructionFormats()[bytes[0]];
+    output.append(format.prefix, format.prefixLength);
+    switch (format.operandType) {
+    case OperandType::None:
+        break;
+    case OperandType::Immediate:
+        output.push_back('$');
+        appendHex(bytes[1], 2);
+        break;
+    case OperandType::ZeroPage:
+        appendAddress(bytes[1], true);
+        break;
+    case OperandType::Absolute:
+        appendAddress(static_cast<u16>(bytes[1] | bytes[2] << 8), false);
+        break;
+    case OperandType::Relative:
+        appendAddress(static_cast<u16>(address + 2 + static_cast<i8>(bytes[1])), false);
+        break;
+    case OperandType::OpCode:
+        output.push_back('$');
+        appendHex(bytes[0], 2);
+        break;
+    default:
+        UNREACHABLE_CODE();
+    }
+    output.append(format.suffix, format.suffixLength);
+}
+
+void Disassembler::appendAddress(u16 address, bool isZeroPage) {
+    if (symbols != nullptr) {
+        u16 offset = 0;
+        const char *label = symbols->findLabel(address, offset);
+        if (label != nullptr && offset == 0) {
+            output.append(label);
+            return;
+        }
+    }
+    output.push_back('$');
+    appendHex(address, isZeroPage ? 2 : 4);
+}
+
+void Disassembler::appendHex(u32 value, u32 digitsCount) {
+    static const char digits[] = "0123456789abcdef";
+    char text[8];
+    for (u32 i = 0; i < digitsCount; i++) {
+        text[digitsCount - 1 - i] = digits[(value >> (i * 4)) & 0xF];
+    }
+    output.append(text, digitsCount);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "src/memory.h"
+#include "src/symbol_table.h"
+
+#include <string>
+#include <string_view>
+
+// Renders 6502 instructions as text, for example "LDA ($42),Y", "JSR start" or "BNE $0410". Text around
+// the operand, operand size and the way it's printed are precomputed once for every opcode, so rendering
+// an instruction is a table lookup and a few appends to an output buffer, which is reused between calls.
+// Unsupported opcodes are rendered as ".byte $xx".
+//
+// Operands, which are addresses, are replaced by the name of a label at exactly that address, if there
+// is a symbol table. Branch operands are rendered as their target addresses.
+class Disassembler {
+public:
+    static constexpr u32 maxInstructionSize = 3;
+
+    explicit Disassembler(const SymbolTable *symbols = nullptr); // symbols are owned by the caller
+    void setSymbols(const SymbolTable *newSymbols) { symbols = newSymbols; }
+
+    static u32 getInstructionSize(u8 opCode);
+
+    // Renders one instruction. Bytes must contain the whole instruction. Returned text is valid until the
+    // next call.
+    std::string_view disassembleInstruction(u16 address, const u8 *bytes, u32 *outSize = nullptr);
+
+    // Renders all instructions starting in the range as lines of "0400  a9 42     LDA #$42", preceded by
+    // "start:" lines for labels. Returned text is valid until the next call.
+    std::string_view disassembleRange(const Memory &memory, u16 start, u32 size);
+
+private:
+    void appendInstruction(u16 address, const u8 *bytes);
+    void appendAddress(u16 address, bool isZeroPage);
+    void appendHex(u32 value, u32 digitsCount);
+
+    const SymbolTable *symbols;
+    std::string output = {};
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "src/types.h"
+
+// AFL-style edge coverage. Every control flow instruction reports the address it transferred the control to.
+// An edge is identified by hashing current destination with the previous one and its hit counter is incremented
+// in a bitmap. The bitmap is owned by the caller, so it can be shared between processors, or with an external fuzzer.
+class EdgeCoverage {
+public:
+    constexpr static u32 mapSize = 64 * 1024;
+
+    void setMap(u8 *newMap) {
+        map = newMap;
+        previousLocation = 0;
+    }
+
+    void resetPreviousLocation() {
+        previousLocation = 0;
+    }
+
+    void edge(u16 destination) {
+        // Multiplicative hash spreads consecutive addresses over the map. Shifting previous location makes A->B
+        // and B->A different edges.
+        const u16 location = static_cast<u16>(destination * 40503u);
+        map[location ^ previousLocation]++;
+        previousLocation = location >> 1;
+    }
+
+private:
+    u8 *map = nullptr;
+    u16 previousLocation = 0;
+};
@@ -0,0 +1,14 @@
+#include "error.h"
+
+#include <cstdlib>
+#include <exception>
+
+namespace Error {
+void abort() {
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+    throw std::exception{};
+#else
+    std::abort();
+#endif
+}
+} // namespace Error
@@ -2,7 +2,6 @@
 
 #include <cstdarg>
 #include <cstdio>
-#include <exception>
 
 namespace Error {
 inline void log(FILE *file, const char *label, const char *format, ...) {
@@ -18,9 +17,8 @@ inline void log(FILE *file, const char *label, const char *format, ...) {
     fprintf(file, "\n");
 }
 
-[[noreturn]] inline void abort() {
-    throw std::exception{};
-}
+// Throws std::exception, or terminates the process, if emos_lib is compiled without exceptions
+[[noreturn]] void abort();
 } // namespace Error
 
 #define INFO(...)                                 \
@@ -42,3 +40,20 @@ inline void log(FILE *file, const char *label, const char *format, ...) {
     } while (0)
 
 #define UNREACHABLE_CODE() FATAL_ERROR("Unreachable code")
+
+// Internal invariants, which cannot be broken by the guest program. They are checked only in debug builds.
+// Release builds drop the checks and do not evaluate the conditions, so they cost nothing in the hot loop.
+// Only unreachable code is passed to the compiler as an assumption.
+#ifdef NDEBUG
+#define DEBUG_ASSERT(condition, ...) \
+    do {                             \
+    } while (0)
+#if defined(_MSC_VER)
+#define DEBUG_UNREACHABLE_CODE(...) __assume(0)
+#else
+#define DEBUG_UNREACHABLE_CODE(...) __builtin_unreachable()
+#endif
+#else
+#define DEBUG_ASSERT(condition, ...) FATAL_ERROR_IF(!(condition), __VA_ARGS__)
+#define DEBUG_UNREACHABLE_CODE(...) FATAL_ERROR(__VA_ARGS__)
+#endif
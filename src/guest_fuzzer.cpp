@@ -0,0 +1,48 @@
+#include "guest_fuzzer.h"
+
+#include "src/bit_operations.h"
+#include "src/error.h"
+
+#include <algorithm>
+#include <cstring>
+
+GuestFuzzer::GuestFuzzer(Processor &processor, const Configuration &configuration, u8 *coverageMap)
+    : processor(processor),
+      configuration(configuration),
+      coverageMap(coverageMap) {
+    FATAL_ERROR_IF(configuration.instructionBudget == 0, "Instruction budget cannot be 0");
+    FATAL_ERROR_IF(configuration.inputAddress + configuration.maxInputSize > memorySize, "Input region out of memory bounds");
+    FATAL_ERROR_IF(configuration.inputSizeAddress + 2u > memorySize, "Input size out of memory bounds");
+
+    if (this->coverageMap == nullptr) {
+        ownCoverageMap.resize(EdgeCoverage::mapSize);
+        this->coverageMap = ownCoverageMap.data();
+    }
+
+    processor.activateHangDetector();
+    processor.activateEdgeCoverage(this->coverageMap);
+    initialState = processor.saveState();
+}
+
+GuestFuzzer::Result GuestFuzzer::run(const u8 *input, size_t inputSize) {
+    const u16 size = static_cast<u16>(std::min<size_t>(inputSize, configuration.maxInputSize));
+    const u8 sizeBytes[] = {lo(size), hi(size)};
+    processor.restoreState(initialState);
+    processor.loadMemory(configuration.inputAddress, size, input);
+    processor.loadMemory(configuration.inputSizeAddress, sizeof(sizeBytes), sizeBytes);
+
+    const ExecutionResult result = processor.executeInstructions(configuration.instructionBudget);
+    stopAddress = result.pc;
+    switch (result.stopReason) {
+    case StopReason::BudgetExhausted:
+        return Result::Timeout;
+    case StopReason::Hang:
+        return stopAddress == configuration.successAddress ? Result::Success : Result::Hang;
+    default:
+        return Result::Crash;
+    }
+}
+
+void GuestFuzzer::clearCoverageMap() {
+    memset(coverageMap, 0, EdgeCoverage::mapSize);
+}
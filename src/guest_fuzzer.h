@@ -0,0 +1,46 @@
+#pragma once
+
+#include "src/processor.h"
+
+#include <vector>
+
+// Harness for fuzzing guest programs in persistent mode. State of the processor is captured once and every
+// input is executed from that state. Restoring it only remaps memory pages, which were shared with the saved
+// state, so the cost of an execution depends on how many pages the guest writes, not on the memory size.
+// The input is copied to a memory region and its length is stored as a 16-bit value for the guest to read.
+// Execution ends when the guest hangs, for example in an infinite loop at the end of the program.
+class GuestFuzzer {
+public:
+    struct Configuration {
+        u16 inputAddress = 0;
+        u16 inputSizeAddress = 0;
+        u16 maxInputSize = 0;
+        u16 successAddress = 0;    // hang address meaning, that the input was processed correctly
+        u32 instructionBudget = 0; // maximum number of instructions per input
+    };
+
+    enum class Result {
+        Success, // guest hanged at success address
+        Hang,    // guest hanged at other address
+        Timeout, // instruction budget was exhausted
+        Crash,   // guest executed an invalid instruction
+    };
+
+    // Uses current state of the processor as the initial state for all inputs. Coverage map may be shared
+    // with other fuzzers, otherwise the fuzzer allocates its own one.
+    GuestFuzzer(Processor &processor, const Configuration &configuration, u8 *coverageMap = nullptr);
+
+    Result run(const u8 *input, size_t inputSize);
+
+    u8 *getCoverageMap() { return coverageMap; }
+    void clearCoverageMap();
+    u16 getStopAddress() const { return stopAddress; }
+
+private:
+    Processor &processor;
+    const Configuration configuration;
+    ProcessorState initialState;
+    std::vector<u8> ownCoverageMap = {};
+    u8 *coverageMap = nullptr;
+    u16 stopAddress = 0;
+};
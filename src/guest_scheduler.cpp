@@ -0,0 +1,130 @@
+#include "guest_scheduler.h"
+
+#include "src/error.h"
+
+GuestScheduler::GuestScheduler(u32 threadsCount, u32 cycleQuantum)
+    : cycleQuantum(cycleQuantum),
+      threadPool(threadsCount) {
+    FATAL_ERROR_IF(cycleQuantum == 0, "Cycle quantum cannot be 0");
+}
+
+GuestScheduler::~GuestScheduler() {
+    stop();
+}
+
+GuestScheduler::GuestId GuestScheduler::addGuest(Processor &processor) {
+    FATAL_ERROR_IF(running, "Cannot add guests to a running scheduler");
+    auto guest = std::make_unique<Guest>();
+    guest->processor = &processor;
+    guests.push_back(std::move(guest));
+    return static_cast<GuestId>(guests.size() - 1);
+}
+
+void GuestScheduler::setThrottle(GuestId guestId, u32 cyclesPerSecond) {
+    FATAL_ERROR_IF(running, "Cannot throttle guests in a running scheduler");
+    guests.at(guestId)->cyclesPerSecond = cyclesPerSecond;
+}
+
+void GuestScheduler::start() {
+    FATAL_ERROR_IF(running, "Scheduler is already running");
+    running = true;
+    timerThread = std::thread{&GuestScheduler::timerLoop, this};
+
+    // Throttling is measured from the start, so time spent stopped does not have to be caught up.
+    const Clock::time_point now = Clock::now();
+    for (auto &guest : guests) {
+        if (guest->finished) {
+            continue;
+        }
+        guest->throttleStartTime = now;
+        guest->throttleStartCycles = guest->cyclesExecuted;
+        threadPool.submitLast([this, guestPtr = guest.get()]() { runQuantum(*guestPtr); });
+    }
+}
+
+void GuestScheduler::stop() {
+    if (!running) {
+        return;
+    }
+
+    // Running guests will notice the flag after their quantum and will not be scheduled again. Parked
+    // guests are dropped by the timer thread.
+    {
+        std::lock_guard<std::mutex> lock{timerMutex};
+        running = false;
+    }
+    timerCondition.notify_all();
+    timerThread.join();
+    threadPool.waitForIdle();
+    parkedGuests = {};
+}
+
+GuestScheduler::GuestStatistics GuestScheduler::getStatistics(GuestId guestId) const {
+    const Guest &guest = *guests.at(guestId);
+    GuestStatistics result{};
+    result.cyclesExecuted = guest.cyclesExecuted;
+    result.quantaExecuted = guest.quantaExecuted;
+    result.timesThrottled = guest.timesThrottled;
+    result.finished = guest.finished;
+    return result;
+}
+
+void GuestScheduler::runQuantum(Guest &guest) {
+    if (!running) {
+        return;
+    }
+
+    Processor &processor = *guest.processor;
+    const u32 startCycles = processor.getCounters().cyclesProcessed;
+    const bool finished = !processor.executeCycles(cycleQuantum);
+    guest.cyclesExecuted += processor.getCounters().cyclesProcessed - startCycles; // u32 arithmetic handles wraparound
+    guest.quantaExecuted++;
+
+    if (finished) {
+        guest.finished = true;
+        return;
+    }
+    schedule(guest);
+}
+
+void GuestScheduler::schedule(Guest &guest) {
+    if (!running) {
+        return;
+    }
+
+    if (guest.cyclesPerSecond != 0) {
+        const u64 cycles = guest.cyclesExecuted - guest.throttleStartCycles;
+        const auto emulatedTime = std::chrono::nanoseconds(cycles * 1'000'000'000 / guest.cyclesPerSecond);
+        const Clock::time_point wakeUpTime = guest.throttleStartTime + std::chrono::duration_cast<Clock::duration>(emulatedTime);
+        if (wakeUpTime > Clock::now()) {
+            guest.timesThrottled++;
+            {
+                std::lock_guard<std::mutex> lock{timerMutex};
+                parkedGuests.push(ParkedGuest{wakeUpTime, &guest});
+            }
+            timerCondition.notify_one();
+            return;
+        }
+    }
+
+    threadPool.submitLast([this, &guest]() { runQuantum(guest); });
+}
+
+void GuestScheduler::timerLoop() {
+    std::unique_lock<std::mutex> lock{timerMutex};
+    while (running) {
+        if (parkedGuests.empty()) {
+            timerCondition.wait(lock);
+            continue;
+        }
+
+        const ParkedGuest parkedGuest = parkedGuests.top();
+        if (parkedGuest.wakeUpTime > Clock::now()) {
+            timerCondition.wait_until(lock, parkedGuest.wakeUpTime);
+            continue;
+        }
+
+        parkedGuests.pop();
+        threadPool.submitLast([this, guest = parkedGuest.guest]() { runQuantum(*guest); });
+    }
+}
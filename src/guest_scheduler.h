@@ -0,0 +1,80 @@
+#pragma once
+
+#include "src/processor.h"
+#include "src/work_stealing_thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Scheduler for many long-running guests sharing a few host threads. Each guest runs for a quantum of cycles
+// and is then put back at the end of the run queue of its worker thread. Idle workers steal guests from other
+// queues. Guests can be throttled to a given emulated frequency. Throttled guests, which are ahead of the wall
+// clock, are parked by a timer thread instead of occupying workers.
+class GuestScheduler {
+public:
+    using GuestId = u32;
+
+    struct GuestStatistics {
+        u64 cyclesExecuted = 0;
+        u64 quantaExecuted = 0;
+        u64 timesThrottled = 0;
+        bool finished = false; // guest hung or reported an error
+    };
+
+    GuestScheduler(u32 threadsCount, u32 cycleQuantum);
+    ~GuestScheduler();
+    GuestScheduler(const GuestScheduler &) = delete;
+    GuestScheduler &operator=(const GuestScheduler &) = delete;
+
+    // Guests can only be added and throttled while the scheduler is stopped.
+    GuestId addGuest(Processor &processor);
+    void setThrottle(GuestId guestId, u32 cyclesPerSecond); // 0 means no throttling
+
+    // Guests are stopped at quantum boundaries, so they can be inspected and started again.
+    void start();
+    void stop();
+
+    GuestStatistics getStatistics(GuestId guestId) const;
+    u32 getGuestsCount() const { return static_cast<u32>(guests.size()); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Guest {
+        Processor *processor = nullptr;
+        u32 cyclesPerSecond = 0;
+        Clock::time_point throttleStartTime = {};
+        u64 throttleStartCycles = 0;
+
+        std::atomic_uint64_t cyclesExecuted = 0;
+        std::atomic_uint64_t quantaExecuted = 0;
+        std::atomic_uint64_t timesThrottled = 0;
+        std::atomic_bool finished = false;
+    };
+
+    struct ParkedGuest {
+        Clock::time_point wakeUpTime;
+        Guest *guest;
+        bool operator>(const ParkedGuest &other) const { return wakeUpTime > other.wakeUpTime; }
+    };
+
+    void runQuantum(Guest &guest);
+    void schedule(Guest &guest);
+    void timerLoop();
+
+    const u32 cycleQuantum;
+    std::vector<std::unique_ptr<Guest>> guests = {};
+    WorkStealingThreadPool threadPool;
+    std::atomic_bool running = false;
+
+    std::mutex timerMutex = {};
+    std::condition_variable timerCondition = {};
+    std::priority_queue<ParkedGuest, std::vector<ParkedGuest>, std::greater<ParkedGuest>> parkedGuests = {};
+    std::thread timerThread = {};
+};
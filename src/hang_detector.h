@@ -22,6 +22,10 @@ public:
         hangAddress = snapshots[0].pc;
     }
 
+    void reset() {
+        *this = {};
+    }
+
     bool isHangDetected() const { return hangDetected; }
     u16 getHangAddress() const { return hangAddress; }
 
@@ -0,0 +1,18 @@
+#include "host_counters.h"
+
+#include "src/error.h"
+
+const char *HostCounters::getEventName(HostEvent event) {
+    switch (event) {
+    case HostEvent::Instructions:
+        return "instructions";
+    case HostEvent::Cycles:
+        return "cycles";
+    case HostEvent::BranchMisses:
+        return "branch misses";
+    case HostEvent::L1DataMisses:
+        return "L1D misses";
+    default:
+        UNREACHABLE_CODE();
+    }
+}
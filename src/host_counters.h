@@ -0,0 +1,43 @@
+#pragma once
+
+#include "src/types.h"
+
+// Hardware events of the host CPU, which are counted around the emulation.
+enum class HostEvent {
+    Instructions,
+    Cycles,
+    BranchMisses,
+    L1DataMisses,
+    COUNT,
+};
+
+struct HostCounterValues {
+    static constexpr u32 eventsCount = static_cast<u32>(HostEvent::COUNT);
+    u64 values[eventsCount] = {};
+
+    u64 &operator[](HostEvent event) { return values[static_cast<u32>(event)]; }
+    u64 operator[](HostEvent event) const { return values[static_cast<u32>(event)]; }
+};
+
+// Hardware performance counters of the host CPU, counting only the calling thread in user mode. They are
+// implemented with perf_event_open on Linux and are not available on other systems, nor on machines without
+// a PMU exposed, which is common in virtual machines and containers. Events, which could not be opened, read
+// as zero. Counters are started in the constructor and never stopped, so values have to be subtracted.
+class HostCounters {
+public:
+    HostCounters();
+    ~HostCounters();
+    HostCounters(const HostCounters &) = delete;
+    HostCounters &operator=(const HostCounters &) = delete;
+
+    bool isAvailable() const { return groupFileDescriptor != -1; }
+    bool isEventAvailable(HostEvent event) const { return eventIndices[static_cast<u32>(event)] != -1; }
+    HostCounterValues read() const;
+
+    static const char *getEventName(HostEvent event);
+
+private:
+    int groupFileDescriptor = -1;
+    int fileDescriptors[HostCounterValues::eventsCount] = {-1, -1, -1, -1};
+    int eventIndices[HostCounterValues::eventsCount] = {-1, -1, -1, -1}; // position of the event in the group
+};
@@ -0,0 +1,104 @@
+#include "host_profiler.h"
+
+#include "src/error.h"
+#include "src/processor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+HostProfiler::HostProfiler(bool perOpCode) : perOpCode(perOpCode) {
+    if (perOpCode) {
+        calibrate();
+    }
+}
+
+void HostProfiler::calibrate() {
+    // Minimum is taken, because a measurement may be disturbed by an interrupt, but never made cheaper
+    constexpr u32 samplesCount = 64;
+    for (u64 &value : measurementOverhead.values) {
+        value = UINT64_MAX;
+    }
+    for (u32 sample = 0; sample < samplesCount; sample++) {
+        const HostCounterValues start = counters.read();
+        const HostCounterValues end = counters.read();
+        for (u32 eventIndex = 0; eventIndex < HostCounterValues::eventsCount; eventIndex++) {
+            measurementOverhead.values[eventIndex] = std::min(measurementOverhead.values[eventIndex], end.values[eventIndex] - start.values[eventIndex]);
+        }
+    }
+}
+
+void HostProfiler::reset() {
+    total = {};
+    emulatedInstructions = 0;
+    std::fill(std::begin(opCodeValues), std::end(opCodeValues), HostCounterValues{});
+    std::fill(std::begin(opCodeInstructions), std::end(opCodeInstructions), 0);
+}
+
+void HostProfiler::endExecution(u32 executedInstructions) {
+    const HostCounterValues end = counters.read();
+    for (u32 eventIndex = 0; eventIndex < HostCounterValues::eventsCount; eventIndex++) {
+        total.values[eventIndex] += end.values[eventIndex] - executionStart.values[eventIndex];
+    }
+    emulatedInstructions += executedInstructions;
+}
+
+void HostProfiler::endInstruction(u8 opCode) {
+    const HostCounterValues end = counters.read();
+    HostCounterValues &values = opCodeValues[opCode];
+    for (u32 eventIndex = 0; eventIndex < HostCounterValues::eventsCount; eventIndex++) {
+        const u64 delta = end.values[eventIndex] - instructionStart.values[eventIndex];
+        const u64 overhead = measurementOverhead.values[eventIndex];
+        values.values[eventIndex] += delta > overhead ? delta - overhead : 0;
+    }
+    opCodeInstructions[opCode]++;
+}
+
+void HostProfiler::printReport() const {
+    if (!isAvailable()) {
+        INFO("Host hardware counters are not available");
+        return;
+    }
+
+    auto printValues = [this](const char *label, const HostCounterValues &values, u64 instructions) {
+        char line[128];
+        int length = snprintf(line, sizeof(line), "%-16s %12llu", label, static_cast<unsigned long long>(instructions));
+        for (u32 eventIndex = 0; eventIndex < HostCounterValues::eventsCount; eventIndex++) {
+            if (counters.isEventAvailable(static_cast<HostEvent>(eventIndex))) {
+                const double perInstruction = static_cast<double>(values.values[eventIndex]) / static_cast<double>(instructions);
+                length += snprintf(line + length, sizeof(line) - length, " %14.3f", perInstruction);
+            } else {
+                length += snprintf(line + length, sizeof(line) - length, " %14s", "-");
+            }
+        }
+        INFO("%s", line);
+    };
+
+    INFO("Host counters per emulated instruction");
+    INFO("%-16s %12s %14s %14s %14s %14s", "", "emulated", HostCounters::getEventName(HostEvent::Instructions),
+         HostCounters::getEventName(HostEvent::Cycles), HostCounters::getEventName(HostEvent::BranchMisses),
+         HostCounters::getEventName(HostEvent::L1DataMisses));
+    if (emulatedInstructions > 0) {
+        printValues("total", total, emulatedInstructions);
+    }
+    if (!perOpCode) {
+        return;
+    }
+
+    std::vector<u8> opCodes{};
+    for (u32 opCode = 0; opCode < 256; opCode++) {
+        if (opCodeInstructions[opCode] > 0) {
+            opCodes.push_back(static_cast<u8>(opCode));
+        }
+    }
+    std::sort(opCodes.begin(), opCodes.end(), [this](u8 left, u8 right) {
+        const u64 leftCycles = opCodeValues[left][HostEvent::Cycles];
+        const u64 rightCycles = opCodeValues[right][HostEvent::Cycles];
+        return leftCycles != rightCycles ? leftCycles > rightCycles : opCodeInstructions[left] > opCodeInstructions[right];
+    });
+    for (u8 opCode : opCodes) {
+        char label[16];
+        snprintf(label, sizeof(label), "%02X %s", opCode, Processor::getMnemonic(opCode));
+        printValues(label, opCodeValues[opCode], opCodeInstructions[opCode]);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "src/host_counters.h"
+
+// Collects host hardware counters spent in Processor::executeInstructions() and Processor::executeCycles(),
+// so the cost of the interpreter can be expressed per emulated instruction. Optionally counters are also
+// read around every instruction and accumulated per opcode. This shows which opcodes cause dispatch branch
+// mispredictions or cache misses, but the reads are syscalls, so they perturb the measured code. The cost of
+// an empty measurement is calibrated once and subtracted. Profiler must be used by the thread, which created it.
+class HostProfiler {
+public:
+    explicit HostProfiler(bool perOpCode);
+
+    bool isAvailable() const { return counters.isAvailable(); }
+    bool isPerOpCode() const { return perOpCode; }
+    void reset();
+
+    // Called by the processor
+    void beginExecution() { executionStart = counters.read(); }
+    void endExecution(u32 emulatedInstructions);
+    void beginInstruction() { instructionStart = counters.read(); }
+    void endInstruction(u8 opCode);
+
+    const HostCounterValues &getTotal() const { return total; }
+    u64 getEmulatedInstructions() const { return emulatedInstructions; }
+    const HostCounterValues &getOpCodeValues(u8 opCode) const { return opCodeValues[opCode]; }
+    u64 getOpCodeInstructions(u8 opCode) const { return opCodeInstructions[opCode]; }
+
+    // Prints all values divided by the number of emulated instructions. Opcodes are sorted by host cycles.
+    void printReport() const;
+
+private:
+    void calibrate();
+
+    HostCounters counters = {};
+    const bool perOpCode;
+    HostCounterValues measurementOverhead = {};
+    HostCounterValues executionStart = {};
+    HostCounterValues instructionStart = {};
+
+    HostCounterValues total = {};
+    u64 emulatedInstructions = 0;
+    HostCounterValues opCodeValues[256] = {};
+    u64 opCodeInstructions[256] = {};
+};
@@ -0,0 +1,364 @@
+#include "image_loader.h"
+
+#include "src/error.h"
+#include "src/os_memory.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace {
+// Bytes parsed from text formats are gathered in a full-sized buffer, so every run of touched bytes is copied
+// into the image only once, no matter how many records it is split into. Bytes between the runs are not a part
+// of the image, so mapping it keeps whatever the memory holds there.
+class ImageBuilder {
+public:
+    ImageBuilder() : bytes(memorySize) {}
+
+    bool write(u32 address, const u8 *data, u32 size) {
+        if (address + size > memorySize) {
+            return false;
+        }
+        memcpy(bytes.data() + address, data, size);
+        for (u32 offset = address; offset < address + size; offset++) {
+            touchedBytes[offset] = true;
+        }
+        return true;
+    }
+
+    void build(MemoryImage &outImage) const {
+        for (u32 start = 0; start < memorySize;) {
+            if (!touchedBytes[start]) {
+                start++;
+                continue;
+            }
+            u32 end = start;
+            while (end < memorySize && touchedBytes[end]) {
+                end++;
+            }
+            outImage.copy(start, end - start, bytes.data() + start);
+            start = end;
+        }
+    }
+
+private:
+    std::vector<u8> bytes;
+    std::bitset<memorySize> touchedBytes = {};
+};
+
+// Reads hexadecimal bytes from one line of a text format
+class HexLineReader {
+public:
+    HexLineReader(const char *current, const char *end) : current(current), end(end) {}
+
+    bool readByte(u8 &outByte) {
+        u8 hi = 0;
+        u8 lo = 0;
+        if (end - current < 2 || !readDigit(current[0], hi) || !readDigit(current[1], lo)) {
+            return false;
+        }
+        outByte = static_cast<u8>(hi << 4 | lo);
+        checksum += outByte;
+        current += 2;
+        return true;
+    }
+
+    bool readBytes(u8 *outBytes, u32 count) {
+        for (u32 i = 0; i < count; i++) {
+            if (!readByte(outBytes[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool readAddress(u32 bytesCount, u32 &outAddress) {
+        outAddress = 0;
+        for (u32 i = 0; i < bytesCount; i++) {
+            u8 byte = 0;
+            if (!readByte(byte)) {
+                return false;
+            }
+            outAddress = outAddress << 8 | byte;
+        }
+        return true;
+    }
+
+    bool isAtEnd() const { return current == end; }
+    u8 getChecksum() const { return checksum; } // sum of all read bytes
+
+private:
+    static bool readDigit(char character, u8 &outValue) {
+        if (character >= '0' && character <= '9') {
+            outValue = static_cast<u8>(character - '0');
+        } else if (character >= 'A' && character <= 'F') {
+            outValue = static_cast<u8>(character - 'A' + 10);
+        } else if (character >= 'a' && character <= 'f') {
+            outValue = static_cast<u8>(character - 'a' + 10);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    const char *current;
+    const char *const end;
+    u8 checksum = 0;
+};
+
+// Calls the parser for every non-empty line without the line terminator
+template <typename LineParser>
+bool forEachLine(const char *text, size_t size, LineParser &&parseLine) {
+    const char *const end = text + size;
+    while (text != end) {
+        const char *lineEnd = static_cast<const char *>(memchr(text, '\n', end - text));
+        const char *next = lineEnd == nullptr ? end : lineEnd + 1;
+        if (lineEnd == nullptr) {
+            lineEnd = end;
+        }
+        while (lineEnd != text && (lineEnd[-1] == '\r' || lineEnd[-1] == ' ' || lineEnd[-1] == '\t')) {
+            lineEnd--;
+        }
+        if (lineEnd != text && !parseLine(text, lineEnd)) {
+            return false;
+        }
+        text = next;
+    }
+    return true;
+}
+
+const char *parseIntelHex(const char *text, size_t size, LoadedImage &outImage) {
+    ImageBuilder builder{};
+    const char *error = nullptr;
+    u32 baseAddress = 0;
+    bool endOfFile = false;
+    const bool parsed = forEachLine(text, size, [&](const char *line, const char *lineEnd) {
+        if (endOfFile) {
+            return true;
+        }
+        if (*line != ':') {
+            error = "Intel HEX record must start with ':'";
+            return false;
+        }
+
+        // :LLAAAATT<data>CC, where the checksum makes the sum of all bytes zero
+        HexLineReader reader{line + 1, lineEnd};
+        u8 length = 0;
+        u32 address = 0;
+        u8 type = 0;
+        u8 data[255];
+        u8 checksum = 0;
+        if (!reader.readByte(length) || !reader.readAddress(2, address) || !reader.readByte(type) ||
+            !reader.readBytes(data, length) || !reader.readByte(checksum) || !reader.isAtEnd()) {
+            error = "Invalid Intel HEX record";
+            return false;
+        }
+        if (reader.getChecksum() != 0) {
+            error = "Invalid Intel HEX checksum";
+            return false;
+        }
+
+        switch (type) {
+        case 0x00:
+            if (!builder.write(baseAddress + address, data, length)) {
+                error = "Intel HEX data out of memory bounds";
+                return false;
+            }
+            return true;
+        case 0x01:
+            endOfFile = true;
+            return true;
+        case 0x02: // extended segment address
+        case 0x04: // extended linear address
+            if (length != 2) {
+                error = "Invalid Intel HEX record";
+                return false;
+            }
+            baseAddress = static_cast<u32>(data[0] << 8 | data[1]) << (type == 0x02 ? 4 : 16);
+            return true;
+        case 0x03: // start segment address
+        case 0x05: // start linear address
+            if (length != 4) {
+                error = "Invalid Intel HEX record";
+                return false;
+            }
+            outImage.hasEntryPoint = true;
+            if (type == 0x03) {
+                outImage.entryPoint = static_cast<u16>((data[0] << 8 | data[1]) * 16 + (data[2] << 8 | data[3]));
+            } else {
+                outImage.entryPoint = static_cast<u16>(data[2] << 8 | data[3]);
+            }
+            return true;
+        default:
+            error = "Unsupported Intel HEX record type";
+            return false;
+        }
+    });
+    if (!parsed) {
+        return error;
+    }
+    builder.build(outImage.image);
+    return nullptr;
+}
+
+const char *parseSRecord(const char *text, size_t size, LoadedImage &outImage) {
+    ImageBuilder builder{};
+    const char *error = nullptr;
+    const bool parsed = forEachLine(text, size, [&](const char *line, const char *lineEnd) {
+        if (lineEnd - line < 2 || line[0] != 'S' || line[1] < '0' || line[1] > '9') {
+            error = "S-record must start with 'S' and record type";
+            return false;
+        }
+
+        // S<type><count><address><data><checksum>, where the count includes address, data and checksum and
+        // the checksum is a complement of the sum of all other bytes
+        const u8 type = static_cast<u8>(line[1] - '0');
+        static const u8 addressSizes[] = {2, 2, 3, 4, 0, 2, 3, 4, 3, 2};
+        const u8 addressSize = addressSizes[type];
+        HexLineReader reader{line + 2, lineEnd};
+        u8 count = 0;
+        u32 address = 0;
+        u8 data[255];
+        u8 checksum = 0;
+        if (addressSize == 0 || !reader.readByte(count) || count < addressSize + 1 || !reader.readAddress(addressSize, address) ||
+            !reader.readBytes(data, count - addressSize - 1) || !reader.readByte(checksum) || !reader.isAtEnd()) {
+            error = "Invalid S-record";
+            return false;
+        }
+        if (reader.getChecksum() != 0xFF) {
+            error = "Invalid S-record checksum";
+            return false;
+        }
+
+        switch (type) {
+        case 1:
+        case 2:
+        case 3:
+            if (!builder.write(address, data, count - addressSize - 1)) {
+                error = "S-record data out of memory bounds";
+                return false;
+            }
+            return true;
+        case 7:
+        case 8:
+        case 9:
+            outImage.hasEntryPoint = true;
+            outImage.entryPoint = static_cast<u16>(address);
+            return true;
+        default:
+            return true; // header and record counts
+        }
+    });
+    if (!parsed) {
+        return error;
+    }
+    builder.build(outImage.image);
+    return nullptr;
+}
+
+bool isHexDigit(char character) {
+    return (character >= '0' && character <= '9') || (character >= 'a' && character <= 'f') || (character >= 'A' && character <= 'F');
+}
+} // namespace
+
+std::shared_ptr<const MappedFile> MappedFile::open(const std::string &path) {
+    std::error_code errorCode{};
+    if (!std::filesystem::is_regular_file(path, errorCode)) {
+        return nullptr;
+    }
+    size_t size = 0;
+    const u8 *data = OsMemory::mapFile(path.c_str(), size);
+    return std::make_shared<const MappedFile>(data, size);
+}
+
+MappedFile::~MappedFile() {
+    OsMemory::unmapFile(data, size);
+}
+
+ImageFormat getImageFormat(const std::string &path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    for (char &character : extension) {
+        character = static_cast<char>(tolower(character));
+    }
+    if (extension == ".hex" || extension == ".ihx") {
+        return ImageFormat::IntelHex;
+    }
+    if (extension == ".s19" || extension == ".s28" || extension == ".s37" || extension == ".srec" || extension == ".mot") {
+        return ImageFormat::SRecord;
+    }
+    return ImageFormat::Raw;
+}
+
+bool loadImage(const std::shared_ptr<const MappedFile> &file, size_t offset, size_t size, ImageFormat format, u16 loadAddress, LoadedImage &outImage) {
+    outImage = {};
+    if (offset > file->getSize() || size > file->getSize() - offset) {
+        outImage.error = "Image out of file bounds";
+        return false;
+    }
+
+    const u8 *data = file->getData() + offset;
+    switch (format) {
+    case ImageFormat::Raw:
+    case ImageFormat::As65:
+        if (loadAddress + size > memorySize) {
+            outImage.error = "Image out of memory bounds";
+            return false;
+        }
+        outImage.image.share(loadAddress, static_cast<u32>(size), data, file);
+        return true;
+    case ImageFormat::IntelHex:
+        outImage.error = parseIntelHex(reinterpret_cast<const char *>(data), size, outImage);
+        return outImage.error == nullptr;
+    case ImageFormat::SRecord:
+        outImage.error = parseSRecord(reinterpret_cast<const char *>(data), size, outImage);
+        return outImage.error == nullptr;
+    default:
+        UNREACHABLE_CODE();
+    }
+}
+
+bool loadImageFile(const std::string &path, ImageFormat format, u16 loadAddress, LoadedImage &outImage) {
+    outImage = {};
+    if (format == ImageFormat::As65) {
+        const std::string listingPath = std::filesystem::path(path).replace_extension(".lst").string();
+        const std::shared_ptr<const MappedFile> listing = MappedFile::open(listingPath);
+        if (listing == nullptr || !findAs65LoadAddress(reinterpret_cast<const char *>(listing->getData()), listing->getSize(), loadAddress)) {
+            outImage.error = "Load address not found in as65 listing";
+            return false;
+        }
+    }
+
+    const std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+    if (file == nullptr) {
+        outImage.error = "Image file not found";
+        return false;
+    }
+    return loadImage(file, 0, file->getSize(), format, loadAddress, outImage);
+}
+
+bool findAs65LoadAddress(const char *listing, size_t size, u16 &outAddress) {
+    u32 lowestAddress = memorySize;
+    forEachLine(listing, size, [&](const char *line, const char *lineEnd) {
+        if (lineEnd - line < 7 || line[4] != ' ' || line[5] != ':' || line[6] != ' ') {
+            return true;
+        }
+        u32 address = 0;
+        for (u32 i = 0; i < 4; i++) {
+            if (!isHexDigit(line[i])) {
+                return true;
+            }
+            address = address << 4 | static_cast<u32>(isdigit(line[i]) ? line[i] - '0' : tolower(line[i]) - 'a' + 10);
+        }
+        lowestAddress = std::min(lowestAddress, address);
+        return true;
+    });
+
+    if (lowestAddress == memorySize) {
+        return false;
+    }
+    outAddress = static_cast<u16>(lowestAddress);
+    return true;
+}
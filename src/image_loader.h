@@ -0,0 +1,55 @@
+#pragma once
+
+#include "src/memory.h"
+
+#include <memory>
+#include <string>
+
+// File mapped read-only into memory. Memory images created from it share its pages, so the file stays
+// mapped as long as any memory uses them. One file can hold many images, for example an archive of
+// concatenated raw binaries, and all of them share the same mapping.
+class MappedFile {
+public:
+    static std::shared_ptr<const MappedFile> open(const std::string &path); // nullptr, if the file does not exist
+
+    MappedFile(const u8 *data, size_t size) : data(data), size(size) {}
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const u8 *getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    const u8 *const data;
+    const size_t size;
+};
+
+enum class ImageFormat {
+    Raw,      // bytes placed at the load address
+    IntelHex, // addresses from data records, entry point from start address records
+    SRecord,  // addresses from S1/S2/S3 records, entry point from S7/S8/S9 records
+    As65,     // binary output of as65, which starts at the lowest assembled address given in the listing file
+};
+
+// Returns Intel HEX for .hex and .ihx, S-record for .s19, .s28, .s37, .srec and .mot and raw for other files
+ImageFormat getImageFormat(const std::string &path);
+
+struct LoadedImage {
+    MemoryImage image = {};
+    bool hasEntryPoint = false;
+    u16 entryPoint = 0;
+    const char *error = nullptr; // set, if loading failed
+};
+
+// Loads an image from a part of a mapped file. Raw binaries are shared with the file, so only their first and
+// last partial pages are copied. Text formats are parsed into new pages. The load address is used only for
+// raw binaries. As65 binaries have no header, so they have to be loaded with loadImageFile().
+bool loadImage(const std::shared_ptr<const MappedFile> &file, size_t offset, size_t size, ImageFormat format, u16 loadAddress, LoadedImage &outImage);
+
+// Loads a whole file. For as65 binaries the listing with the same name and .lst extension is read.
+bool loadImageFile(const std::string &path, ImageFormat format, u16 loadAddress, LoadedImage &outImage);
+
+// Returns the lowest address of the assembled code or data in an as65 listing. Listing lines of the
+// assembled bytes have a form of "0400 : d8        start   cld".
+bool findAs65LoadAddress(const char *listing, size_t size, u16 &outAddress);
@@ -1,21 +1,29 @@
 #pragma once
 
+#include "src/disassembler.h"
 #include "src/error.h"
 #include "src/instructions.h"
 #include "src/registers.h"
+#include "src/symbol_table.h"
 
 #include <cstdarg>
+#include <cstring>
 #include <sstream>
 
 class InstructionTracer {
 public:
-    void beginInstruction(u32 newInstructionIndex, OpCode newOpCode, const char *newMnemonic, u16 newPc) {
-        FATAL_ERROR_IF(newOpCode == OpCode::_INVALID, "Invalid opcode");
-        FATAL_ERROR_IF(newMnemonic == nullptr, "Invalid mnemonic");
+    void setSymbols(const SymbolTable *newSymbols) {
+        symbols = newSymbols;
+        disassembler.setSymbols(newSymbols);
+    }
+
+    // Bytes must contain the whole instruction
+    void beginInstruction(u32 newInstructionIndex, u16 newPc, const u8 *bytes) {
+        FATAL_ERROR_IF(static_cast<OpCode>(bytes[0]) == OpCode::_INVALID, "Invalid opcode");
 
         instructionIndex = newInstructionIndex;
-        opCode = newOpCode;
-        mnemonic = newMnemonic;
+        opCode = static_cast<OpCode>(bytes[0]);
+        instruction = disassembler.disassembleInstruction(newPc, bytes);
         pc = newPc;
     }
 
@@ -31,21 +39,30 @@ public:
     }
 
     void endInstruction(StatusFlags flags) {
-        INFO("%08d   OpCode=0x%02x (%s)   PC=0x%04x    Flags=%s%s",
-             instructionIndex, static_cast<int>(opCode), mnemonic,
-             pc, flags.toString().c_str(), extraData.str().c_str());
+        char location[160] = {};
+        if (symbols != nullptr) {
+            location[0] = ' ';
+            location[1] = '(';
+            symbols->formatAddress(pc, location + 2, sizeof(location) - 3);
+            strcat(location, ")");
+        }
+        INFO("%08d   OpCode=0x%02x (%.*s)   PC=0x%04x%s    Flags=%s%s",
+             instructionIndex, static_cast<int>(opCode), static_cast<int>(instruction.size()), instruction.data(),
+             pc, location, flags.toString().c_str(), extraData.str().c_str());
 
         instructionIndex = {};
         opCode = OpCode::_INVALID;
-        mnemonic = {};
+        instruction = {};
         pc = {};
         extraData = {};
     }
 
 private:
+    const SymbolTable *symbols = nullptr;
     u32 instructionIndex = {};
     OpCode opCode = OpCode::_INVALID;
-    const char *mnemonic = {};
+    Disassembler disassembler{};
+    std::string_view instruction = {};
     u16 pc = {};
     std::ostringstream extraData = {};
 };
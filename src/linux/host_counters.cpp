@@ -0,0 +1,77 @@
+#include "src/host_counters.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static perf_event_attr getEventAttributes(HostEvent event) {
+    perf_event_attr attributes = {};
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.read_format = PERF_FORMAT_GROUP;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    switch (event) {
+    case HostEvent::Instructions:
+        attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case HostEvent::Cycles:
+        attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case HostEvent::BranchMisses:
+        attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    case HostEvent::L1DataMisses:
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    default:
+        break;
+    }
+    return attributes;
+}
+
+HostCounters::HostCounters() {
+    // All events are in one group, so they are scheduled together and can be read with a single syscall.
+    // The first event, which can be opened, becomes the group leader.
+    int groupSize = 0;
+    for (u32 eventIndex = 0; eventIndex < HostCounterValues::eventsCount; eventIndex++) {
+        perf_event_attr attributes = getEventAttributes(static_cast<HostEvent>(eventIndex));
+        const int fileDescriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, groupFileDescriptor, 0));
+        if (fileDescriptor == -1) {
+            continue;
+        }
+        if (groupFileDescriptor == -1) {
+            groupFileDescriptor = fileDescriptor;
+        }
+        fileDescriptors[eventIndex] = fileDescriptor;
+        eventIndices[eventIndex] = groupSize++;
+    }
+}
+
+HostCounters::~HostCounters() {
+    for (int fileDescriptor : fileDescriptors) {
+        if (fileDescriptor != -1) {
+            close(fileDescriptor);
+        }
+    }
+}
+
+HostCounterValues HostCounters::read() const {
+    HostCounterValues result{};
+    if (!isAvailable()) {
+        return result;
+    }
+
+    // Group is read as a number of events followed by their values
+    u64 buffer[HostCounterValues::eventsCount + 1] = {};
+    if (::read(groupFileDescriptor, buffer, sizeof(buffer)) <= 0) {
+        return result;
+    }
+    for (u32 eventIndex = 0; eventIndex < HostCounterValues::eventsCount; eventIndex++) {
+        if (eventIndices[eventIndex] != -1 && static_cast<u64>(eventIndices[eventIndex]) < buffer[0]) {
+            result.values[eventIndex] = buffer[1 + eventIndices[eventIndex]];
+        }
+    }
+    return result;
+}
@@ -0,0 +1,67 @@
+#include "src/error.h"
+#include "src/os_memory.h"
+
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace OsMemory {
+constexpr size_t hugePageSize = 2 * 1024 * 1024;
+
+static size_t alignToHugePage(size_t size) {
+    return (size + hugePageSize - 1) / hugePageSize * hugePageSize;
+}
+
+void *allocateHugePages(size_t size) {
+    // Kernel can back only huge page aligned ranges with huge pages. Mapping is made bigger by one huge page
+    // and the unaligned head and tail are unmapped.
+    size = alignToHugePage(size);
+    const size_t mappedSize = size + hugePageSize;
+    void *mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    FATAL_ERROR_IF(mapped == MAP_FAILED, "Failed to allocate %zu bytes", size);
+    const uintptr_t mappedAddress = reinterpret_cast<uintptr_t>(mapped);
+    const uintptr_t alignedAddress = (mappedAddress + hugePageSize - 1) / hugePageSize * hugePageSize;
+    if (alignedAddress != mappedAddress) {
+        munmap(mapped, alignedAddress - mappedAddress);
+    }
+    munmap(reinterpret_cast<void *>(alignedAddress + size), mappedAddress + mappedSize - (alignedAddress + size));
+
+    // Transparent huge pages are only a hint. If they are not available, we just get regular pages.
+    void *address = reinterpret_cast<void *>(alignedAddress);
+    madvise(address, size, MADV_HUGEPAGE);
+    return address;
+}
+
+void freeHugePages(void *address, size_t size) {
+    munmap(address, alignToHugePage(size));
+}
+
+const u8 *mapFile(const char *path, size_t &outSize) {
+    const int file = open(path, O_RDONLY);
+    FATAL_ERROR_IF(file == -1, "Failed to open %s", path);
+
+    struct stat fileStat = {};
+    const bool statSucceeded = fstat(file, &fileStat) == 0;
+    outSize = statSucceeded ? static_cast<size_t>(fileStat.st_size) : 0;
+    void *address = nullptr;
+    if (outSize != 0) {
+        address = mmap(nullptr, outSize, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    close(file);
+    FATAL_ERROR_IF(!statSucceeded || address == MAP_FAILED, "Failed to map %s", path);
+
+    // Files are usually parsed front to back, so let the kernel read ahead aggressively
+    if (address != nullptr) {
+        madvise(address, outSize, MADV_SEQUENTIAL);
+    }
+    return static_cast<const u8 *>(address);
+}
+
+void unmapFile(const u8 *address, size_t size) {
+    if (address != nullptr) {
+        munmap(const_cast<u8 *>(address), size);
+    }
+}
+} // namespace OsMemory
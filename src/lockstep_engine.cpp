@@ -0,0 +1,680 @@
+#include "lockstep_engine.h"
+
+#include "src/bit_operations.h"
+#include "src/error.h"
+
+#include <algorithm>
+
+// Lane processors are used for scalar execution and own memory of each lane.
+struct LockstepEngine::Lane : Processor {
+    using Processor::counters;
+    using Processor::memory;
+    using Processor::regs;
+    using Processor::storeMemory8;
+
+    // Lockstep kernels access memory without the processor, so they cannot report accesses to debug features.
+    bool isObserved() const {
+        return isAnyDebugFeatureActive() || debugFeatures.watchpointsActive || semihosting != nullptr;
+    }
+};
+
+LockstepEngine::LockstepEngine(u32 laneCount)
+    : laneCount(laneCount),
+      lanes(laneCount),
+      faulted(laneCount),
+      a(laneCount), x(laneCount), y(laneCount), sp(laneCount),
+      pc(laneCount),
+      c(laneCount), z(laneCount), i(laneCount), d(laneCount), b(laneCount), o(laneCount), n(laneCount), r(laneCount),
+      bytesProcessed(laneCount), cyclesProcessed(laneCount), instructionsProcessed(laneCount),
+      values(laneCount) {
+    FATAL_ERROR_IF(laneCount == 0, "Lane count cannot be 0");
+}
+
+LockstepEngine::~LockstepEngine() = default;
+
+void LockstepEngine::mapMemoryImage(const MemoryImage &image) {
+    for (Lane &lane : lanes) {
+        lane.mapMemoryImage(image);
+    }
+    invalidatePages();
+}
+
+void LockstepEngine::loadMemory(u32 lane, u32 start, u32 length, const u8 *data) {
+    lanes[lane].loadMemory(start, length, data);
+    invalidatePages();
+}
+
+void LockstepEngine::setRegisters(u32 lane, const Registers &newRegs) {
+    lanes[lane].regs = newRegs;
+    storeLaneState(lane);
+    updateLanesAtSamePc();
+}
+
+ProcessorState LockstepEngine::saveState(u32 lane) {
+    loadLaneState(lane);
+    return lanes[lane].saveState();
+}
+
+void LockstepEngine::restoreState(u32 lane, ProcessorState &state) {
+    lanes[lane].restoreState(state);
+    storeLaneState(lane);
+    faulted[lane] = false;
+    invalidatePages();
+    updateLanesAtSamePc();
+}
+
+Registers LockstepEngine::getRegisters(u32 lane) const {
+    Registers result{};
+    result.a = a[lane];
+    result.x = x[lane];
+    result.y = y[lane];
+    result.sp = sp[lane];
+    result.pc = pc[lane];
+    result.flags.c = c[lane];
+    result.flags.z = z[lane];
+    result.flags.i = i[lane];
+    result.flags.d = d[lane];
+    result.flags.b = b[lane];
+    result.flags.o = o[lane];
+    result.flags.n = n[lane];
+    result.flags.r = r[lane];
+    return result;
+}
+
+Counters LockstepEngine::getCounters(u32 lane) const {
+    Counters result{};
+    result.bytesProcessed = bytesProcessed[lane];
+    result.cyclesProcessed = cyclesProcessed[lane];
+    result.instructionsProcessed = instructionsProcessed[lane];
+    return result;
+}
+
+u8 LockstepEngine::readMemory(u32 lane, u16 address) const {
+    return lanes[lane].memory.read(address);
+}
+
+void LockstepEngine::executeInstructions(u32 instructionCount) {
+    const bool lockstepAllowed = isLockstepAllowed();
+    for (u32 step = 0; step < instructionCount; step++) {
+        if (lockstepAllowed && isConverged()) {
+            const u16 address = pc[0];
+            const Memory &memory = lanes[0].memory;
+            const OpCode opCode = static_cast<OpCode>(memory.read(address));
+            const u8 operand8 = memory.read(address + 1);
+            const u16 operand16 = constructU16(memory.read(address + 2), operand8);
+            if (executeLockstep(opCode, operand8, operand16)) {
+                statistics.lockstepSteps++;
+                continue;
+            }
+        }
+
+        for (u32 lane = 0; lane < laneCount; lane++) {
+            if (!faulted[lane]) {
+                executeScalar(lane);
+            }
+        }
+        invalidatePages(); // scalar instructions can write anywhere
+        updateLanesAtSamePc();
+    }
+}
+
+bool LockstepEngine::isLockstepAllowed() const {
+    for (const Lane &lane : lanes) {
+        if (lane.isObserved()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LockstepEngine::isConverged() {
+    // All lanes must be at the same address and have the same instruction bytes there. Instruction bytes
+    // can differ only, if the program modifies itself differently in each lane.
+    if (!lanesAtSamePc) {
+        return false;
+    }
+    const u16 address = pc[0];
+    const u16 lastAddress = address + 2;
+    if (isPageIdentical(address / Memory::pageSize) && isPageIdentical(lastAddress / Memory::pageSize)) {
+        return true;
+    }
+    return isInstructionIdentical(address);
+}
+
+bool LockstepEngine::isPageIdentical(u32 pageIndex) {
+    if (!verifiedPages[pageIndex]) {
+        bool identical = true;
+        for (u32 lane = 1; lane < laneCount && identical; lane++) {
+            identical = lanes[lane].memory.isPageEqual(lanes[0].memory, pageIndex);
+        }
+        verifiedPages[pageIndex] = true;
+        identicalPages[pageIndex] = identical;
+    }
+    return identicalPages[pageIndex];
+}
+
+bool LockstepEngine::isInstructionIdentical(u16 address) const {
+    const Memory &memory0 = lanes[0].memory;
+    for (u32 lane = 1; lane < laneCount; lane++) {
+        const Memory &memory = lanes[lane].memory;
+        for (u16 offset = 0; offset < 3; offset++) {
+            if (memory.read(address + offset) != memory0.read(address + offset)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void LockstepEngine::updateLanesAtSamePc() {
+    u8 mismatch = faulted[0];
+    for (u32 lane = 1; lane < laneCount; lane++) {
+        mismatch |= faulted[lane] | (pc[lane] != pc[0]);
+    }
+    lanesAtSamePc = mismatch == 0;
+}
+
+bool LockstepEngine::isDecimalModeUsed() const {
+    u8 result = 0;
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        result |= d[lane];
+    }
+    return result != 0;
+}
+
+bool LockstepEngine::executeLockstep(OpCode opCode, u8 operand8, u16 operand16) {
+    switch (opCode) {
+    // Loads
+    case OpCode::LDA_imm:
+        std::fill(values.begin(), values.end(), operand8);
+        kernelLoad(a);
+        advance(2, 2);
+        return true;
+    case OpCode::LDX_imm:
+        std::fill(values.begin(), values.end(), operand8);
+        kernelLoad(x);
+        advance(2, 2);
+        return true;
+    case OpCode::LDY_imm:
+        std::fill(values.begin(), values.end(), operand8);
+        kernelLoad(y);
+        advance(2, 2);
+        return true;
+    case OpCode::LDA_z:
+        gatherValues(operand8);
+        kernelLoad(a);
+        advance(2, 3);
+        return true;
+    case OpCode::LDX_z:
+        gatherValues(operand8);
+        kernelLoad(x);
+        advance(2, 3);
+        return true;
+    case OpCode::LDY_z:
+        gatherValues(operand8);
+        kernelLoad(y);
+        advance(2, 3);
+        return true;
+    case OpCode::LDA_abs:
+        gatherValues(operand16);
+        kernelLoad(a);
+        advance(3, 4);
+        return true;
+    case OpCode::LDX_abs:
+        gatherValues(operand16);
+        kernelLoad(x);
+        advance(3, 4);
+        return true;
+    case OpCode::LDY_abs:
+        gatherValues(operand16);
+        kernelLoad(y);
+        advance(3, 4);
+        return true;
+
+    // Stores
+    case OpCode::STA_z:
+        scatter(operand8, a);
+        advance(2, 3);
+        return true;
+    case OpCode::STX_z:
+        scatter(operand8, x);
+        advance(2, 3);
+        return true;
+    case OpCode::STY_z:
+        scatter(operand8, y);
+        advance(2, 3);
+        return true;
+    case OpCode::STA_abs:
+        scatter(operand16, a);
+        advance(3, 4);
+        return true;
+    case OpCode::STX_abs:
+        scatter(operand16, x);
+        advance(3, 4);
+        return true;
+    case OpCode::STY_abs:
+        scatter(operand16, y);
+        advance(3, 4);
+        return true;
+
+    // Logical and arithmetic operations
+    case OpCode::AND_imm:
+        std::fill(values.begin(), values.end(), operand8);
+        kernelAnd();
+        advance(2, 2);
+        return true;
+    case OpCode::ORA_imm:
+        std::fill(values.begin(), values.end(), operand8);
+        kernelOra();
+        advance(2, 2);
+        return true;
+    case OpCode::EOR_imm:
+        std::fill(values.begin(), values.end(), operand8);
+        kernelEor();
+        advance(2, 2);
+        return true;
+    case OpCode::AND_z:
+        gatherValues(operand8);
+        kernelAnd();
+        advance(2, 3);
+        return true;
+    case OpCode::ORA_z:
+        gatherValues(operand8);
+        kernelOra();
+        advance(2, 3);
+        return true;
+    case OpCode::EOR_z:
+        gatherValues(operand8);
+        kernelEor();
+        advance(2, 3);
+        return true;
+    case OpCode::BIT_z:
+        gatherValues(operand8);
+        kernelBit();
+        advance(2, 3);
+        return true;
+    case OpCode::ADC_imm:
+    case OpCode::SBC_imm:
+        if (isDecimalModeUsed()) {
+            return false;
+        }
+        std::fill(values.begin(), values.end(), operand8);
+        kernelSumWithCarry(opCode == OpCode::SBC_imm);
+        advance(2, 2);
+        return true;
+    case OpCode::ADC_z:
+    case OpCode::SBC_z:
+        if (isDecimalModeUsed()) {
+            return false;
+        }
+        gatherValues(operand8);
+        kernelSumWithCarry(opCode == OpCode::SBC_z);
+        advance(2, 3);
+        return true;
+
+    // Comparisons
+    case OpCode::CMP_imm:
+        std::fill(values.begin(), values.end(), operand8);
+        kernelCompare(a);
+        advance(2, 2);
+        return true;
+    case OpCode::CPX_imm:
+        std::fill(values.begin(), values.end(), operand8);
+        kernelCompare(x);
+        advance(2, 2);
+        return true;
+    case OpCode::CPY_imm:
+        std::fill(values.begin(), values.end(), operand8);
+        kernelCompare(y);
+        advance(2, 2);
+        return true;
+    case OpCode::CMP_z:
+        gatherValues(operand8);
+        kernelCompare(a);
+        advance(2, 3);
+        return true;
+    case OpCode::CPX_z:
+        gatherValues(operand8);
+        kernelCompare(x);
+        advance(2, 3);
+        return true;
+    case OpCode::CPY_z:
+        gatherValues(operand8);
+        kernelCompare(y);
+        advance(2, 3);
+        return true;
+
+    // Register operations
+    case OpCode::INX:
+        kernelIncrement(x, 1);
+        advance(1, 2);
+        return true;
+    case OpCode::INY:
+        kernelIncrement(y, 1);
+        advance(1, 2);
+        return true;
+    case OpCode::DEX:
+        kernelIncrement(x, 0xFF);
+        advance(1, 2);
+        return true;
+    case OpCode::DEY:
+        kernelIncrement(y, 0xFF);
+        advance(1, 2);
+        return true;
+    case OpCode::TAX:
+        kernelTransfer(x, a, true);
+        advance(1, 2);
+        return true;
+    case OpCode::TAY:
+        kernelTransfer(y, a, true);
+        advance(1, 2);
+        return true;
+    case OpCode::TXA:
+        kernelTransfer(a, x, true);
+        advance(1, 2);
+        return true;
+    case OpCode::TYA:
+        kernelTransfer(a, y, true);
+        advance(1, 2);
+        return true;
+    case OpCode::TSX:
+        kernelTransfer(x, sp, true);
+        advance(1, 2);
+        return true;
+    case OpCode::TXS:
+        kernelTransfer(sp, x, false);
+        advance(1, 2);
+        return true;
+    case OpCode::ASL_acc:
+        kernelShiftLeft(false);
+        advance(1, 2);
+        return true;
+    case OpCode::ROL_acc:
+        kernelShiftLeft(true);
+        advance(1, 2);
+        return true;
+    case OpCode::LSR_acc:
+        kernelShiftRight(false);
+        advance(1, 2);
+        return true;
+    case OpCode::ROR_acc:
+        kernelShiftRight(true);
+        advance(1, 2);
+        return true;
+
+    // Flag operations
+    case OpCode::CLC:
+        std::fill(c.begin(), c.end(), u8{0});
+        advance(1, 2);
+        return true;
+    case OpCode::SEC:
+        std::fill(c.begin(), c.end(), u8{1});
+        advance(1, 2);
+        return true;
+    case OpCode::CLD:
+        std::fill(d.begin(), d.end(), u8{0});
+        advance(1, 2);
+        return true;
+    case OpCode::SED:
+        std::fill(d.begin(), d.end(), u8{1});
+        advance(1, 2);
+        return true;
+    case OpCode::CLI:
+        std::fill(i.begin(), i.end(), u8{0});
+        advance(1, 2);
+        return true;
+    case OpCode::SEI:
+        std::fill(i.begin(), i.end(), u8{1});
+        advance(1, 2);
+        return true;
+    case OpCode::CLV:
+        std::fill(o.begin(), o.end(), u8{0});
+        advance(1, 2);
+        return true;
+    case OpCode::NOP:
+        advance(1, 2);
+        return true;
+
+    // Control flow
+    case OpCode::BCC:
+        kernelBranch(c, 0, operand8);
+        return true;
+    case OpCode::BCS:
+        kernelBranch(c, 1, operand8);
+        return true;
+    case OpCode::BNE:
+        kernelBranch(z, 0, operand8);
+        return true;
+    case OpCode::BEQ:
+        kernelBranch(z, 1, operand8);
+        return true;
+    case OpCode::BPL:
+        kernelBranch(n, 0, operand8);
+        return true;
+    case OpCode::BMI:
+        kernelBranch(n, 1, operand8);
+        return true;
+    case OpCode::BVC:
+        kernelBranch(o, 0, operand8);
+        return true;
+    case OpCode::BVS:
+        kernelBranch(o, 1, operand8);
+        return true;
+    case OpCode::JMP_abs:
+        kernelJump(operand16);
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+void LockstepEngine::executeScalar(u32 lane) {
+    loadLaneState(lane);
+    const StopReason stopReason = lanes[lane].executeInstructions(1).stopReason;
+    if (stopReason == StopReason::InvalidOpcode || stopReason == StopReason::GuestError) {
+        faulted[lane] = true;
+    }
+    storeLaneState(lane);
+    statistics.scalarInstructions++;
+}
+
+void LockstepEngine::storeLaneState(u32 lane) {
+    const Registers &regs = lanes[lane].regs;
+    a[lane] = regs.a;
+    x[lane] = regs.x;
+    y[lane] = regs.y;
+    sp[lane] = regs.sp;
+    pc[lane] = regs.pc;
+    c[lane] = regs.flags.c;
+    z[lane] = regs.flags.z;
+    i[lane] = regs.flags.i;
+    d[lane] = regs.flags.d;
+    b[lane] = regs.flags.b;
+    o[lane] = regs.flags.o;
+    n[lane] = regs.flags.n;
+    r[lane] = regs.flags.r;
+
+    const Counters &counters = lanes[lane].counters;
+    bytesProcessed[lane] = counters.bytesProcessed;
+    cyclesProcessed[lane] = counters.cyclesProcessed;
+    instructionsProcessed[lane] = counters.instructionsProcessed;
+}
+
+void LockstepEngine::loadLaneState(u32 lane) {
+    lanes[lane].regs = getRegisters(lane);
+    lanes[lane].counters = getCounters(lane);
+}
+
+void LockstepEngine::gatherValues(u16 address) {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        values[lane] = lanes[lane].memory.read(address);
+    }
+}
+
+void LockstepEngine::scatter(u16 address, const std::vector<u8> &source) {
+    u8 difference = 0;
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        lanes[lane].storeMemory8(address, source[lane]);
+        difference |= source[lane] ^ source[0];
+    }
+    if (difference != 0) {
+        identicalPages[address / Memory::pageSize] = false;
+    }
+}
+
+void LockstepEngine::advance(u8 bytes, u8 cycles) {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        pc[lane] += bytes;
+        bytesProcessed[lane] += bytes;
+        cyclesProcessed[lane] += cycles;
+        instructionsProcessed[lane]++;
+    }
+}
+
+void LockstepEngine::kernelLoad(std::vector<u8> &destination) {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 value = values[lane];
+        destination[lane] = value;
+        z[lane] = value == 0;
+        n[lane] = value >> 7;
+    }
+}
+
+void LockstepEngine::kernelAnd() {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 value = a[lane] & values[lane];
+        a[lane] = value;
+        z[lane] = value == 0;
+        n[lane] = value >> 7;
+    }
+}
+
+void LockstepEngine::kernelOra() {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 value = a[lane] | values[lane];
+        a[lane] = value;
+        z[lane] = value == 0;
+        n[lane] = value >> 7;
+    }
+}
+
+void LockstepEngine::kernelEor() {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 value = a[lane] ^ values[lane];
+        a[lane] = value;
+        z[lane] = value == 0;
+        n[lane] = value >> 7;
+    }
+}
+
+void LockstepEngine::kernelSumWithCarry(bool invertAddend) {
+    const u8 inversionMask = invertAddend ? 0xFF : 0x00;
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 augend = a[lane];
+        const u8 addend = values[lane] ^ inversionMask;
+        const u16 sum16 = u16(augend) + u16(addend) + u16(c[lane]);
+        const u8 sum8 = static_cast<u8>(sum16);
+
+        // Overflow happens, when both arguments have the same sign and the sign of the result is different.
+        o[lane] = ((augend ^ sum8) & (addend ^ sum8)) >> 7;
+        c[lane] = static_cast<u8>(sum16 >> 8);
+        z[lane] = sum8 == 0;
+        n[lane] = sum8 >> 7;
+        a[lane] = sum8;
+    }
+}
+
+void LockstepEngine::kernelCompare(const std::vector<u8> &reg) {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 registerValue = reg[lane];
+        const u8 inputValue = values[lane];
+        c[lane] = registerValue >= inputValue;
+        z[lane] = registerValue == inputValue;
+        n[lane] = static_cast<u8>(registerValue - inputValue) >> 7;
+    }
+}
+
+void LockstepEngine::kernelBit() {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 value = values[lane];
+        z[lane] = (a[lane] & value) == 0;
+        o[lane] = (value >> 6) & 1;
+        n[lane] = value >> 7;
+    }
+}
+
+void LockstepEngine::kernelIncrement(std::vector<u8> &reg, u8 delta) {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 value = reg[lane] + delta;
+        reg[lane] = value;
+        z[lane] = value == 0;
+        n[lane] = value >> 7;
+    }
+}
+
+void LockstepEngine::kernelTransfer(std::vector<u8> &destination, const std::vector<u8> &source, bool updateFlags) {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        destination[lane] = source[lane];
+    }
+    if (updateFlags) {
+        for (u32 lane = 0; lane < laneCount; lane++) {
+            z[lane] = destination[lane] == 0;
+            n[lane] = destination[lane] >> 7;
+        }
+    }
+}
+
+void LockstepEngine::kernelShiftLeft(bool rotate) {
+    const u8 carryMask = rotate ? 1 : 0;
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 value = a[lane];
+        const u8 result = static_cast<u8>(value << 1) | (c[lane] & carryMask);
+        c[lane] = value >> 7;
+        z[lane] = result == 0;
+        n[lane] = result >> 7;
+        a[lane] = result;
+    }
+}
+
+void LockstepEngine::kernelShiftRight(bool rotate) {
+    const u8 carryMask = rotate ? 1 : 0;
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 value = a[lane];
+        const u8 result = (value >> 1) | static_cast<u8>((c[lane] & carryMask) << 7);
+        c[lane] = value & 1;
+        z[lane] = result == 0;
+        n[lane] = result >> 7;
+        a[lane] = result;
+    }
+}
+
+void LockstepEngine::kernelBranch(const std::vector<u8> &flag, u8 expectedValue, u8 offset) {
+    const u16 signExtendedOffset = static_cast<u16>(static_cast<i16>(static_cast<i8>(offset)));
+    u32 takenCount = 0;
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u16 nextPc = pc[lane] + 2;
+        const u16 targetPc = nextPc + signExtendedOffset;
+        const u8 taken = flag[lane] == expectedValue;
+        const u8 pageCrossed = hi(nextPc) != hi(targetPc);
+
+        // Taken branch costs one additional cycle and yet another one, if it crosses a page boundary.
+        pc[lane] = taken ? targetPc : nextPc;
+        cyclesProcessed[lane] += 2 + taken + (taken & pageCrossed);
+        bytesProcessed[lane] += 2;
+        instructionsProcessed[lane]++;
+        takenCount += taken;
+    }
+    if (takenCount != 0 && takenCount != laneCount) {
+        lanesAtSamePc = false;
+    }
+}
+
+void LockstepEngine::kernelJump(u16 address) {
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        pc[lane] = address;
+        cyclesProcessed[lane] += 3;
+        bytesProcessed[lane] += 3;
+        instructionsProcessed[lane]++;
+    }
+}
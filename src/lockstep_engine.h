@@ -0,0 +1,97 @@
+#pragma once
+
+#include "src/processor.h"
+
+#include <bitset>
+#include <vector>
+
+// Engine executing the same program on many processors (lanes) at once, for example for fuzzing with many
+// input variants. Registers, flags and counters of all lanes are kept as structure of arrays. When all lanes
+// are at the same instruction, it is executed for all of them with one loop over the lanes, which the
+// compiler turns into vector code. Memory accesses are performed per lane, since every lane has its own memory.
+// Lanes which diverged, and instructions which don't have a lockstep implementation, are executed by
+// a regular Processor, one lane at a time.
+class LockstepEngine {
+public:
+    struct Statistics {
+        u64 lockstepSteps = 0;      // instructions executed for all lanes at once
+        u64 scalarInstructions = 0; // instructions executed for single lanes
+    };
+
+    explicit LockstepEngine(u32 laneCount);
+    ~LockstepEngine();
+    LockstepEngine(const LockstepEngine &) = delete;
+    LockstepEngine &operator=(const LockstepEngine &) = delete;
+
+    void mapMemoryImage(const MemoryImage &image);
+    void loadMemory(u32 lane, u32 start, u32 length, const u8 *data);
+    void setRegisters(u32 lane, const Registers &newRegs);
+    ProcessorState saveState(u32 lane);
+    void restoreState(u32 lane, ProcessorState &state); // also clears the fault
+
+    void executeInstructions(u32 instructionCount);
+
+    u32 getLaneCount() const { return laneCount; }
+    Registers getRegisters(u32 lane) const;
+    Counters getCounters(u32 lane) const;
+    u8 readMemory(u32 lane, u16 address) const;
+    bool isLaneFaulted(u32 lane) const { return faulted[lane]; }
+    const Statistics &getStatistics() const { return statistics; }
+
+private:
+    struct Lane;
+
+    // Selecting execution path
+    bool isLockstepAllowed() const;
+    bool isConverged();
+    bool isPageIdentical(u32 pageIndex);
+    bool isInstructionIdentical(u16 address) const;
+    void updateLanesAtSamePc();
+    void invalidatePages() { verifiedPages.reset(); }
+    bool isDecimalModeUsed() const;
+    bool executeLockstep(OpCode opCode, u8 operand8, u16 operand16);
+    void executeScalar(u32 lane);
+
+    // Moving state between the arrays and lane processors
+    void storeLaneState(u32 lane);
+    void loadLaneState(u32 lane);
+
+    // Memory accesses
+    void gatherValues(u16 address);
+    void scatter(u16 address, const std::vector<u8> &source);
+
+    // Lockstep kernels
+    void advance(u8 bytes, u8 cycles);
+    void kernelLoad(std::vector<u8> &destination);
+    void kernelAnd();
+    void kernelOra();
+    void kernelEor();
+    void kernelSumWithCarry(bool invertAddend);
+    void kernelCompare(const std::vector<u8> &reg);
+    void kernelBit();
+    void kernelIncrement(std::vector<u8> &reg, u8 delta);
+    void kernelTransfer(std::vector<u8> &destination, const std::vector<u8> &source, bool updateFlags);
+    void kernelShiftLeft(bool rotate);
+    void kernelShiftRight(bool rotate);
+    void kernelBranch(const std::vector<u8> &flag, u8 expectedValue, u8 offset);
+    void kernelJump(u16 address);
+
+    const u32 laneCount;
+    std::vector<Lane> lanes;
+    std::vector<u8> faulted;
+    Statistics statistics = {};
+
+    // State of all lanes
+    std::vector<u8> a, x, y, sp;
+    std::vector<u16> pc;
+    std::vector<u8> c, z, i, d, b, o, n, r;
+    std::vector<u32> bytesProcessed, cyclesProcessed, instructionsProcessed;
+    std::vector<u8> values; // operands of the current instruction
+
+    // Convergence is tracked incrementally, so it's not checked for all lanes on every step. Lanes leave the
+    // same pc only on scalar execution and on branches. Pages verified to be identical in all lanes stay
+    // identical until lockstep stores differing values to them, or until the lane memory is changed otherwise.
+    bool lanesAtSamePc = true;
+    std::bitset<Memory::pagesCount> verifiedPages = {};
+    std::bitset<Memory::pagesCount> identicalPages = {};
+};
@@ -0,0 +1,264 @@
+#include "memory.h"
+
+#include "src/error.h"
+#include "src/page_arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+struct Page {
+    u8 data[Memory::pageSize];
+};
+
+std::shared_ptr<u8> allocatePage() {
+    auto page = std::make_shared<Page>();
+    return std::shared_ptr<u8>(page, page->data);
+}
+
+const std::shared_ptr<const u8> &getZeroPage() {
+    static const std::shared_ptr<const u8> zeroPage = allocatePage();
+    return zeroPage;
+}
+} // namespace
+
+MemoryImage::MemoryImage(u32 start, u32 length, const u8 *data) {
+    copy(start, length, data);
+}
+
+void MemoryImage::copy(u32 start, u32 length, const u8 *data) {
+    FATAL_ERROR_IF(start + length > memorySize, "Out of memory bounds.");
+
+    for (u32 address = start; address < start + length;) {
+        const u32 pageIndex = address / Memory::pageSize;
+        const u32 pageOffset = address % Memory::pageSize;
+        const u32 copySize = std::min(Memory::pageSize - pageOffset, start + length - address);
+
+        // Pages can be mapped by memories already, so they are never modified in place
+        std::shared_ptr<u8> page = allocatePage();
+        if (copySize == Memory::pageSize) {
+            partialPages[pageIndex] = false;
+        } else {
+            if (pages[pageIndex] == nullptr) {
+                partialPages[pageIndex] = true;
+                imageBytes[pageIndex].reset();
+            } else {
+                memcpy(page.get(), pages[pageIndex].get(), Memory::pageSize);
+            }
+            for (u32 offset = pageOffset; offset < pageOffset + copySize; offset++) {
+                imageBytes[pageIndex][offset] = true;
+            }
+        }
+        memcpy(page.get() + pageOffset, data + (address - start), copySize);
+        pages[pageIndex] = std::move(page);
+
+        address += copySize;
+    }
+}
+
+void MemoryImage::share(u32 start, u32 length, const u8 *data, const std::shared_ptr<const void> &owner) {
+    FATAL_ERROR_IF(start + length > memorySize, "Out of memory bounds.");
+
+    for (u32 address = start; address < start + length;) {
+        const u32 pageIndex = address / Memory::pageSize;
+        const u32 pageOffset = address % Memory::pageSize;
+        const u32 pageSize = std::min(Memory::pageSize - pageOffset, start + length - address);
+        if (pageSize == Memory::pageSize) {
+            pages[pageIndex] = std::shared_ptr<const u8>(owner, data + (address - start));
+            partialPages[pageIndex] = false;
+        } else {
+            copy(address, pageSize, data + (address - start));
+        }
+        address += pageSize;
+    }
+}
+
+Memory::Memory() {
+    const std::shared_ptr<const u8> &zeroPage = getZeroPage();
+    for (u32 pageIndex = 0; pageIndex < pagesCount; pageIndex++) {
+        cleanPages[pageIndex] = zeroPage;
+        mapPage(pageIndex, zeroPage);
+    }
+}
+
+u8 &Memory::operator[](u16 address) {
+    u8 *page = makePageWritable(address / pageSize);
+    return page[address % pageSize];
+}
+
+void Memory::load(u32 start, u32 length, const u8 *data) {
+    FATAL_ERROR_IF(start + length > memorySize, "Out of memory bounds.");
+
+    for (u32 address = start; address < start + length;) {
+        const u32 pageOffset = address % pageSize;
+        const u32 copySize = std::min(pageSize - pageOffset, start + length - address);
+
+        u8 *page = makePageWritable(address / pageSize);
+        memcpy(page + pageOffset, data + (address - start), copySize);
+
+        address += copySize;
+    }
+}
+
+void Memory::mapImage(const MemoryImage &image) {
+    const std::shared_ptr<const u8> &zeroPage = getZeroPage();
+    for (u32 pageIndex = 0; pageIndex < pagesCount; pageIndex++) {
+        const std::shared_ptr<const u8> &imagePage = image.pages[pageIndex];
+        if (imagePage == nullptr) {
+            continue;
+        }
+
+        // Bytes outside of the image are zero, so partial pages can be shared as long as the memory has
+        // only zeros on them. Otherwise the image bytes are merged with the clean and the current page.
+        const bool isModified = pageOwners[pageIndex] != cleanPages[pageIndex];
+        if (!image.partialPages[pageIndex] || cleanPages[pageIndex] == zeroPage) {
+            cleanPages[pageIndex] = imagePage;
+        } else {
+            std::shared_ptr<u8> mergedPage = allocatePage();
+            memcpy(mergedPage.get(), cleanPages[pageIndex].get(), pageSize);
+            mergeImageBytes(mergedPage.get(), image, pageIndex);
+            cleanPages[pageIndex] = std::move(mergedPage);
+        }
+
+        if (isModified && image.partialPages[pageIndex]) {
+            mergeImageBytes(makePageWritable(pageIndex), image, pageIndex);
+        } else {
+            mapPage(pageIndex, cleanPages[pageIndex]);
+        }
+    }
+}
+
+void Memory::mergeImageBytes(u8 *page, const MemoryImage &image, u32 pageIndex) {
+    const u8 *imagePage = image.pages[pageIndex].get();
+    const std::bitset<pageSize> &imageBytes = image.imageBytes[pageIndex];
+    for (u32 offset = 0; offset < pageSize; offset++) {
+        if (imageBytes[offset]) {
+            page[offset] = imagePage[offset];
+        }
+    }
+}
+
+void Memory::reset() {
+    for (u32 pageIndex = 0; pageIndex < pagesCount; pageIndex++) {
+        if (pageOwners[pageIndex] != cleanPages[pageIndex]) {
+            mapPage(pageIndex, cleanPages[pageIndex]);
+        }
+    }
+}
+
+void Memory::unmapImages() {
+    const std::shared_ptr<const u8> &zeroPage = getZeroPage();
+    for (u32 pageIndex = 0; pageIndex < pagesCount; pageIndex++) {
+        cleanPages[pageIndex] = zeroPage;
+        if (pageOwners[pageIndex] != zeroPage) {
+            mapPage(pageIndex, zeroPage);
+        }
+    }
+}
+
+Memory Memory::clone() {
+    Memory result{};
+    result.assignShared(*this);
+    return result;
+}
+
+void Memory::assignShared(Memory &source) {
+    for (u32 pageIndex = 0; pageIndex < pagesCount; pageIndex++) {
+        if (cleanPages[pageIndex] != source.cleanPages[pageIndex]) {
+            cleanPages[pageIndex] = source.cleanPages[pageIndex];
+        }
+        if (pageOwners[pageIndex] != source.pageOwners[pageIndex]) {
+            mapPage(pageIndex, source.sharePage(pageIndex));
+        } else {
+            source.sharePage(pageIndex);
+            writablePages[pageIndex] = nullptr;
+        }
+    }
+}
+
+std::shared_ptr<const u8> Memory::sharePage(u32 pageIndex) {
+    writablePages[pageIndex] = nullptr;
+    return pageOwners[pageIndex];
+}
+
+void Memory::mapPage(u32 pageIndex, std::shared_ptr<const u8> page) {
+    readPages[pageIndex] = page.get();
+    writablePages[pageIndex] = nullptr;
+    pageOwners[pageIndex] = std::move(page);
+    privatePages[pageIndex] = false;
+}
+
+void Memory::trapWrites(u32 pageIndex, MemoryWriteTrap *trap) {
+    FATAL_ERROR_IF(pageIndex >= pagesCount, "Out of memory bounds.");
+    FATAL_ERROR_IF(trap == nullptr, "Write trap cannot be null");
+    FATAL_ERROR_IF(writeTrap != nullptr && writeTrap != trap, "Only one write trap is supported");
+    writeTrap = trap;
+    trappedPages[pageIndex] = true;
+    writablePages[pageIndex] = nullptr;
+}
+
+void Memory::untrapWrites(u32 pageIndex) {
+    FATAL_ERROR_IF(pageIndex >= pagesCount, "Out of memory bounds.");
+    trappedPages[pageIndex] = false;
+    if (trappedPages.none()) {
+        writeTrap = nullptr;
+    }
+}
+
+u32 Memory::getPrivatePagesCount() const {
+    return static_cast<u32>(privatePages.count());
+}
+
+bool Memory::isEqual(const Memory &other) const {
+    for (u32 pageIndex = 0; pageIndex < pagesCount; pageIndex++) {
+        if (!isPageEqual(other, pageIndex)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Memory::isPageEqual(const Memory &other, u32 pageIndex) const {
+    const u8 *page = readPages[pageIndex];
+    const u8 *otherPage = other.readPages[pageIndex];
+    return page == otherPage || memcmp(page, otherPage, pageSize) == 0;
+}
+
+void Memory::writeSlow(u16 address, u8 value) {
+    if (trappedPages[address / pageSize]) {
+        writeTrap->onTrappedWrite(address, value);
+        return;
+    }
+    u8 *page = makePageWritable(address / pageSize);
+    page[address % pageSize] = value;
+}
+
+u8 *Memory::makePageWritable(u32 pageIndex) {
+    if (writablePages[pageIndex] != nullptr) {
+        return writablePages[pageIndex];
+    }
+
+    // Page allocated by us can be written in place if no one else shares it. Otherwise we have to copy it.
+    // We know we can safely drop constness, because we allocated the page ourselves.
+    u8 *page = nullptr;
+    if (privatePages[pageIndex] && pageOwners[pageIndex].use_count() == 1) {
+        page = const_cast<u8 *>(readPages[pageIndex]);
+    } else {
+        std::shared_ptr<u8> newPage = allocatePrivatePage();
+        memcpy(newPage.get(), readPages[pageIndex], pageSize);
+        page = newPage.get();
+        readPages[pageIndex] = page;
+        pageOwners[pageIndex] = std::move(newPage);
+        privatePages[pageIndex] = true;
+    }
+
+    // Trapped pages must stay on the slow path of write()
+    if (!trappedPages[pageIndex]) {
+        writablePages[pageIndex] = page;
+    }
+    return page;
+}
+
+std::shared_ptr<u8> Memory::allocatePrivatePage() {
+    return pageArena != nullptr ? pageArena->allocatePage() : allocatePage();
+}
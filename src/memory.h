@@ -0,0 +1,119 @@
+#pragma once
+
+#include "src/types.h"
+
+#include <bitset>
+#include <memory>
+
+constexpr u32 memorySize = 64 * 1024;
+constexpr u32 memoryPageSize = 256;
+constexpr u32 memoryPagesCount = memorySize / memoryPageSize;
+
+// Memory image is a set of read-only pages, which can be mapped into many Memory objects at once, for
+// example a ROM shared by a fleet of processors. The data is copied only once, when the image is created.
+// Data, which outlives the image, like a mapped file, can be shared without copying. Pages covered only
+// partially remember which bytes belong to the image, so mapping them keeps the other bytes of the memory.
+class MemoryImage {
+public:
+    MemoryImage() = default;
+    MemoryImage(u32 start, u32 length, const u8 *data);
+
+    // Copies the data into the image. Parts of the pages outside of the range are preserved.
+    void copy(u32 start, u32 length, const u8 *data);
+
+    // Uses the data directly for the pages it fully covers, keeping the owner alive as long as they are
+    // mapped anywhere. Partially covered pages are copied.
+    void share(u32 start, u32 length, const u8 *data, const std::shared_ptr<const void> &owner);
+
+    const u8 *getPage(u32 pageIndex) const { return pages[pageIndex].get(); } // nullptr for pages not in the image
+
+private:
+    friend class Memory;
+    std::shared_ptr<const u8> pages[memoryPagesCount] = {}; // bytes outside of the image are zero
+    std::bitset<memoryPagesCount> partialPages = {};
+    std::bitset<memoryPageSize> imageBytes[memoryPagesCount] = {}; // only for partial pages
+};
+
+class PageArena;
+
+// Receiver of guest writes to trapped pages of Memory.
+class MemoryWriteTrap {
+public:
+    virtual void onTrappedWrite(u16 address, u8 value) = 0;
+
+protected:
+    ~MemoryWriteTrap() = default;
+};
+
+// Guest memory divided into pages. Pages are reference-counted and can be shared between Memory objects.
+// Shared pages are read-only and are copied on first write. Memory starts with all pages mapped to one
+// global zero page, so nothing is allocated until the guest actually writes something.
+class Memory {
+public:
+    constexpr static u32 pageSize = memoryPageSize;
+    constexpr static u32 pagesCount = memoryPagesCount;
+
+    Memory();
+    Memory(Memory &&) = default;
+    Memory &operator=(Memory &&) = default;
+    Memory(const Memory &) = delete;
+    Memory &operator=(const Memory &) = delete;
+
+    u8 read(u16 address) const {
+        return readPages[address / pageSize][address % pageSize];
+    }
+
+    void write(u16 address, u8 value) {
+        u8 *page = writablePages[address / pageSize];
+        if (page != nullptr) {
+            page[address % pageSize] = value;
+        } else {
+            writeSlow(address, value);
+        }
+    }
+
+    // Returns a reference to memory, which is guaranteed to stay valid until the page is shared again.
+    // Accessed page is always copied, if it's shared, so this should not be used on the hot path.
+    u8 &operator[](u16 address);
+
+    void load(u32 start, u32 length, const u8 *data);
+    void mapImage(const MemoryImage &image);
+
+    // Drops all modifications. Pages go back to zero or to the last memory image mapped on them.
+    void reset();
+    void unmapImages(); // drops all modifications and memory images, so all pages go back to zero
+
+    // Functions for sharing pages with other objects. Shared page will be copied on next write.
+    Memory clone();
+    void assignShared(Memory &source); // makes the memory equal to source, remapping only pages which differ
+    std::shared_ptr<const u8> sharePage(u32 pageIndex);
+    void mapPage(u32 pageIndex, std::shared_ptr<const u8> page);
+
+    // Writes to trapped pages are passed to the trap and the page is not modified. Trapped pages are never
+    // writable, so the writes are dispatched by the slow path and other pages are not affected. Only loading
+    // and operator[] modify trapped pages. Traps are not shared with clones.
+    void trapWrites(u32 pageIndex, MemoryWriteTrap *trap);
+    void untrapWrites(u32 pageIndex);
+
+    // Pages allocated on writes come from the arena instead of the heap. Arena is owned by the caller.
+    void setPageArena(PageArena *arena) { pageArena = arena; }
+
+    u32 getPrivatePagesCount() const;
+    bool isEqual(const Memory &other) const; // fast for pages shared by both memories
+    bool isPageEqual(const Memory &other, u32 pageIndex) const;
+
+private:
+    void writeSlow(u16 address, u8 value);
+    u8 *makePageWritable(u32 pageIndex);
+    std::shared_ptr<u8> allocatePrivatePage();
+    static void mergeImageBytes(u8 *page, const MemoryImage &image, u32 pageIndex);
+
+    const u8 *readPages[pagesCount] = {};
+    u8 *writablePages[pagesCount] = {};
+    std::shared_ptr<const u8> pageOwners[pagesCount] = {};
+    std::shared_ptr<const u8> cleanPages[pagesCount] = {}; // pages restored on reset
+    std::bitset<pagesCount> privatePages = {};            // allocated by Memory, writable if not shared
+    std::bitset<pagesCount> trappedPages = {};
+    MemoryWriteTrap *writeTrap = nullptr; // one trap for all trapped pages
+    PageArena *pageArena = nullptr;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "src/types.h"
+
+#include <cstddef>
+
+// Functions for allocating large blocks of memory directly from the operating system. Returned memory is
+// zeroed and aligned to the huge page size where huge pages are available. Huge pages are used if possible,
+// which reduces TLB pressure when many objects are accessed by many threads.
+namespace OsMemory {
+void *allocateHugePages(size_t size);
+void freeHugePages(void *address, size_t size);
+
+// Maps whole file read-only into memory, so it can be parsed without copying. Returns nullptr for empty files.
+const u8 *mapFile(const char *path, size_t &outSize);
+void unmapFile(const u8 *address, size_t size);
+} // namespace OsMemory
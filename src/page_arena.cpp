@@ -0,0 +1,94 @@
+#include "page_arena.h"
+
+#include "src/error.h"
+
+#include <new>
+
+namespace {
+struct Page {
+    u8 data[Memory::pageSize];
+};
+} // namespace
+
+// Allocator passed to std::allocate_shared, which rebinds it to its internal type holding the page and
+// the reference counts. The rebound type is the only one ever allocated.
+template <typename T>
+class PageArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit PageArenaAllocator(PageArena *arena) : arena(arena) {}
+    template <typename U>
+    PageArenaAllocator(const PageArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t count) { return static_cast<T *>(arena->allocateBlock(count * sizeof(T))); }
+    void deallocate(T *pointer, size_t) { arena->freeBlock(pointer); }
+
+    template <typename U>
+    bool operator==(const PageArenaAllocator<U> &other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const PageArenaAllocator<U> &other) const { return arena != other.arena; }
+
+private:
+    template <typename U>
+    friend class PageArenaAllocator;
+    PageArena *arena;
+};
+
+PageArena::PageArena(void *region, size_t regionSize)
+    : region(static_cast<u8 *>(region)),
+      blocksCount(regionSize / blockSize) {
+    FATAL_ERROR_IF(reinterpret_cast<uintptr_t>(region) % alignof(std::max_align_t) != 0, "Page arena region is not aligned");
+}
+
+PageArena::~PageArena() {
+    // Reported without throwing, like in ~ProcessorPool
+    if (usedBlocksCount != 0) {
+        Error::log(stderr, "ERROR", "Pages were not released to the arena");
+    }
+}
+
+std::shared_ptr<u8> PageArena::allocatePage() {
+    auto page = std::allocate_shared<Page>(PageArenaAllocator<Page>{this});
+    return std::shared_ptr<u8>(page, page->data);
+}
+
+u32 PageArena::getUsedBlocksCount() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return usedBlocksCount;
+}
+
+bool PageArena::isInArena(const void *address) const {
+    const u8 *byte = static_cast<const u8 *>(address);
+    return byte >= region && byte < region + blocksCount * blockSize;
+}
+
+void *PageArena::allocateBlock(size_t size) {
+    FATAL_ERROR_IF(size > blockSize, "Page does not fit in arena block");
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        void *block = freeBlocks;
+        if (block != nullptr) {
+            freeBlocks = *static_cast<void **>(block);
+        } else if (unusedBlockIndex < blocksCount) {
+            block = region + unusedBlockIndex++ * blockSize;
+        }
+        if (block != nullptr) {
+            usedBlocksCount++;
+            return block;
+        }
+    }
+    return ::operator new(size);
+}
+
+void PageArena::freeBlock(void *block) {
+    if (!isInArena(block)) {
+        ::operator delete(block);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+    *static_cast<void **>(block) = freeBlocks;
+    freeBlocks = block;
+    usedBlocksCount--;
+}
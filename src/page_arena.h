@@ -0,0 +1,42 @@
+#pragma once
+
+#include "src/memory.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+// Allocator of guest memory pages from a caller-provided region, for example the huge page arena of
+// ProcessorPool, so the pages processors actually write are covered by huge pages too. Every page is
+// allocated together with its reference count in one fixed-size block. Blocks are handed out lazily, so
+// untouched parts of the region are never faulted in. When the region is full, pages come from the heap.
+//
+// Pages must be released before the arena is destroyed, including pages shared with clones of the memory.
+class PageArena {
+public:
+    static constexpr size_t blockSize = Memory::pageSize + 64; // page and the control block of shared_ptr
+
+    PageArena(void *region, size_t regionSize);
+    ~PageArena();
+    PageArena(const PageArena &) = delete;
+    PageArena &operator=(const PageArena &) = delete;
+
+    std::shared_ptr<u8> allocatePage(); // zeroed page, safe to call and release from many threads
+    u32 getUsedBlocksCount() const;
+    bool isInArena(const void *address) const;
+
+private:
+    template <typename T>
+    friend class PageArenaAllocator;
+
+    void *allocateBlock(size_t size);
+    void freeBlock(void *block);
+
+    u8 *const region;
+    const size_t blocksCount;
+
+    mutable std::mutex mutex = {};
+    void *freeBlocks = nullptr; // freed blocks, linked through their first bytes
+    size_t unusedBlockIndex = 0;
+    u32 usedBlocksCount = 0;
+};
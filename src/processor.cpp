@@ -2,7 +2,6 @@
 #include "error.h"
 #include "processor.h"
 
-#include <cstring>
 #include <limits>
 
 #define INSTRUCTION_TRACE(...)                                  \
@@ -12,7 +11,55 @@
         }                                                       \
     } while (0)
 
+const char *getStopReasonName(StopReason stopReason) {
+    switch (stopReason) {
+    case StopReason::BudgetExhausted:
+        return "budget exhausted";
+    case StopReason::Hang:
+        return "hang";
+    case StopReason::Breakpoint:
+        return "breakpoint";
+    case StopReason::ReadWatchpoint:
+        return "read watchpoint";
+    case StopReason::WriteWatchpoint:
+        return "write watchpoint";
+    case StopReason::InvalidOpcode:
+        return "invalid opcode";
+    case StopReason::GuestError:
+        return "guest error";
+    case StopReason::GuestExit:
+        return "guest exit";
+    default:
+        return "unknown";
+    }
+}
+
+Processor::InstructionData Processor::instructionData[static_cast<u32>(OpCode::_MAX_VALUE) + 1] = {};
+
 Processor::Processor() {
+    initializeInstructionDataOnce();
+}
+
+bool Processor::isInstructionSupported(u8 opCode) {
+    initializeInstructionDataOnce();
+    return instructionData[opCode].exec != nullptr;
+}
+
+const char *Processor::getMnemonic(u8 opCode) {
+    initializeInstructionDataOnce();
+    return instructionData[opCode].mnemonic;
+}
+
+AddressingMode Processor::getAddressingMode(u8 opCode) {
+    initializeInstructionDataOnce();
+    return instructionData[opCode].addressingMode;
+}
+
+void Processor::initializeInstructionDataOnce() {
+    [[maybe_unused]] static const bool instructionDataInitialized = (initializeInstructionData(), true);
+}
+
+void Processor::initializeInstructionData() {
     setInstructionData("LDA", OpCode::LDA_imm, AddressingMode::Immediate, &Processor::executeLda);
     setInstructionData("LDA", OpCode::LDA_z, AddressingMode::ZeroPage, &Processor::executeLda);
     setInstructionData("LDA", OpCode::LDA_zx, AddressingMode::ZeroPageX, &Processor::executeLda);
@@ -198,38 +245,161 @@ Processor::Processor() {
     setInstructionData("RTI", OpCode::RTI, AddressingMode::Implied, &Processor::executeRti);
 }
 
-bool Processor::executeInstructions(u32 maxInstructionCount) {
+ExecutionResult Processor::executeInstructions(u32 maxInstructionCount) {
+    return execute(maxInstructionCount, 0);
+}
+
+ExecutionResult Processor::executeCycles(u32 minCycleCount) {
+    return execute(0, minCycleCount);
+}
+
+ExecutionResult Processor::execute(u32 maxInstructionCount, u32 minCycleCount) {
+    const Counters startCounters = counters;
+    ExecutionResult result{};
+    if (guestStopped) {
+        result.stopReason = guestError != nullptr ? StopReason::GuestError : StopReason::GuestExit;
+    } else if (debugFeatures.hostProfilingActive) {
+        debugFeatures.hostProfiler->beginExecution();
+        result.stopReason = executeLoop(maxInstructionCount, minCycleCount);
+        debugFeatures.hostProfiler->endExecution(counters.instructionsProcessed - startCounters.instructionsProcessed);
+    } else {
+        result.stopReason = executeLoop(maxInstructionCount, minCycleCount);
+    }
+
+    result.pc = result.stopReason == StopReason::Hang ? getHangAddress() : regs.pc;
+    result.instructionsExecuted = counters.instructionsProcessed - startCounters.instructionsProcessed;
+    result.cyclesExecuted = counters.cyclesProcessed - startCounters.cyclesProcessed;
+    return result;
+}
+
+StopReason Processor::executeLoop(u32 maxInstructionCount, u32 minCycleCount) {
+    StopReason stopReason = StopReason::BudgetExhausted;
+    const u32 startCycles = counters.cyclesProcessed;
     for (u32 instructionIndex = 0; maxInstructionCount == 0 || instructionIndex < maxInstructionCount; instructionIndex++) {
+        if (debugFeatures.breakpointsActive) {
+            if (isWatchpointHit(stopReason)) {
+                return stopReason;
+            }
+            if (debugFeatures.breakpoints.shouldBreakAt(regs.pc)) {
+                return StopReason::Breakpoint;
+            }
+        }
+
+        if (minCycleCount != 0 && counters.cyclesProcessed - startCycles >= minCycleCount) {
+            break;
+        }
+
+        if (debugFeatures.reverseExecutionActive && debugFeatures.checkpointHistory.isCheckpointNeeded(counters.instructionsProcessed)) {
+            debugFeatures.checkpointHistory.takeCheckpoint(regs, counters);
+        }
+
         const u8 opCode = fetchInstruction8();
         const InstructionData &instruction = instructionData[opCode];
         if (instruction.exec == nullptr) {
-            FATAL_ERROR("Unsupported instruction: 0x%02x", static_cast<u32>(opCode));
+            // Undo the fetch, so the processor stops at the opcode
+            regs.pc--;
+            counters.bytesProcessed--;
+            counters.cyclesProcessed--;
+            return StopReason::InvalidOpcode;
         }
 
         if (debugFeatures.hangDetectionActive) {
             debugFeatures.hangDetector.instruction(static_cast<OpCode>(opCode), regs.pc - 1);
             if (debugFeatures.hangDetector.isHangDetected()) {
-                return false;
+                return StopReason::Hang;
             }
         }
 
         if (debugFeatures.instructionTracingActive) {
-            debugFeatures.instructionTracer.beginInstruction(instructionIndex, static_cast<OpCode>(opCode), instruction.mnemonic, regs.pc - 1);
+            const u8 bytes[Disassembler::maxInstructionSize] = {opCode, memory.read(regs.pc), memory.read(static_cast<u16>(regs.pc + 1))};
+            debugFeatures.instructionTracer.beginInstruction(instructionIndex, regs.pc - 1, bytes);
+        }
+
+        if (debugFeatures.perOpCodeHostProfilingActive) {
+            debugFeatures.hostProfiler->beginInstruction();
         }
 
         (this->*instruction.exec)(instruction.addressingMode);
 
+        if (debugFeatures.perOpCodeHostProfilingActive) {
+            debugFeatures.hostProfiler->endInstruction(opCode);
+        }
+        if (guestStopped) {
+            // Failed instruction is not counted, but the one which requested exit has completed
+            if (guestError != nullptr) {
+                return StopReason::GuestError;
+            }
+            stopReason = StopReason::GuestExit;
+            maxInstructionCount = instructionIndex + 1;
+        }
+        counters.instructionsProcessed++;
+
         if (debugFeatures.instructionTracingActive) {
             debugFeatures.instructionTracer.endInstruction(regs.flags);
         }
     }
 
+    // Watchpoint could have been hit by the last instruction
+    if (debugFeatures.breakpointsActive) {
+        isWatchpointHit(stopReason);
+    }
+    return stopReason;
+}
+
+bool Processor::isWatchpointHit(StopReason &outStopReason) {
+    if (!debugFeatures.breakpoints.isWatchpointHit()) {
+        return false;
+    }
+    const bool isRead = debugFeatures.breakpoints.getWatchpointHitType() == Breakpoints::Type::Read;
+    outStopReason = isRead ? StopReason::ReadWatchpoint : StopReason::WriteWatchpoint;
+    debugFeatures.breakpoints.clearWatchpointHit();
     return true;
 }
 
+void Processor::reset() {
+    memory.reset();
+    counters = {};
+    guestStopped = false;
+    guestError = nullptr;
+
+    regs = {};
+    regs.sp = 0xFD;
+    regs.flags.i = 1;
+    regs.pc = constructU16(memory.read(0xFFFD), memory.read(0xFFFC));
+
+    debugFeatures.hangDetector.reset();
+    debugFeatures.checkpointHistory.reset();
+    debugFeatures.edgeCoverage.resetPreviousLocation();
+}
+
 void Processor::loadMemory(u32 start, u32 length, const u8 *data) {
     FATAL_ERROR_IF(start + length > memorySize, "Out of memory bounds.");
-    memcpy(memory + start, data, length);
+    if (debugFeatures.reverseExecutionActive && length > 0) {
+        const u32 firstPage = start / Memory::pageSize;
+        const u32 lastPage = (start + length - 1) / Memory::pageSize;
+        for (u32 page = firstPage; page <= lastPage; page++) {
+            debugFeatures.checkpointHistory.beforeWrite(static_cast<u16>(page * Memory::pageSize), memory);
+        }
+    }
+    memory.load(start, length, data);
+}
+
+void Processor::mapMemoryImage(const MemoryImage &image) {
+    if (debugFeatures.reverseExecutionActive) {
+        for (u32 page = 0; page < Memory::pagesCount; page++) {
+            debugFeatures.checkpointHistory.beforeWrite(static_cast<u16>(page * Memory::pageSize), memory);
+        }
+    }
+    memory.mapImage(image);
+}
+
+void Processor::unmapMemoryImages() {
+    if (debugFeatures.reverseExecutionActive) {
+        for (u32 page = 0; page < Memory::pagesCount; page++) {
+            debugFeatures.checkpointHistory.beforeWrite(static_cast<u16>(page * Memory::pageSize), memory);
+        }
+    }
+    memory.unmapImages();
 }
 
 void Processor::loadProgramCounter(u16 newPc) {
@@ -240,8 +410,217 @@ void Processor::activateHangDetector() {
     debugFeatures.hangDetectionActive = true;
 }
 
-void Processor::activateInstructionTracing() {
+void Processor::activateInstructionTracing(const SymbolTable *symbols) {
     debugFeatures.instructionTracingActive = true;
+    debugFeatures.instructionTracer.setSymbols(symbols);
+}
+
+void Processor::activateReverseExecution(u32 checkpointInterval, u32 maxCheckpointsCount) {
+    debugFeatures.reverseExecutionActive = true;
+    debugFeatures.checkpointHistory.setup(checkpointInterval, maxCheckpointsCount);
+}
+
+void Processor::activateEdgeCoverage(u8 *coverageMap) {
+    FATAL_ERROR_IF(coverageMap == nullptr, "Coverage map cannot be null");
+    debugFeatures.edgeCoverageActive = true;
+    debugFeatures.edgeCoverage.setMap(coverageMap);
+}
+
+void Processor::activateHostProfiler(HostProfiler *profiler) {
+    FATAL_ERROR_IF(profiler == nullptr, "Host profiler cannot be null");
+    debugFeatures.hostProfilingActive = true;
+    debugFeatures.perOpCodeHostProfilingActive = profiler->isPerOpCode();
+    debugFeatures.hostProfiler = profiler;
+}
+
+void Processor::attachSemihosting(Semihosting *newSemihosting) {
+    if (semihosting != nullptr) {
+        memory.untrapWrites(semihosting->getPageAddress() / Memory::pageSize);
+    }
+    semihosting = newSemihosting;
+    if (semihosting != nullptr) {
+        memory.trapWrites(semihosting->getPageAddress() / Memory::pageSize, this);
+    }
+}
+
+void Processor::setBreakpoint(u16 address) {
+    debugFeatures.breakpoints.set(Breakpoints::Type::Execute, address);
+    updateBreakpointsActive();
+}
+
+void Processor::clearBreakpoint(u16 address) {
+    debugFeatures.breakpoints.clear(Breakpoints::Type::Execute, address);
+    updateBreakpointsActive();
+}
+
+void Processor::setReadWatchpoint(u16 address) {
+    debugFeatures.breakpoints.set(Breakpoints::Type::Read, address);
+    updateBreakpointsActive();
+}
+
+void Processor::setWriteWatchpoint(u16 address) {
+    debugFeatures.breakpoints.set(Breakpoints::Type::Write, address);
+    updateBreakpointsActive();
+}
+
+void Processor::clearWatchpoints(u16 address) {
+    debugFeatures.breakpoints.clear(Breakpoints::Type::Read, address);
+    debugFeatures.breakpoints.clear(Breakpoints::Type::Write, address);
+    updateBreakpointsActive();
+}
+
+void Processor::updateBreakpointsActive() {
+    debugFeatures.watchpointsActive = debugFeatures.breakpoints.hasWatchpoints();
+    debugFeatures.breakpointsActive = debugFeatures.watchpointsActive || debugFeatures.breakpoints.hasBreakpoints();
+}
+
+void Processor::deactivateDebugFeatures() {
+    debugFeatures = {};
+}
+
+bool Processor::stepBack(u32 instructionCount) {
+    FATAL_ERROR_IF(!debugFeatures.reverseExecutionActive, "Reverse execution is not active");
+    if (instructionCount > counters.instructionsProcessed) {
+        return false;
+    }
+
+    const u32 targetInstructionIndex = counters.instructionsProcessed - instructionCount;
+    if (!restoreCheckpoint(targetInstructionIndex)) {
+        return false;
+    }
+    replayInstructions(targetInstructionIndex);
+    return counters.instructionsProcessed == targetInstructionIndex;
+}
+
+bool Processor::runBackToPc(u16 address, u32 maxInstructionCount) {
+    FATAL_ERROR_IF(!debugFeatures.reverseExecutionActive, "Reverse execution is not active");
+
+    // We don't know when the address was visited, so we have to scan intervals between checkpoints,
+    // starting from the newest one. Every scan replays at most one checkpoint interval. Visits older
+    // than the limit are ignored.
+    const u32 currentInstructionIndex = counters.instructionsProcessed;
+    const u32 lowestInstructionIndex = currentInstructionIndex > maxInstructionCount ? currentInstructionIndex - maxInstructionCount : 0;
+    const std::vector<u32> checkpointIndices = debugFeatures.checkpointHistory.getCheckpointIndices();
+    u32 intervalEnd = currentInstructionIndex;
+    for (auto it = checkpointIndices.rbegin(); it != checkpointIndices.rend() && intervalEnd > lowestInstructionIndex; it++) {
+        const u32 intervalBegin = *it;
+        if (intervalBegin >= intervalEnd) {
+            continue;
+        }
+
+        restoreCheckpoint(intervalBegin);
+        bool found = false;
+        u32 foundInstructionIndex = 0;
+        while (counters.instructionsProcessed < intervalEnd) {
+            if (regs.pc == address && counters.instructionsProcessed >= lowestInstructionIndex) {
+                found = true;
+                foundInstructionIndex = counters.instructionsProcessed;
+            }
+            const u32 replayedInstructionIndex = counters.instructionsProcessed;
+            replayInstructions(replayedInstructionIndex + 1);
+            if (counters.instructionsProcessed == replayedInstructionIndex) {
+                break; // replay stopped early, so this interval cannot be scanned further
+            }
+        }
+
+        if (found) {
+            restoreCheckpoint(foundInstructionIndex);
+            replayInstructions(foundInstructionIndex);
+            return true;
+        }
+        intervalEnd = intervalBegin;
+    }
+
+    // Address was not visited. Go back to where we started.
+    if (intervalEnd != currentInstructionIndex) {
+        restoreCheckpoint(currentInstructionIndex);
+        replayInstructions(currentInstructionIndex);
+    }
+    return false;
+}
+
+bool Processor::restoreCheckpoint(u32 instructionIndex) {
+    const Registers *checkpointRegs = debugFeatures.checkpointHistory.restore(instructionIndex, counters, memory);
+    if (checkpointRegs == nullptr) {
+        return false;
+    }
+
+    // Checkpoints are taken only while the guest runs, so a guest exit or error must have happened later
+    regs = *checkpointRegs;
+    guestStopped = false;
+    guestError = nullptr;
+    debugFeatures.hangDetector.reset();
+    debugFeatures.edgeCoverage.resetPreviousLocation();
+    return true;
+}
+
+void Processor::replayInstructions(u32 instructionIndex) {
+    if (instructionIndex <= counters.instructionsProcessed) {
+        return;
+    }
+
+    // Replayed instructions have already been seen, so don't report them again.
+    const bool hangDetectionActive = debugFeatures.hangDetectionActive;
+    const bool instructionTracingActive = debugFeatures.instructionTracingActive;
+    const bool breakpointsActive = debugFeatures.breakpointsActive;
+    const bool watchpointsActive = debugFeatures.watchpointsActive;
+    const bool edgeCoverageActive = debugFeatures.edgeCoverageActive;
+    const bool hostProfilingActive = debugFeatures.hostProfilingActive;
+    const bool perOpCodeHostProfilingActive = debugFeatures.perOpCodeHostProfilingActive;
+    debugFeatures.hangDetectionActive = false;
+    debugFeatures.instructionTracingActive = false;
+    debugFeatures.breakpointsActive = false;
+    debugFeatures.watchpointsActive = false;
+    debugFeatures.edgeCoverageActive = false;
+    debugFeatures.hostProfilingActive = false;
+    debugFeatures.perOpCodeHostProfilingActive = false;
+    Semihosting *const attachedSemihosting = semihosting;
+    semihosting = nullptr;
+    executeInstructions(instructionIndex - counters.instructionsProcessed);
+    semihosting = attachedSemihosting;
+    debugFeatures.hangDetectionActive = hangDetectionActive;
+    debugFeatures.instructionTracingActive = instructionTracingActive;
+    debugFeatures.breakpointsActive = breakpointsActive;
+    debugFeatures.watchpointsActive = watchpointsActive;
+    debugFeatures.edgeCoverageActive = edgeCoverageActive;
+    debugFeatures.hostProfilingActive = hostProfilingActive;
+    debugFeatures.perOpCodeHostProfilingActive = perOpCodeHostProfilingActive;
+    debugFeatures.breakpoints.resetHits();
+}
+
+ProcessorState Processor::saveState() {
+    ProcessorState state{};
+    state.regs = regs;
+    state.counters = counters;
+    state.memory = memory.clone();
+    return state;
+}
+
+void Processor::restoreState(ProcessorState &state) {
+    regs = state.regs;
+    counters = state.counters;
+    memory.assignShared(state.memory);
+    guestStopped = false;
+    guestError = nullptr;
+
+    debugFeatures.hangDetector.reset();
+    debugFeatures.checkpointHistory.reset();
+    debugFeatures.edgeCoverage.resetPreviousLocation();
+    debugFeatures.breakpoints.resetHits();
+}
+
+void Processor::raiseGuestError(const char *message) {
+    if (!guestStopped) {
+        guestStopped = true;
+        guestError = message;
+    }
+}
+
+void Processor::onTrappedWrite(u16 address, u8 value) {
+    // Semihosting is detached while instructions are replayed, so the guest does not repeat its output
+    if (semihosting != nullptr && semihosting->write(static_cast<u8>(address), value, regs, counters)) {
+        guestStopped = true;
+    }
 }
 
 u16 Processor::getHangAddress() const {
@@ -249,47 +628,60 @@ u16 Processor::getHangAddress() const {
 }
 
 u8 Processor::fetchInstruction8() {
-    const u8 result = readMemory8(regs.pc);
+    const u8 result = memory.read(regs.pc);
+    counters.cyclesProcessed += 1;
     counters.bytesProcessed += 1;
     regs.pc += 1;
     return result;
 }
 
 u16 Processor::fetchInstruction16() {
-    const u16 result = readMemory16(regs.pc);
+    const u16 result = constructU16(memory.read(regs.pc + 1), memory.read(regs.pc));
+    counters.cyclesProcessed += 2;
     counters.bytesProcessed += 2;
     regs.pc += 2;
     return result;
 }
 
 u8 Processor::readMemory8(u16 address) {
-    const u8 byte = memory[address];
+    watchMemory(Breakpoints::Type::Read, address);
+    const u8 byte = memory.read(address);
     counters.cyclesProcessed += 1;
     return byte;
 }
 
 u16 Processor::readMemory16(u16 address) {
-    const u8 lo = memory[address];
-    const u8 hi = memory[address + 1];
+    watchMemory(Breakpoints::Type::Read, address);
+    watchMemory(Breakpoints::Type::Read, address + 1);
+    const u8 lo = memory.read(address);
+    const u8 hi = memory.read(address + 1);
     counters.cyclesProcessed += 2;
     return (hi << 8) | lo;
 }
 
 void Processor::writeMemory8(u16 address, u8 byte) {
-    memory[address] = byte;
+    storeMemory8(address, byte);
     counters.cyclesProcessed += 1;
 }
 
+void Processor::storeMemory8(u16 address, u8 byte) {
+    watchMemory(Breakpoints::Type::Write, address);
+    if (debugFeatures.reverseExecutionActive) {
+        debugFeatures.checkpointHistory.beforeWrite(address, memory);
+    }
+    memory.write(address, byte);
+}
+
 u16 Processor::getAddress(AddressingMode mode, bool isReadOnly) {
     switch (mode) {
     case AddressingMode::Accumulator: {
-        FATAL_ERROR("Cannot get address in accumulator addressing mode");
+        DEBUG_UNREACHABLE_CODE("Cannot get address in accumulator addressing mode");
     }
     case AddressingMode::Implied: {
-        FATAL_ERROR("Cannot get address in implied addressing mode");
+        DEBUG_UNREACHABLE_CODE("Cannot get address in implied addressing mode");
     }
     case AddressingMode::Immediate: {
-        FATAL_ERROR("Cannot get address in immediate addressing mode");
+        DEBUG_UNREACHABLE_CODE("Cannot get address in immediate addressing mode");
     }
     case AddressingMode::ZeroPage: {
         return fetchInstruction8();
@@ -331,7 +723,7 @@ u16 Processor::getAddress(AddressingMode mode, bool isReadOnly) {
         return sumAddresses(regs.pc, offset, isReadOnly);
     }
     default: {
-        FATAL_ERROR("Unknown addressing mode");
+        DEBUG_UNREACHABLE_CODE("Unknown addressing mode");
     }
     }
 }
@@ -416,7 +808,7 @@ u16 Processor::sumAddressesZeroPage(u8 base, u8 offset) {
 template <typename RegT>
 void Processor::registerTransfer(RegT &dst, const RegT &src) {
     static_assert(sizeof(RegT) == 1);
-    FATAL_ERROR_IF(&dst == &src, "Cannot do register transfer on one register");
+    DEBUG_ASSERT(&dst != &src, "Cannot do register transfer on one register");
     counters.cyclesProcessed++;
     dst = src;
 }
@@ -441,7 +833,7 @@ void Processor::updateArithmeticFlags(u8 value) {
 void Processor::updateFlagsAfterComparison(u8 registerValue, u8 inputValue) {
     regs.flags.c = registerValue >= inputValue;
     regs.flags.z = registerValue == inputValue;
-    regs.flags.n = registerValue < inputValue;
+    regs.flags.n = isSignBitSet(static_cast<u8>(registerValue - inputValue)); // sign of the difference, not the ordering
 
     INSTRUCTION_TRACE("reg=0x%02x val=0x%02x", registerValue, inputValue);
 }
@@ -469,10 +861,10 @@ void Processor::sumDecimal(u8 addend) {
     const u8 hiAddend = hiNibble(addend);
 
     // We'll have to handle it somehow, but don't care for now
-    FATAL_ERROR_IF(loReg >= 10, "Invalid BCD");
-    FATAL_ERROR_IF(hiReg >= 10, "Invalid BCD");
-    FATAL_ERROR_IF(loAddend >= 10, "Invalid BCD");
-    FATAL_ERROR_IF(hiAddend >= 10, "Invalid BCD");
+    if (loReg >= 10 || hiReg >= 10 || loAddend >= 10 || hiAddend >= 10) {
+        raiseGuestError("Invalid BCD");
+        return;
+    }
 
     // Calculate sum
     u8 lo = loReg + loAddend + regs.flags.c;
@@ -495,6 +887,41 @@ void Processor::sumDecimal(u8 addend) {
     regs.a = constructU8(hi, lo);
 }
 
+void Processor::subtractDecimal(u8 subtrahend) {
+    // Extract nibbles from both operands
+    const u8 loReg = loNibble(regs.a);
+    const u8 hiReg = hiNibble(regs.a);
+    const u8 loSubtrahend = loNibble(subtrahend);
+    const u8 hiSubtrahend = hiNibble(subtrahend);
+
+    // Results for digits above 9 are not emulated. Real 6502 produces undocumented values for them, which
+    // programs shouldn't depend on, so they are reported as a guest error like in sumDecimal.
+    if (loReg >= 10 || hiReg >= 10 || loSubtrahend >= 10 || hiSubtrahend >= 10) {
+        raiseGuestError("Invalid BCD");
+        return;
+    }
+
+    // Calculate difference, cleared carry means borrow
+    int lo = loReg - loSubtrahend - (1 - regs.flags.c);
+    int hi = hiReg - hiSubtrahend;
+
+    // Borrow from high nibble to low nibble
+    if (lo < 0) {
+        lo += 10;
+        hi -= 1;
+    }
+
+    // Borrow from carry flag
+    regs.flags.c = 1;
+    if (hi < 0) {
+        hi += 10;
+        regs.flags.c = 0;
+    }
+
+    // Store result
+    regs.a = constructU8(static_cast<u8>(hi), static_cast<u8>(lo));
+}
+
 void Processor::pushToStack8(u8 value) {
     // 1 cycle for writing value
     // 1 cycle for decrementing stack pointer
@@ -502,10 +929,10 @@ void Processor::pushToStack8(u8 value) {
 
     constexpr u16 stackBase = 0x0100;
     const u16 address = stackBase + regs.sp;
-    memory[address] = value;
+    storeMemory8(address, value);
     regs.sp--;
 
-    INSTRUCTION_TRACE("StackPush(memory[0x%04x]<-0x%02x, sp=0x%02x)", address, memory[address], regs.sp);
+    INSTRUCTION_TRACE("StackPush(memory[0x%04x]<-0x%02x, sp=0x%02x)", address, memory.read(address), regs.sp);
 }
 
 void Processor::pushToStack16(u16 value) {
@@ -515,13 +942,13 @@ void Processor::pushToStack16(u16 value) {
 
     constexpr u16 stackBase = 0x0100;
     const u16 address = stackBase + regs.sp;
-    memory[address] = hi(value);
-    memory[address - 1] = lo(value);
+    storeMemory8(address, hi(value));
+    storeMemory8(address - 1, lo(value));
     regs.sp -= 2;
 
     INSTRUCTION_TRACE("StackPush(memory[0x%04x]=0x%02x, memory[0x%04x]=0x%02x, sp=0x%02x)",
-                      address, memory[address],
-                      address - 1, memory[address - 1],
+                      address, memory.read(address),
+                      address - 1, memory.read(address - 1),
                       regs.sp);
 }
 
@@ -534,8 +961,9 @@ u8 Processor::popFromStack8() {
     regs.sp++;
     const u16 address = stackBase + regs.sp;
 
-    INSTRUCTION_TRACE("StackPop(0x%02x<-memory[0x%04x], sp=0x%02x)", memory[address], address, regs.sp);
-    return memory[address];
+    INSTRUCTION_TRACE("StackPop(0x%02x<-memory[0x%04x], sp=0x%02x)", memory.read(address), address, regs.sp);
+    watchMemory(Breakpoints::Type::Read, address);
+    return memory.read(address);
 }
 
 u16 Processor::popFromStack16() {
@@ -548,12 +976,14 @@ u16 Processor::popFromStack16() {
     const u16 address = stackBase + regs.sp;
 
     INSTRUCTION_TRACE("StackPop(0x%02x<-memory[0x%04x], 0x%02x<-memory[0x%04x], sp=0x%02x)",
-                      memory[address - 1], address - 1,
-                      memory[address], address,
+                      memory.read(address - 1), address - 1,
+                      memory.read(address), address,
                       regs.sp);
 
-    const u8 lo = memory[address - 1];
-    const u8 hi = memory[address];
+    watchMemory(Breakpoints::Type::Read, address - 1);
+    watchMemory(Breakpoints::Type::Read, address);
+    const u8 lo = memory.read(address - 1);
+    const u8 hi = memory.read(address);
     return constructU16(hi, lo);
 }
 
@@ -848,7 +1278,8 @@ void Processor::executeSbc(AddressingMode mode) {
     const u8 value = readValue(mode, true);
 
     if (regs.flags.d) {
-        FATAL_ERROR("Not implemented");
+        subtractDecimal(value);
+        INSTRUCTION_TRACE("0x%02x-0x%02x-(0x1-0%x)=0x%02x (BCD)", srcRegA, value, srcCarry, regs.a);
     } else {
         sumWithCarry(~value);
         INSTRUCTION_TRACE("0x%02x-0x%02x-(0x1-0%x)=0x%02x+0x%02x+0%x=0x%02x",
@@ -861,12 +1292,14 @@ void Processor::executeSbc(AddressingMode mode) {
 void Processor::executeJmp(AddressingMode mode) {
     const u16 address = getAddress(mode, true);
     regs.pc = address;
+    reportEdge();
 }
 
 void Processor::executeJsr(AddressingMode mode) {
     const u16 calledAddress = getAddress(mode, true);
     pushToStack16(regs.pc - 1);
     regs.pc = calledAddress;
+    reportEdge();
 }
 
 void Processor::executeRts(AddressingMode) {
@@ -874,6 +1307,7 @@ void Processor::executeRts(AddressingMode) {
     const u16 returnAddress = popFromStack16() + 1;
     aluOperation(); // Incrementing PC
     regs.pc = returnAddress;
+    reportEdge();
 }
 
 void Processor::executeBranch(AddressingMode mode, bool take) {
@@ -888,6 +1322,7 @@ void Processor::executeBranch(AddressingMode mode, bool take) {
 
         INSTRUCTION_TRACE("NotBranched");
     }
+    reportEdge();
 }
 
 void Processor::executeBcc(AddressingMode mode) {
@@ -939,6 +1374,7 @@ void Processor::executeBrk(AddressingMode) {
 
     regs.pc = readMemory16(0xFFFE);
     regs.flags.i = 1;
+    reportEdge();
 }
 
 void Processor::executeRti(AddressingMode) {
@@ -954,4 +1390,5 @@ void Processor::executeRti(AddressingMode) {
     regs.flags = newFlags;
     regs.pc = constructU16(pcHi, pcLo);
     aluOperation();
+    reportEdge();
 }
@@ -1,12 +1,16 @@
 #pragma once
 
+#include "src/breakpoints.h"
+#include "src/checkpoint_history.h"
 #include "src/counters.h"
+#include "src/edge_coverage.h"
 #include "src/hang_detector.h"
+#include "src/host_profiler.h"
 #include "src/instruction_tracer.h"
 #include "src/instructions.h"
+#include "src/memory.h"
 #include "src/registers.h"
-
-constexpr u32 memorySize = 64 * 1024;
+#include "src/semihosting.h"
 
 enum class AddressingMode {
     Accumulator,
@@ -24,20 +28,103 @@ enum class AddressingMode {
     Relative,
 };
 
-class Processor {
+// Reason, why an execution function returned
+enum class StopReason {
+    BudgetExhausted, // requested number of instructions or cycles was executed
+    Hang,
+    Breakpoint,
+    ReadWatchpoint,
+    WriteWatchpoint,
+    InvalidOpcode, // pc points to the opcode, which was not executed
+    GuestError,    // instruction could not be completed, see Processor::getGuestError()
+    GuestExit,     // guest program exited through semihosting, see Semihosting::getExitCode()
+};
+const char *getStopReasonName(StopReason stopReason);
+
+struct ExecutionResult {
+    StopReason stopReason = StopReason::BudgetExhausted;
+    u16 pc = 0; // address of the hung instruction for StopReason::Hang
+    u32 instructionsExecuted = 0;
+    u32 cyclesExecuted = 0;
+
+    // True, if the requested number of instructions or cycles was executed
+    explicit operator bool() const { return stopReason == StopReason::BudgetExhausted; }
+};
+
+// Complete architectural state of a processor. Memory pages are shared with the processor, so saving
+// the state costs only as much as the pages written afterwards.
+struct ProcessorState {
+    Registers regs = {};
+    Counters counters = {};
+    Memory memory = {};
+};
+
+class Processor : protected MemoryWriteTrap {
 
 public:
     Processor();
+    Processor(const Processor &) = delete;
+    Processor &operator=(const Processor &) = delete;
+
+    // Brings the processor to the state after reset. Memory pages modified since the last reset are dropped and
+    // memory images stay mapped. Program counter is loaded from the reset vector.
+    void reset();
 
     void loadMemory(u32 start, u32 length, const u8 *data);
+    void mapMemoryImage(const MemoryImage &image);
+    void unmapMemoryImages(); // all memory goes back to zero
     void loadProgramCounter(u16 newPc);
     void activateHangDetector();
-    void activateInstructionTracing();
-    bool executeInstructions(u32 maxInstructionCount);
+    void activateInstructionTracing(const SymbolTable *symbols = nullptr); // symbols are owned by the caller
+    void activateReverseExecution(u32 checkpointInterval, u32 maxCheckpointsCount);
+    void activateEdgeCoverage(u8 *coverageMap); // map must have EdgeCoverage::mapSize bytes
+    void activateHostProfiler(HostProfiler *profiler); // profiler is owned by the caller
+    void setPageArena(PageArena *arena) { memory.setPageArena(arena); } // arena is owned by the caller
+    void deactivateDebugFeatures();
+
+    // Semihosting page is trapped in the memory of this processor. Semihosting is owned by the caller.
+    // Passing nullptr detaches it and the page becomes regular memory again.
+    void attachSemihosting(Semihosting *semihosting);
+
+    // Breakpoints stop the execution before the instruction at given address. Watchpoints stop the execution
+    // after the instruction, which accessed given address. When no points are set, they cost nothing.
+    void setBreakpoint(u16 address);
+    void clearBreakpoint(u16 address);
+    void setReadWatchpoint(u16 address);
+    void setWriteWatchpoint(u16 address);
+    void clearWatchpoints(u16 address);
+
+    ExecutionResult executeInstructions(u32 maxInstructionCount);
+    ExecutionResult executeCycles(u32 minCycleCount); // executes whole instructions until at least given number of cycles passes
+
+    // Reverse execution. Processor is brought back to the nearest checkpoint and deterministically
+    // replayed to the target instruction. Both functions return false if the target could not be reached.
+    // Running back searches at most given number of instructions back, so an address, which was never
+    // visited, doesn't cost replaying the whole history.
+    static constexpr u32 defaultRunBackLimit = 1'000'000;
+    bool stepBack(u32 instructionCount);
+    bool runBackToPc(u16 address, u32 maxInstructionCount = defaultRunBackLimit);
+
+    // Saved state can be restored multiple times. Restoring resets debug features history.
+    ProcessorState saveState();
+    void restoreState(ProcessorState &state);
 
     u16 getHangAddress() const;
+    const char *getGuestError() const { return guestError; } // nullptr, if there was no error
+    u16 getWatchpointAddress() const { return debugFeatures.breakpoints.getWatchpointHitAddress(); }
+    const Registers &getRegisters() const { return regs; }
+    const Counters &getCounters() const { return counters; }
+    const Memory &getMemory() const { return memory; }
+
+    static bool isInstructionSupported(u8 opCode);
+    static const char *getMnemonic(u8 opCode); // nullptr for unsupported opcodes
+    static AddressingMode getAddressingMode(u8 opCode);
 
 protected:
+    // Main execution loop. Zero means no limit.
+    ExecutionResult execute(u32 maxInstructionCount, u32 minCycleCount);
+    StopReason executeLoop(u32 maxInstructionCount, u32 minCycleCount);
+
     // Helper functions to fetch from instruction stream. They increase cycle counter and program counter.
     u8 fetchInstruction8();
     u16 fetchInstruction16();
@@ -47,6 +134,19 @@ protected:
     u16 readMemory16(u16 address);
     void writeMemory8(u16 address, u8 byte);
 
+    // Helper function to modify the memory without increasing cycle counter. All memory modifications
+    // must go through it, so debug features can observe them.
+    void storeMemory8(u16 address, u8 byte);
+
+    // Helper function for watchpoints. Called for every data access.
+    void watchMemory(Breakpoints::Type type, u16 address) {
+        if (debugFeatures.watchpointsActive) {
+            debugFeatures.breakpoints.access(type, address);
+        }
+    }
+    bool isWatchpointHit(StopReason &outStopReason);
+    void updateBreakpointsActive();
+
     // Helper functions to resolve addresses for different addressing modes.
     u16 getAddress(AddressingMode mode, bool isReadOnly);
     u8 readValue(AddressingMode mode, bool isReadOnly, u16 *outAddress = nullptr);
@@ -71,6 +171,12 @@ protected:
     // Helper functions for arithmetic operations
     void sumWithCarry(u8 addend);
     void sumDecimal(u8 addend);
+    void subtractDecimal(u8 subtrahend);
+
+    // Guest errors and guest exit are sticky. Execution functions return immediately, until the processor is
+    // reset or restored.
+    void raiseGuestError(const char *message);
+    void onTrappedWrite(u16 address, u8 value) override; // called for writes to the semihosting page
 
     // Helper functions for stack operations
     void pushToStack8(u8 value);
@@ -137,18 +243,56 @@ protected:
     void executeBrk(AddressingMode mode);
     void executeRti(AddressingMode mode);
 
+    // Helper function for edge coverage. Called by control flow instructions after updating program counter.
+    void reportEdge() {
+        if (debugFeatures.edgeCoverageActive) {
+            debugFeatures.edgeCoverage.edge(regs.pc);
+        }
+    }
+
+    // Engines executing guest code without this processor must fall back to it, when any of them is active
+    bool isAnyDebugFeatureActive() const {
+        return debugFeatures.hangDetectionActive ||
+               debugFeatures.instructionTracingActive ||
+               debugFeatures.reverseExecutionActive ||
+               debugFeatures.edgeCoverageActive ||
+               debugFeatures.hostProfilingActive ||
+               debugFeatures.breakpointsActive;
+    }
+
+    // Helper functions for reverse execution.
+    bool restoreCheckpoint(u32 instructionIndex);
+    void replayInstructions(u32 instructionIndex);
+
     struct DebugFeatures {
         bool hangDetectionActive = false;
         HangDetector hangDetector = {};
 
         bool instructionTracingActive = false;
         InstructionTracer instructionTracer = {};
+
+        bool reverseExecutionActive = false;
+        CheckpointHistory checkpointHistory = {};
+
+        bool edgeCoverageActive = false;
+        EdgeCoverage edgeCoverage = {};
+
+        bool hostProfilingActive = false;
+        bool perOpCodeHostProfilingActive = false;
+        HostProfiler *hostProfiler = nullptr;
+
+        bool breakpointsActive = false; // set if there are any breakpoints or watchpoints
+        bool watchpointsActive = false;
+        Breakpoints breakpoints = {};
     } debugFeatures;
 
     // State of the CPU.
     Counters counters = {};
+    bool guestStopped = false; // set by guest error or guest exit
+    const char *guestError = nullptr;
+    Semihosting *semihosting = nullptr;
     Registers regs = {};
-    u8 memory[memorySize] = {};
+    Memory memory = {};
 
     // Metadata for instruction executing.
     struct InstructionData {
@@ -157,8 +301,11 @@ protected:
         AddressingMode addressingMode = {};
         ExecFunction exec = nullptr;
     };
-    InstructionData instructionData[static_cast<u8>(OpCode::_MAX_VALUE)];
-    void setInstructionData(const char *mnemonic, OpCode opCode, AddressingMode addressingMode, InstructionData::ExecFunction exec) {
+    // Instruction metadata does not depend on processor state, so it's shared by all processors and initialized only once.
+    static InstructionData instructionData[static_cast<u32>(OpCode::_MAX_VALUE) + 1];
+    static void initializeInstructionData();
+    static void initializeInstructionDataOnce();
+    static void setInstructionData(const char *mnemonic, OpCode opCode, AddressingMode addressingMode, InstructionData::ExecFunction exec) {
         u8 index = static_cast<u8>(opCode);
         instructionData[index].mnemonic = mnemonic;
         instructionData[index].addressingMode = addressingMode;
@@ -0,0 +1,68 @@
+#include "processor_pool.h"
+
+#include "src/error.h"
+#include "src/os_memory.h"
+
+#include <new>
+
+ProcessorPool::ProcessorPool(u32 capacity, u32 pagesPerProcessor)
+    : capacity(capacity),
+      slotSize((sizeof(Processor) + cacheLineSize - 1) / cacheLineSize * cacheLineSize),
+      slotsSize(slotSize * capacity),
+      arenaSize(slotsSize + PageArena::blockSize * pagesPerProcessor * capacity) {
+    static_assert(alignof(Processor) <= cacheLineSize);
+    static_assert(PageArena::blockSize % cacheLineSize == 0);
+    FATAL_ERROR_IF(capacity == 0, "Pool capacity cannot be 0");
+
+    arena = static_cast<u8 *>(OsMemory::allocateHugePages(arenaSize));
+    pageArena = std::make_unique<PageArena>(arena + slotsSize, arenaSize - slotsSize);
+    freeSlots.reserve(capacity);
+    for (u32 slotIndex = 0; slotIndex < capacity; slotIndex++) {
+        Processor *processor = new (getSlot(slotIndex)) Processor();
+        processor->setPageArena(pageArena.get());
+        freeSlots.push_back(capacity - slotIndex - 1);
+    }
+}
+
+ProcessorPool::~ProcessorPool() {
+    // Destructors must not throw, it would terminate the process and hide the error being unwound
+    if (freeSlots.size() != capacity) {
+        Error::log(stderr, "ERROR", "Processors were not released to the pool");
+    }
+
+    for (u32 slotIndex = 0; slotIndex < capacity; slotIndex++) {
+        getSlot(slotIndex)->~Processor();
+    }
+    pageArena.reset();
+    OsMemory::freeHugePages(arena, arenaSize);
+}
+
+Processor *ProcessorPool::acquire() {
+    u32 slotIndex = 0;
+    {
+        std::lock_guard<std::mutex> lock{freeSlotsMutex};
+        if (freeSlots.empty()) {
+            return nullptr;
+        }
+        slotIndex = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    Processor *processor = getSlot(slotIndex);
+    processor->reset();
+    return processor;
+}
+
+void ProcessorPool::release(Processor *processor) {
+    const size_t offset = reinterpret_cast<u8 *>(processor) - arena;
+    FATAL_ERROR_IF(offset >= slotsSize || offset % slotSize != 0, "Processor does not belong to the pool");
+
+    processor->deactivateDebugFeatures();
+
+    std::lock_guard<std::mutex> lock{freeSlotsMutex};
+    freeSlots.push_back(static_cast<u32>(offset / slotSize));
+}
+
+Processor *ProcessorPool::getSlot(u32 index) const {
+    return reinterpret_cast<Processor *>(arena + index * slotSize);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "src/page_arena.h"
+#include "src/processor.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Pool of processors, which can be reused between jobs without constructing them again. All processors are
+// placed in one arena backed by huge pages. Each of them starts at a cache line boundary, so processors used
+// by different threads never share a cache line. Guest memory pages written by the processors are allocated
+// from the same arena, after the processors, until it's full.
+class ProcessorPool {
+public:
+    constexpr static size_t cacheLineSize = 64;
+    constexpr static u32 defaultPagesPerProcessor = 16;
+
+    explicit ProcessorPool(u32 capacity, u32 pagesPerProcessor = defaultPagesPerProcessor);
+    ~ProcessorPool();
+    ProcessorPool(const ProcessorPool &) = delete;
+    ProcessorPool &operator=(const ProcessorPool &) = delete;
+
+    // Returns a processor after reset or nullptr, if all processors are in use. It's safe to call from many threads.
+    Processor *acquire();
+    void release(Processor *processor);
+
+    u32 getCapacity() const { return capacity; }
+    const PageArena &getPageArena() const { return *pageArena; }
+
+private:
+    Processor *getSlot(u32 index) const;
+
+    const u32 capacity;
+    const size_t slotSize;
+    const size_t slotsSize;
+    const size_t arenaSize;
+    u8 *arena = nullptr;
+    std::unique_ptr<PageArena> pageArena = {};
+
+    std::mutex freeSlotsMutex = {};
+    std::vector<u32> freeSlots = {};
+};
@@ -0,0 +1,114 @@
+#include "recompiled_processor.h"
+
+#include "src/error.h"
+
+#include <algorithm>
+
+RecompiledProcessor::RecompiledProcessor(const RecompiledProgram &program)
+    : program(program),
+      blockIndices(memorySize, noBlock),
+      blockStates(program.blocksCount, BlockState{0, false}) {
+    for (u32 blockIndex = 0; blockIndex < program.blocksCount; blockIndex++) {
+        const RecompiledBlock &block = program.blocks[blockIndex];
+        FATAL_ERROR_IF(block.size == 0 || block.start + block.size > memorySize, "Invalid recompiled block at 0x%04x", block.start);
+        FATAL_ERROR_IF(blockIndices[block.start] != noBlock, "Duplicated recompiled block at 0x%04x", block.start);
+        blockIndices[block.start] = blockIndex;
+        maxBlockSize = std::max(maxBlockSize, static_cast<u32>(block.size));
+
+        for (u32 pageIndex = block.start / Memory::pageSize; pageIndex <= (block.start + block.size - 1u) / Memory::pageSize; pageIndex++) {
+            memory.trapWrites(pageIndex, this);
+        }
+        for (u32 address = block.start; address < block.start + block.size; address++) {
+            codeBytes[address] = true;
+        }
+    }
+}
+
+ExecutionResult RecompiledProcessor::executeRecompiled(u32 maxInstructionCount) {
+    if (guestStopped || isAnyDebugFeatureActive()) {
+        return execute(maxInstructionCount, 0);
+    }
+
+    // Memory could have been changed outside of the guest since the last call
+    generation++;
+
+    const Counters startCounters = counters;
+    ExecutionResult result{};
+    while (true) {
+        const u32 executedCount = counters.instructionsProcessed - startCounters.instructionsProcessed;
+        if (maxInstructionCount != 0 && executedCount >= maxInstructionCount) {
+            break;
+        }
+
+        const u32 blockIndex = blockIndices[regs.pc];
+        if (blockIndex != noBlock &&
+            (maxInstructionCount == 0 || program.blocks[blockIndex].instructionsCount <= maxInstructionCount - executedCount) &&
+            isBlockValid(blockIndex)) {
+            if (!program.blocks[blockIndex].function(*this)) {
+                blockExitRequested = false;
+                if (guestStopped) {
+                    result.stopReason = guestError != nullptr ? StopReason::GuestError : StopReason::GuestExit;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        const u32 interpretedStart = counters.instructionsProcessed;
+        result.stopReason = executeLoop(1, 0);
+        interpretedInstructionsCount += counters.instructionsProcessed - interpretedStart;
+        blockExitRequested = false;
+        if (result.stopReason != StopReason::BudgetExhausted) {
+            break;
+        }
+    }
+
+    result.pc = regs.pc;
+    result.instructionsExecuted = counters.instructionsProcessed - startCounters.instructionsProcessed;
+    result.cyclesExecuted = counters.cyclesProcessed - startCounters.cyclesProcessed;
+    return result;
+}
+
+bool RecompiledProcessor::isBlockValid(u32 blockIndex) {
+    BlockState &state = blockStates[blockIndex];
+    if (state.verifiedGeneration != generation) {
+        const RecompiledBlock &block = program.blocks[blockIndex];
+        state.isValid = true;
+        for (u32 offset = 0; offset < block.size; offset++) {
+            if (memory.read(static_cast<u16>(block.start + offset)) != block.bytes[offset]) {
+                state.isValid = false;
+                break;
+            }
+        }
+        state.verifiedGeneration = generation;
+    }
+    return state.isValid;
+}
+
+bool RecompiledProcessor::invalidateBlocks(u16 address) {
+    bool isCode = false;
+    const u32 firstStart = address >= maxBlockSize ? address - maxBlockSize + 1 : 0;
+    for (u32 start = firstStart; start <= address; start++) {
+        const u32 blockIndex = blockIndices[start];
+        if (blockIndex != noBlock && address < start + program.blocks[blockIndex].size) {
+            blockStates[blockIndex].verifiedGeneration = 0;
+            isCode = true;
+        }
+    }
+    return isCode;
+}
+
+void RecompiledProcessor::onTrappedWrite(u16 address, u8 value) {
+    if (semihosting != nullptr && address / Memory::pageSize == semihosting->getPageAddress() / Memory::pageSize) {
+        Processor::onTrappedWrite(address, value);
+        blockExitRequested |= guestStopped;
+        return;
+    }
+
+    // Page with recompiled code. Blocks are verified again only if the code actually changed.
+    u8 &byte = memory[address];
+    if (codeBytes[address] && byte != value) {
+        blockExitRequested |= invalidateBlocks(address);
+    }
+    byte = value;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "src/bit_operations.h"
+#include "src/processor.h"
+
+#include <bitset>
+#include <vector>
+
+class RecompiledProcessor;
+
+// Basic block translated ahead of time to C++ by emos_recompile. The function executes all instructions of
+// the block and leaves the program counter at the next instruction. It returns false if it had to stop
+// earlier, because the guest stopped or modified code. Instructions are counted as they complete, so the
+// processor is then in the same state as after the interpreter executed the same instructions.
+struct RecompiledBlock {
+    using Function = bool (*)(RecompiledProcessor &processor);
+
+    u16 start;
+    u16 size;
+    u32 instructionsCount;
+    const u8 *bytes; // code the block was translated from, block is used only if the memory still contains it
+    Function function;
+};
+
+struct RecompiledProgram {
+    const RecompiledBlock *blocks;
+    u32 blocksCount;
+};
+
+// Processor executing recompiled blocks of a firmware and falling back to the interpreter for everything
+// else: code not found statically, like targets of computed jumps, blocks whose code was modified, BRK and
+// RTI, and instructions not fitting in the instruction budget. Counters and guest-visible state are exactly
+// the same as if the whole program was interpreted.
+//
+// Pages with recompiled code are trapped in the memory, so writes to them are noticed both in recompiled
+// and in interpreted code. Memory can also be changed by loading it or restoring a state, so every block is
+// compared with the memory once per execution call before it's used. Traps work on whole pages, so data
+// writes to a page shared with code also take the trap path. They skip the search for modified blocks, but
+// still cost about 12x more than a regular write, see RecompiledWrite benchmarks. Programs keeping hot data
+// next to code should be linked with data on separate pages. Debug features need to observe every
+// instruction, so they make the whole execution interpreted.
+class RecompiledProcessor : public Processor {
+public:
+    explicit RecompiledProcessor(const RecompiledProgram &program); // program is owned by the caller
+
+    // Equivalent of executeInstructions(). Zero means no limit.
+    ExecutionResult executeRecompiled(u32 maxInstructionCount);
+
+    u32 getInterpretedInstructionsCount() const { return interpretedInstructionsCount; }
+
+    // Interface of the generated code. Cycles are accounted by the generated code, so these helpers
+    // only perform the accesses.
+    using Processor::counters;
+    using Processor::guestStopped;
+    using Processor::regs;
+    using Processor::subtractDecimal;
+    using Processor::sumDecimal;
+
+    u8 read(u16 address) const {
+        return memory.read(address);
+    }
+    u16 read16(u16 address) const {
+        return constructU16(memory.read(address + 1), memory.read(address));
+    }
+    static u32 isPageCrossed(u16 base, u16 address) {
+        return (base & 0xFF00) != (address & 0xFF00);
+    }
+
+    // Functions modifying the memory return true, if the block must stop after current instruction
+    bool write(u16 address, u8 value) {
+        memory.write(address, value);
+        return blockExitRequested;
+    }
+    bool push8(u8 value) {
+        const bool exitRequested = write(stackBase + regs.sp, value);
+        regs.sp--;
+        return exitRequested;
+    }
+    bool push16(u16 value) {
+        const u16 address = stackBase + regs.sp;
+        bool exitRequested = write(address, hi(value));
+        exitRequested |= write(address - 1, lo(value));
+        regs.sp -= 2;
+        return exitRequested;
+    }
+    u8 pop8() {
+        regs.sp++;
+        return memory.read(stackBase + regs.sp);
+    }
+    u16 pop16() {
+        regs.sp += 2;
+        const u16 address = stackBase + regs.sp;
+        return constructU16(memory.read(address), memory.read(address - 1));
+    }
+
+    void setArithmeticFlags(u8 value) {
+        regs.flags.z = value == 0;
+        regs.flags.n = isSignBitSet(value);
+    }
+    void compare(u8 registerValue, u8 inputValue) {
+        regs.flags.c = registerValue >= inputValue;
+        regs.flags.z = registerValue == inputValue;
+        regs.flags.n = isSignBitSet(static_cast<u8>(registerValue - inputValue));
+    }
+    void addBinary(u8 addend) {
+        const u16 sum16 = u16(regs.a) + u16(addend) + u16(regs.flags.c);
+        const u8 sum8 = static_cast<u8>(sum16);
+        regs.flags.o = isSignBitSet(regs.a) == isSignBitSet(addend) && isSignBitSet(regs.a) != isSignBitSet(sum8);
+        regs.flags.c = sum16 > 0xFF;
+        setArithmeticFlags(sum8);
+        regs.a = sum8;
+    }
+
+    // Decimal arithmetic can raise a guest error. Returns false in such case.
+    bool add(u8 addend) {
+        if (regs.flags.d) {
+            sumDecimal(addend);
+            return !guestStopped;
+        }
+        addBinary(addend);
+        return true;
+    }
+    bool subtract(u8 subtrahend) {
+        if (regs.flags.d) {
+            subtractDecimal(subtrahend);
+            return !guestStopped;
+        }
+        addBinary(~subtrahend);
+        return true;
+    }
+
+    // Counters are updated in batches, before the state can be observed and at the end of the block
+    void advance(u32 cycles, u32 bytes, u32 instructions, u16 pc) {
+        counters.cyclesProcessed += cycles;
+        counters.bytesProcessed += bytes;
+        counters.instructionsProcessed += instructions;
+        regs.pc = pc;
+    }
+
+protected:
+    static constexpr u16 stackBase = 0x0100;
+    static constexpr u32 noBlock = 0xFFFFFFFF;
+
+    struct BlockState {
+        u32 verifiedGeneration; // code was compared with the memory during this execution call
+        bool isValid;
+    };
+
+    bool isBlockValid(u32 blockIndex);
+    bool invalidateBlocks(u16 address); // returns true, if the address is in any block
+    void onTrappedWrite(u16 address, u8 value) override;
+
+    const RecompiledProgram &program;
+    std::vector<u32> blockIndices = {}; // index of the block starting at each address
+    std::vector<BlockState> blockStates = {};
+    std::bitset<memorySize> codeBytes = {}; // bytes covered by any block
+    u32 maxBlockSize = 0;
+    u32 generation = 1;
+    bool blockExitRequested = false;
+    u32 interpretedInstructionsCount = 0;
+};
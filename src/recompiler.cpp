@@ -0,0 +1,470 @@
+#include "recompiler.h"
+
+#include "src/bit_operations.h"
+#include "src/error.h"
+#include "src/instructions.h"
+#include "src/processor.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+void appendFormat(std::string &output, const char *format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    const int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    FATAL_ERROR_IF(length < 0 || static_cast<size_t>(length) >= sizeof(buffer), "Generated line is too long");
+    output.append(buffer, static_cast<size_t>(length));
+}
+
+bool isTranslated(u8 opCode) {
+    return Processor::isInstructionSupported(opCode) && opCode != static_cast<u8>(OpCode::BRK) && opCode != static_cast<u8>(OpCode::RTI);
+}
+
+// Instructions, which need only the value, take the latency of index addition from the read, unless
+// a page is crossed
+bool isReadOnly(std::string_view mnemonic) {
+    constexpr const char *readOnlyMnemonics[] = {"LDA", "LDX", "LDY", "CMP", "CPX", "CPY", "ADC", "SBC", "AND", "EOR", "ORA", "BIT"};
+    for (const char *readOnlyMnemonic : readOnlyMnemonics) {
+        if (mnemonic == readOnlyMnemonic) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *getRegisterName(char registerLetter) {
+    switch (registerLetter) {
+    case 'A':
+        return "cpu.regs.a";
+    case 'X':
+        return "cpu.regs.x";
+    case 'Y':
+        return "cpu.regs.y";
+    default:
+        UNREACHABLE_CODE();
+    }
+}
+
+const char *getBranchCondition(std::string_view mnemonic) {
+    constexpr const char *conditions[][2] = {
+        {"BCC", "!cpu.regs.flags.c"},
+        {"BCS", "cpu.regs.flags.c"},
+        {"BEQ", "cpu.regs.flags.z"},
+        {"BMI", "cpu.regs.flags.n"},
+        {"BNE", "!cpu.regs.flags.z"},
+        {"BPL", "!cpu.regs.flags.n"},
+        {"BVC", "!cpu.regs.flags.o"},
+        {"BVS", "cpu.regs.flags.o"},
+    };
+    for (const auto &condition : conditions) {
+        if (mnemonic == condition[0]) {
+            return condition[1];
+        }
+    }
+    UNREACHABLE_CODE();
+}
+
+const char *getFlagOperation(std::string_view mnemonic) {
+    constexpr const char *operations[][2] = {
+        {"CLC", "cpu.regs.flags.c = 0;"},
+        {"CLD", "cpu.regs.flags.d = 0;"},
+        {"CLI", "cpu.regs.flags.i = 0;"},
+        {"CLV", "cpu.regs.flags.o = 0;"},
+        {"SEC", "cpu.regs.flags.c = 1;"},
+        {"SED", "cpu.regs.flags.d = 1;"},
+        {"SEI", "cpu.regs.flags.i = 1;"},
+    };
+    for (const auto &operation : operations) {
+        if (mnemonic == operation[0]) {
+            return operation[1];
+        }
+    }
+    return nullptr;
+}
+} // namespace
+
+Recompiler::Recompiler(const SymbolTable *symbols) : symbols(symbols), disassembler(symbols) {}
+
+u32 Recompiler::getBaseCycles(u8 opCode) {
+    // Cycles are measured once by executing every instruction in the interpreter. Operands are zero, so no page
+    // is crossed. Flags are tried with both values and the lower count is the one of a branch not taken.
+    static const std::array<u8, 256> baseCycles = []() {
+        std::array<u8, 256> result{};
+        Processor processor{};
+        for (u32 opCode = 0; opCode < result.size(); opCode++) {
+            if (!Processor::isInstructionSupported(static_cast<u8>(opCode))) {
+                continue;
+            }
+
+            u32 minCycles = 0xFFFFFFFF;
+            for (const u8 flags : {0x00, 0xC3}) {
+                const u8 program[Disassembler::maxInstructionSize] = {static_cast<u8>(opCode), 0, 0};
+                processor.reset();
+                processor.loadMemory(0x0200, sizeof(program), program);
+                ProcessorState state = processor.saveState();
+                state.regs = {};
+                state.regs.pc = 0x0200;
+                state.regs.flags = StatusFlags::fromU8(flags);
+                processor.restoreState(state);
+
+                const ExecutionResult result = processor.executeInstructions(1);
+                FATAL_ERROR_IF(result.instructionsExecuted != 1, "Failed measuring cycles of opcode 0x%02x", opCode);
+                minCycles = std::min(minCycles, result.cyclesExecuted);
+            }
+            result[opCode] = static_cast<u8>(minCycles);
+        }
+        return result;
+    }();
+    return baseCycles[opCode];
+}
+
+void Recompiler::recompile(const Memory &memory, const ControlFlowGraph &graph, const char *programName, std::string &output) {
+    output.append("// Generated by emos_recompile. Do not edit.\n");
+    output.append("#include \"src/recompiled_processor.h\"\n\n");
+    output.append("namespace {\n");
+
+    struct TranslatedBlock {
+        u16 start;
+        u32 end;
+        u32 instructionsCount;
+    };
+    std::vector<TranslatedBlock> translatedBlocks{};
+    for (const ControlFlowGraph::BasicBlock &block : graph.getBlocks()) {
+        if (block.end > memorySize) {
+            continue;
+        }
+
+        // Translate instructions until the first one left to the interpreter
+        u32 end = block.start;
+        u32 count = 0;
+        while (count < block.instructionsCount && isTranslated(memory.read(static_cast<u16>(end)))) {
+            end += Disassembler::getInstructionSize(memory.read(static_cast<u16>(end)));
+            count++;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        recompileBlock(memory, block.start, end, output);
+        translatedBlocks.push_back({block.start, end, count});
+        blocksCount++;
+        instructionsCount += count;
+    }
+
+    if (translatedBlocks.empty()) {
+        output.append("} // namespace\n\n");
+        appendFormat(output, "extern const RecompiledProgram %s;\n", programName);
+        appendFormat(output, "const RecompiledProgram %s = {nullptr, 0};\n", programName);
+        return;
+    }
+
+    // Original code of all blocks, so the processor can check it was not modified
+    output.append("const u8 code[] = {");
+    for (u32 blockIndex = 0; blockIndex < translatedBlocks.size(); blockIndex++) {
+        const TranslatedBlock &block = translatedBlocks[blockIndex];
+        for (u32 address = block.start; address < block.end; address++) {
+            const u32 offset = address - block.start;
+            output.append(offset % 16 == 0 ? "\n    " : " ");
+            appendFormat(output, "0x%02x,", memory.read(static_cast<u16>(address)));
+        }
+    }
+    output.append("\n};\n\n");
+
+    output.append("const RecompiledBlock blocks[] = {\n");
+    u32 codeOffset = 0;
+    for (const TranslatedBlock &block : translatedBlocks) {
+        appendFormat(output, "    {0x%04x, %u, %u, code + %u, block%04x},\n", block.start, block.end - block.start, block.instructionsCount, codeOffset, block.start);
+        codeOffset += block.end - block.start;
+    }
+    output.append("};\n");
+    output.append("} // namespace\n\n");
+
+    appendFormat(output, "extern const RecompiledProgram %s;\n", programName);
+    appendFormat(output, "const RecompiledProgram %s = {blocks, %u};\n", programName, static_cast<u32>(translatedBlocks.size()));
+}
+
+void Recompiler::recompileBlock(const Memory &memory, u16 start, u32 end, std::string &output) {
+    u16 labelOffset = 0;
+    const char *label = symbols != nullptr ? symbols->findLabel(start, labelOffset) : nullptr;
+    if (label != nullptr && labelOffset == 0) {
+        appendFormat(output, "// %s\n", label);
+    }
+    appendFormat(output, "bool block%04x(RecompiledProcessor &cpu) {\n", start);
+
+    pending = {};
+    for (u32 address = start; address < end;) {
+        const u8 bytes[Disassembler::maxInstructionSize] = {
+            memory.read(static_cast<u16>(address)),
+            memory.read(static_cast<u16>(address + 1)),
+            memory.read(static_cast<u16>(address + 2)),
+        };
+        const u32 size = Disassembler::getInstructionSize(bytes[0]);
+        recompileInstruction(static_cast<u16>(address), bytes, address + size == end, output);
+        address += size;
+    }
+    output.append("}\n\n");
+}
+
+void Recompiler::recompileInstruction(u16 address, const u8 *bytes, bool isLast, std::string &output) {
+    const u8 opCode = bytes[0];
+    const std::string_view mnemonic = Processor::getMnemonic(opCode);
+    const AddressingMode mode = Processor::getAddressingMode(opCode);
+    const u32 size = Disassembler::getInstructionSize(opCode);
+    const u32 cycles = getBaseCycles(opCode);
+    const u16 next = static_cast<u16>(address + size);
+    const u16 operand8 = bytes[1];
+    const u16 operand16 = constructU16(bytes[2], bytes[1]);
+
+    const std::string_view text = disassembler.disassembleInstruction(address, bytes);
+    appendFormat(output, "    // %04x: %.*s\n", address, static_cast<int>(text.size()), text.data());
+    output.append("    {\n");
+
+    // Effective address
+    switch (mode) {
+    case AddressingMode::ZeroPage:
+        appendFormat(output, "        const u16 address = 0x%04x;\n", operand8);
+        break;
+    case AddressingMode::ZeroPageX:
+    case AddressingMode::ZeroPageY:
+        appendFormat(output, "        const u16 address = static_cast<u8>(0x%02x + cpu.regs.%c);\n", operand8, mode == AddressingMode::ZeroPageX ? 'x' : 'y');
+        break;
+    case AddressingMode::Absolute:
+        appendFormat(output, "        const u16 address = 0x%04x;\n", operand16);
+        break;
+    case AddressingMode::AbsoluteX:
+    case AddressingMode::AbsoluteY:
+        appendFormat(output, "        const u16 address = static_cast<u16>(0x%04x + cpu.regs.%c);\n", operand16, mode == AddressingMode::AbsoluteX ? 'x' : 'y');
+        if (isReadOnly(mnemonic)) {
+            appendFormat(output, "        cpu.counters.cyclesProcessed += RecompiledProcessor::isPageCrossed(0x%04x, address);\n", operand16);
+        }
+        break;
+    case AddressingMode::IndexedIndirectX:
+        appendFormat(output, "        const u16 address = cpu.read16(static_cast<u8>(0x%02x + cpu.regs.x));\n", operand8);
+        break;
+    case AddressingMode::IndirectIndexedY:
+        appendFormat(output, "        const u16 base = cpu.read16(0x%04x);\n", operand8);
+        output.append("        const u16 address = static_cast<u16>(base + cpu.regs.y);\n");
+        if (isReadOnly(mnemonic)) {
+            output.append("        cpu.counters.cyclesProcessed += RecompiledProcessor::isPageCrossed(base, address);\n");
+        }
+        break;
+    case AddressingMode::Indirect:
+        appendFormat(output, "        const u16 address = cpu.read16(0x%04x);\n", operand16);
+        break;
+    default:
+        break;
+    }
+
+    // Operand value of instructions reading it
+    const bool readsValue = isReadOnly(mnemonic) || mnemonic == "INC" || mnemonic == "DEC" ||
+                            mnemonic == "ASL" || mnemonic == "LSR" || mnemonic == "ROL" || mnemonic == "ROR";
+    if (readsValue) {
+        if (mode == AddressingMode::Immediate) {
+            appendFormat(output, "        const u8 value = 0x%02x;\n", operand8);
+        } else if (mode == AddressingMode::Accumulator) {
+            output.append("        u8 value = cpu.regs.a;\n");
+        } else if (isReadOnly(mnemonic)) {
+            output.append("        const u8 value = cpu.read(address);\n");
+        } else {
+            output.append("        u8 value = cpu.read(address);\n");
+        }
+    }
+
+    bool isCounted = false; // set by instructions, which update pending counters themselves
+    if (mnemonic == "LDA" || mnemonic == "LDX" || mnemonic == "LDY") {
+        appendFormat(output, "        %s = value;\n", getRegisterName(mnemonic[2]));
+        output.append("        cpu.setArithmeticFlags(value);\n");
+    } else if (mnemonic == "AND" || mnemonic == "ORA" || mnemonic == "EOR") {
+        const char operation = mnemonic == "AND" ? '&' : (mnemonic == "ORA" ? '|' : '^');
+        appendFormat(output, "        cpu.regs.a %c= value;\n", operation);
+        output.append("        cpu.setArithmeticFlags(cpu.regs.a);\n");
+    } else if (mnemonic == "BIT") {
+        output.append("        cpu.regs.flags.z = (cpu.regs.a & value) == 0;\n");
+        output.append("        cpu.regs.flags.o = isBitSet<6>(value);\n");
+        output.append("        cpu.regs.flags.n = isBitSet<7>(value);\n");
+    } else if (mnemonic == "CMP" || mnemonic == "CPX" || mnemonic == "CPY") {
+        appendFormat(output, "        cpu.compare(%s, value);\n", getRegisterName(mnemonic == "CMP" ? 'A' : mnemonic[2]));
+    } else if (mnemonic == "ADC" || mnemonic == "SBC") {
+        // Decimal arithmetic can fail with a guest error, which leaves the instruction uncounted
+        pending.cycles += cycles;
+        pending.bytes += size;
+        flush(next, 2, output);
+        appendFormat(output, "        if (!cpu.%s(value)) {\n", mnemonic == "ADC" ? "add" : "subtract");
+        output.append("            return false;\n");
+        output.append("        }\n");
+        pending.instructions++;
+        isCounted = true;
+    } else if (mnemonic == "INX" || mnemonic == "INY" || mnemonic == "DEX" || mnemonic == "DEY") {
+        const char *reg = getRegisterName(mnemonic[2]);
+        appendFormat(output, "        %s%s;\n", reg, mnemonic[0] == 'I' ? "++" : "--");
+        appendFormat(output, "        cpu.setArithmeticFlags(%s);\n", reg);
+    } else if (mnemonic == "TAX" || mnemonic == "TAY" || mnemonic == "TXA" || mnemonic == "TYA") {
+        const char *destination = getRegisterName(mnemonic[2]);
+        appendFormat(output, "        %s = %s;\n", destination, getRegisterName(mnemonic[1]));
+        appendFormat(output, "        cpu.setArithmeticFlags(%s);\n", destination);
+    } else if (mnemonic == "TSX") {
+        output.append("        cpu.regs.x = cpu.regs.sp;\n");
+        output.append("        cpu.setArithmeticFlags(cpu.regs.x);\n");
+    } else if (mnemonic == "TXS") {
+        output.append("        cpu.regs.sp = cpu.regs.x;\n");
+    } else if (const char *flagOperation = getFlagOperation(mnemonic); flagOperation != nullptr) {
+        appendFormat(output, "        %s\n", flagOperation);
+    } else if (mnemonic == "NOP") {
+    } else if (mnemonic == "PLA") {
+        output.append("        cpu.regs.a = cpu.pop8();\n");
+        output.append("        cpu.setArithmeticFlags(cpu.regs.a);\n");
+    } else if (mnemonic == "PLP") {
+        output.append("        StatusFlags flags = StatusFlags::fromU8(cpu.pop8());\n");
+        output.append("        flags.r = cpu.regs.flags.r;\n");
+        output.append("        flags.b = cpu.regs.flags.b;\n");
+        output.append("        cpu.regs.flags = flags;\n");
+    } else if (mnemonic == "PHA" || mnemonic == "PHP") {
+        // Stack pointer is decremented before the value is written, so all cycles pass before the write
+        pending.cycles += cycles;
+        pending.bytes += size;
+        flush(next, 2, output);
+        if (mnemonic == "PHA") {
+            output.append("        const bool exit = cpu.push8(cpu.regs.a);\n");
+        } else {
+            output.append("        StatusFlags flags = cpu.regs.flags;\n");
+            output.append("        flags.b = 1;\n");
+            output.append("        flags.r = 1;\n");
+            output.append("        const bool exit = cpu.push8(flags.toU8());\n");
+        }
+        pending.instructions++;
+        emitExit(next, output);
+        isCounted = true;
+    } else if (mnemonic == "STA" || mnemonic == "STX" || mnemonic == "STY") {
+        // The write is the last cycle of the instruction
+        pending.cycles += cycles - 1;
+        pending.bytes += size;
+        flush(next, 2, output);
+        appendFormat(output, "        const bool exit = cpu.write(address, %s);\n", getRegisterName(mnemonic[2]));
+        pending.cycles++;
+        pending.instructions++;
+        emitExit(next, output);
+        isCounted = true;
+    } else if (mnemonic == "INC" || mnemonic == "DEC" || mnemonic == "ASL" || mnemonic == "LSR" || mnemonic == "ROL" || mnemonic == "ROR") {
+        if (mnemonic == "INC" || mnemonic == "DEC") {
+            appendFormat(output, "        value%s;\n", mnemonic == "INC" ? "++" : "--");
+        } else if (mnemonic == "ASL") {
+            output.append("        cpu.regs.flags.c = isSignBitSet(value);\n");
+            output.append("        value <<= 1;\n");
+        } else if (mnemonic == "LSR") {
+            output.append("        cpu.regs.flags.c = isZeroBitSet(value);\n");
+            output.append("        value >>= 1;\n");
+        } else if (mnemonic == "ROL") {
+            output.append("        const bool carry = cpu.regs.flags.c;\n");
+            output.append("        cpu.regs.flags.c = isSignBitSet(value);\n");
+            output.append("        value = static_cast<u8>((value << 1) | carry);\n");
+        } else {
+            output.append("        const bool carry = cpu.regs.flags.c;\n");
+            output.append("        cpu.regs.flags.c = isZeroBitSet(value);\n");
+            output.append("        value = static_cast<u8>((value >> 1) | (carry << 7));\n");
+        }
+
+        if (mode == AddressingMode::Accumulator) {
+            output.append("        cpu.regs.a = value;\n");
+            output.append("        cpu.setArithmeticFlags(value);\n");
+        } else {
+            // Flags are updated after the write, which is the last cycle of the instruction
+            pending.cycles += cycles - 1;
+            pending.bytes += size;
+            flush(next, 2, output);
+            output.append("        const bool exit = cpu.write(address, value);\n");
+            output.append("        cpu.setArithmeticFlags(value);\n");
+            pending.cycles++;
+            pending.instructions++;
+            emitExit(next, output);
+            isCounted = true;
+        }
+    } else if (mnemonic == "JMP") {
+        DEBUG_ASSERT(isLast, "Jump must end the block");
+        pending.cycles += cycles;
+        pending.bytes += size;
+        pending.instructions++;
+        flush("address", 2, output);
+        output.append("        return true;\n");
+        output.append("    }\n");
+        return;
+    } else if (mnemonic == "JSR") {
+        DEBUG_ASSERT(isLast, "Call must end the block");
+        pending.cycles += cycles;
+        pending.bytes += size;
+        flush(next, 2, output);
+        appendFormat(output, "        const bool exit = cpu.push16(0x%04x);\n", static_cast<u16>(next - 1));
+        pending.instructions++;
+        flush("address", 2, output);
+        output.append("        return !exit;\n");
+        output.append("    }\n");
+        return;
+    } else if (mnemonic == "RTS") {
+        DEBUG_ASSERT(isLast, "Return must end the block");
+        pending.cycles += cycles;
+        pending.bytes += size;
+        pending.instructions++;
+        output.append("        const u16 address = static_cast<u16>(cpu.pop16() + 1);\n");
+        flush("address", 2, output);
+        output.append("        return true;\n");
+        output.append("    }\n");
+        return;
+    } else if (mode == AddressingMode::Relative) {
+        DEBUG_ASSERT(isLast, "Branch must end the block");
+        const u16 target = static_cast<u16>(next + static_cast<i8>(bytes[1]));
+        pending.cycles += cycles;
+        pending.bytes += size;
+        pending.instructions++;
+        const PendingCounters notTaken = pending;
+        pending.cycles += 1 + ((next & 0xFF00) != (target & 0xFF00));
+        appendFormat(output, "        if (%s) {\n", getBranchCondition(mnemonic));
+        flush(target, 3, output);
+        output.append("            return true;\n");
+        output.append("        }\n");
+        pending = notTaken;
+        flush(next, 2, output);
+        output.append("        return true;\n");
+        output.append("    }\n");
+        return;
+    } else {
+        FATAL_ERROR("Cannot recompile %s", mnemonic.data());
+    }
+
+    if (!isCounted) {
+        pending.cycles += cycles;
+        pending.bytes += size;
+        pending.instructions++;
+    }
+    output.append("    }\n");
+
+    if (isLast) {
+        flush(next, 1, output);
+        output.append("    return true;\n");
+    }
+}
+
+void Recompiler::flush(const char *pc, u32 indentLevel, std::string &output) {
+    output.append(indentLevel * 4, ' ');
+    appendFormat(output, "cpu.advance(%u, %u, %u, %s);\n", pending.cycles, pending.bytes, pending.instructions, pc);
+    pending = {};
+}
+
+void Recompiler::flush(u16 pc, u32 indentLevel, std::string &output) {
+    char pcText[8];
+    snprintf(pcText, sizeof(pcText), "0x%04x", pc);
+    flush(pcText, indentLevel, output);
+}
+
+void Recompiler::emitExit(u16 pc, std::string &output) {
+    // Counters are not reset, the block continues when there is no exit
+    appendFormat(output, "        if (exit) {\n");
+    appendFormat(output, "            cpu.advance(%u, %u, %u, 0x%04x);\n", pending.cycles, pending.bytes, pending.instructions, pc);
+    output.append("            return false;\n");
+    output.append("        }\n");
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "src/control_flow_graph.h"
+#include "src/disassembler.h"
+
+#include <string>
+
+// Translates basic blocks of a control flow graph to C++ source defining a RecompiledProgram. Every block
+// becomes a function performing the same operations on registers and memory as the interpreter, with
+// operands, addresses and cycle counts resolved at translation time. Cycles are taken from the interpreter
+// itself, so the only cycles counted at runtime are the ones depending on data: page crossing of indexed
+// reads and taken branches.
+//
+// BRK and RTI are rare and change the interrupt state, so they are left to the interpreter and end the
+// translated part of the block. Blocks wrapping around the end of the memory are not translated.
+class Recompiler {
+public:
+    explicit Recompiler(const SymbolTable *symbols = nullptr);
+
+    // Source is appended to the output. The program is defined as a global constant with given name.
+    void recompile(const Memory &memory, const ControlFlowGraph &graph, const char *programName, std::string &output);
+
+    u32 getBlocksCount() const { return blocksCount; }
+    u32 getInstructionsCount() const { return instructionsCount; }
+
+    // Cycles of an instruction without page crossing and, for branches, when the branch is not taken
+    static u32 getBaseCycles(u8 opCode);
+
+private:
+    struct PendingCounters {
+        u32 cycles;
+        u32 bytes;
+        u32 instructions;
+    };
+
+    void recompileBlock(const Memory &memory, u16 start, u32 end, std::string &output);
+    void recompileInstruction(u16 address, const u8 *bytes, bool isLast, std::string &output);
+    void flush(const char *pc, u32 indentLevel, std::string &output); // emits pending counters and resets them
+    void flush(u16 pc, u32 indentLevel, std::string &output);
+    void emitExit(u16 pc, std::string &output);
+
+    const SymbolTable *symbols = nullptr;
+    Disassembler disassembler;
+    PendingCounters pending = {};
+    u32 blocksCount = 0;
+    u32 instructionsCount = 0;
+};
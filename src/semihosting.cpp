@@ -0,0 +1,68 @@
+#include "semihosting.h"
+
+#include "src/error.h"
+#include "src/memory.h"
+
+Semihosting::Semihosting(u16 pageAddress, FILE *outputFile) : pageAddress(pageAddress), outputFile(outputFile) {
+    FATAL_ERROR_IF(pageAddress % memoryPageSize != 0, "Semihosting page address must be aligned to page size");
+    output.reserve(outputBufferSize);
+}
+
+Semihosting::~Semihosting() {
+    flush();
+}
+
+bool Semihosting::write(u8 offset, u8 value, const Registers &regs, const Counters &counters) {
+    switch (static_cast<Command>(offset)) {
+    case Command::Exit:
+        exited = true;
+        exitCode = value;
+        flush();
+        return true;
+    case Command::Putchar:
+        output.push_back(static_cast<char>(value));
+        if (output.size() >= outputBufferSize) {
+            flush();
+        }
+        return false;
+    case Command::StopwatchStart:
+        stopwatchRunning = true;
+        stopwatchStart = counters.cyclesProcessed;
+        return false;
+    case Command::StopwatchStop:
+        if (stopwatchRunning) {
+            stopwatchRunning = false;
+            stopwatchCycles = counters.cyclesProcessed - stopwatchStart;
+        }
+        return false;
+    case Command::DumpRegisters: {
+        char line[128];
+        snprintf(line, sizeof(line), "A=0x%02x X=0x%02x Y=0x%02x SP=0x%02x PC=0x%04x Flags=%s Cycles=%u\n",
+                 regs.a, regs.x, regs.y, regs.sp, regs.pc, regs.flags.toString().c_str(), counters.cyclesProcessed);
+        output += line;
+        if (output.size() >= outputBufferSize) {
+            flush();
+        }
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+void Semihosting::flush() {
+    if (outputFile != nullptr && !output.empty()) {
+        fwrite(output.data(), 1, output.size(), outputFile);
+        fflush(outputFile);
+        output.clear();
+    }
+}
+
+void Semihosting::reset() {
+    output.clear();
+    exited = false;
+    exitCode = 0;
+    stopwatchRunning = false;
+    stopwatchStart = 0;
+    stopwatchCycles = 0;
+}
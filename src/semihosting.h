@@ -0,0 +1,60 @@
+#pragma once
+
+#include "src/counters.h"
+#include "src/registers.h"
+
+#include <cstdio>
+#include <string>
+
+// Page of memory, through which the guest program talks to the host. Writes to the page are not stored, but
+// interpreted as commands selected by the offset within the page:
+//     +0 exit          - stops the processor with StopReason::GuestExit, written value is the exit code
+//     +1 putchar       - appends written value to the output
+//     +2 stopwatch     - starts counting emulated cycles, written value is ignored
+//     +3 stopwatch end - stops counting emulated cycles, written value is ignored
+//     +4 dump          - appends registers and cycle counter to the output, written value is ignored
+// Writes to other offsets are ignored. The page is trapped in the memory map, so it costs nothing until the
+// guest writes to it. Output is buffered and flushed to the file when the buffer is full, on exit and on
+// destruction. When no file is given, output is only kept in the buffer. Semihosting is owned by the caller
+// and can be attached to one processor at a time.
+class Semihosting {
+public:
+    enum class Command : u8 {
+        Exit = 0x00,
+        Putchar = 0x01,
+        StopwatchStart = 0x02,
+        StopwatchStop = 0x03,
+        DumpRegisters = 0x04,
+    };
+    constexpr static u16 defaultPageAddress = 0xFE00;
+
+    explicit Semihosting(u16 pageAddress = defaultPageAddress, FILE *outputFile = nullptr);
+    ~Semihosting();
+    Semihosting(const Semihosting &) = delete;
+    Semihosting &operator=(const Semihosting &) = delete;
+
+    // Called by the processor. Returns true, if the guest requested exit.
+    bool write(u8 offset, u8 value, const Registers &regs, const Counters &counters);
+
+    void flush();
+    void reset(); // drops the output and clears exit status and stopwatch
+
+    u16 getPageAddress() const { return pageAddress; }
+    const std::string &getOutput() const { return output; } // output not flushed yet
+    bool hasExited() const { return exited; }
+    u8 getExitCode() const { return exitCode; }
+    u32 getStopwatchCycles() const { return stopwatchCycles; } // cycles between the last start and stop
+
+private:
+    constexpr static size_t outputBufferSize = 4096;
+
+    const u16 pageAddress;
+    FILE *const outputFile;
+    std::string output = {};
+
+    bool exited = false;
+    u8 exitCode = 0;
+    bool stopwatchRunning = false;
+    u32 stopwatchStart = 0;
+    u32 stopwatchCycles = 0;
+};
@@ -0,0 +1,311 @@
+#include "symbol_table.h"
+
+#include "src/image_loader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <set>
+
+namespace {
+// Columns of an as65 listing line:
+//     0400 : d8               start   cld
+//     3469 : 4c6934          >        jmp *
+constexpr size_t as65ExpansionMarkerColumn = 23;
+constexpr size_t as65SourceColumn = 24;
+
+bool isIdentifierStart(char character) {
+    return isalpha(static_cast<unsigned char>(character)) || character == '_' || character == '.';
+}
+
+bool isIdentifierCharacter(char character) {
+    return isalnum(static_cast<unsigned char>(character)) || character == '_' || character == '.' || character == '?';
+}
+
+bool isSpace(char character) {
+    return character == ' ' || character == '\t';
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return tolower(x) == tolower(y); });
+}
+
+std::string_view skipSpaces(std::string_view text) {
+    size_t position = 0;
+    while (position < text.size() && isSpace(text[position])) {
+        position++;
+    }
+    return text.substr(position);
+}
+
+// Takes the identifier from the beginning of the text
+std::string_view takeIdentifier(std::string_view &text) {
+    if (text.empty() || !isIdentifierStart(text[0])) {
+        return {};
+    }
+    size_t length = 1;
+    while (length < text.size() && isIdentifierCharacter(text[length])) {
+        length++;
+    }
+    const std::string_view identifier = text.substr(0, length);
+    text = text.substr(length);
+    return identifier;
+}
+
+bool parseHex(std::string_view text, u32 &outValue) {
+    if (text.empty()) {
+        return false;
+    }
+    outValue = 0;
+    for (const char character : text) {
+        if (!isxdigit(static_cast<unsigned char>(character))) {
+            return false;
+        }
+        outValue = outValue << 4 | static_cast<u32>(isdigit(static_cast<unsigned char>(character)) ? character - '0' : tolower(character) - 'a' + 10);
+    }
+    return true;
+}
+
+bool parseValue(std::string_view text, u32 &outValue) {
+    if (!text.empty() && text[0] == '$') {
+        return parseHex(text.substr(1), outValue);
+    }
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        return parseHex(text.substr(2), outValue);
+    }
+    if (text.empty()) {
+        return false;
+    }
+    outValue = 0;
+    for (const char character : text) {
+        if (!isdigit(static_cast<unsigned char>(character))) {
+            return false;
+        }
+        outValue = outValue * 10 + static_cast<u32>(character - '0');
+    }
+    return true;
+}
+
+template <typename LineParser>
+void forEachLine(const char *text, size_t size, LineParser &&parseLine) {
+    std::string_view remaining{text, size};
+    while (!remaining.empty()) {
+        const size_t lineEnd = std::min(remaining.find('\n'), remaining.size());
+        std::string_view line = remaining.substr(0, lineEnd);
+        remaining = remaining.substr(std::min(lineEnd + 1, remaining.size()));
+        while (!line.empty() && (line.back() == '\r' || isSpace(line.back()))) {
+            line.remove_suffix(1);
+        }
+        parseLine(line);
+    }
+}
+} // namespace
+
+bool SymbolTable::loadAs65Listing(const char *text, size_t size) {
+    std::set<std::string_view> macroNames{};
+    bool inMacroDefinition = false;
+    std::string_view pendingLabel{};
+    std::string_view pendingMacro{};
+    bool hasAssembledLines = false;
+
+    forEachLine(text, size, [&](std::string_view line) {
+        // Every listing line has either an address and assembled bytes, a value of an equate or nothing
+        // before the source column. Other lines are page headers, messages and the symbol table.
+        u32 address = 0;
+        const bool isAssembled = line.size() >= 7 && parseHex(line.substr(0, 4), address) && line.substr(4, 3) == " : ";
+        const bool isEquate = line.size() >= 6 && parseHex(line.substr(0, 4), address) && line.substr(4, 2) == " =";
+        const bool isSourceOnly = line.find_first_not_of(' ') >= std::min(line.size(), as65SourceColumn);
+        if (!isAssembled && !isEquate && !isSourceOnly) {
+            return;
+        }
+        const bool isExpansion = line.size() > as65ExpansionMarkerColumn && line[as65ExpansionMarkerColumn] == '>';
+        std::string_view source = line.size() > as65SourceColumn ? line.substr(as65SourceColumn) : std::string_view{};
+
+        // Split the statement into an optional label and the first word after it
+        std::string_view label = takeIdentifier(source);
+        if (!label.empty() && !source.empty() && source[0] == ':') {
+            source = source.substr(1);
+        }
+        source = skipSpaces(source);
+        std::string_view rest = source;
+        const std::string_view word = takeIdentifier(rest);
+        const bool isStatement = !source.empty() && source[0] != ';';
+
+        if (inMacroDefinition) {
+            inMacroDefinition = !equalsIgnoreCase(label, "endm") && !equalsIgnoreCase(word, "endm");
+            return;
+        }
+        if (equalsIgnoreCase(word, "macro")) {
+            macroNames.insert(label);
+            inMacroDefinition = true;
+            return;
+        }
+        if (isEquate || source.substr(0, 1) == "=" || equalsIgnoreCase(word, "equ")) {
+            pendingLabel = {};
+            return;
+        }
+
+        if (isAssembled) {
+            hasAssembledLines = true;
+            if (!pendingLabel.empty()) {
+                addUnsorted(pendingLabel, static_cast<u16>(address), Kind::Label);
+            }
+            if (!pendingMacro.empty() && isExpansion) {
+                addUnsorted(pendingMacro, static_cast<u16>(address), Kind::MacroExpansion);
+            }
+            pendingLabel = {};
+            pendingMacro = {};
+
+            // Labels inside macro expansions are generated, so they are not worth reporting
+            if (!isExpansion) {
+                if (!label.empty()) {
+                    addUnsorted(label, static_cast<u16>(address), Kind::Label);
+                }
+                if (macroNames.count(word) != 0) {
+                    addUnsorted(word, static_cast<u16>(address), Kind::MacroExpansion);
+                }
+            }
+            return;
+        }
+
+        // Source without code. Label waits for the next assembled line, unless the statement is a directive or
+        // a part of a disabled conditional block. Macro invocation waits for its first expanded line.
+        if (!label.empty()) {
+            pendingLabel = label;
+        }
+        if (isStatement) {
+            if (macroNames.count(word) != 0) {
+                pendingMacro = word;
+            } else {
+                pendingLabel = {};
+                pendingMacro = {};
+            }
+        }
+    });
+
+    sortSymbols();
+    return hasAssembledLines;
+}
+
+bool SymbolTable::loadLabelFile(const char *text, size_t size) {
+    bool valid = true;
+    forEachLine(text, size, [&](std::string_view line) {
+        line = skipSpaces(line);
+        if (line.empty() || line[0] == ';' || line[0] == '#') {
+            return;
+        }
+
+        std::string_view rest = line;
+        const std::string_view name = takeIdentifier(rest);
+        rest = skipSpaces(rest);
+        if (!rest.empty() && rest[0] == '=') {
+            rest = rest.substr(1);
+        } else if (rest.size() > 3 && equalsIgnoreCase(rest.substr(0, 3), "equ") && isSpace(rest[3])) {
+            rest = rest.substr(3);
+        } else {
+            valid = false;
+            return;
+        }
+
+        rest = skipSpaces(rest);
+        rest = rest.substr(0, std::min(rest.find_first_of(" \t;"), rest.size()));
+        u32 value = 0;
+        if (name.empty() || !parseValue(rest, value) || value > 0xFFFF) {
+            valid = false;
+            return;
+        }
+        addUnsorted(name, static_cast<u16>(value), Kind::Label);
+    });
+
+    sortSymbols();
+    return valid;
+}
+
+bool SymbolTable::loadFile(const std::string &path) {
+    const std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+    if (file == nullptr) {
+        return false;
+    }
+    const char *text = reinterpret_cast<const char *>(file->getData());
+    if (std::filesystem::path(path).extension() == ".lst") {
+        return loadAs65Listing(text, file->getSize());
+    }
+    return loadLabelFile(text, file->getSize());
+}
+
+void SymbolTable::add(std::string_view name, u16 address, Kind kind) {
+    addUnsorted(name, address, kind);
+    sortSymbols();
+}
+
+bool SymbolTable::findAddress(std::string_view name, u16 &outAddress, Kind kind) const {
+    const Symbols &kindSymbols = symbols[static_cast<u32>(kind)];
+    auto it = std::lower_bound(kindSymbols.byName.begin(), kindSymbols.byName.end(), name, [&](u32 index, std::string_view value) {
+        return getName(kindSymbols.byAddress[index]) < value;
+    });
+    if (it == kindSymbols.byName.end() || getName(kindSymbols.byAddress[*it]) != name) {
+        return false;
+    }
+    outAddress = kindSymbols.byAddress[*it].address;
+    return true;
+}
+
+const char *SymbolTable::findLabel(u16 address, u16 &outOffset) const {
+    const std::vector<Symbol> &labels = symbols[static_cast<u32>(Kind::Label)].byAddress;
+    auto it = std::upper_bound(labels.begin(), labels.end(), address, [](u16 value, const Symbol &symbol) {
+        return value < symbol.address;
+    });
+    if (it == labels.begin()) {
+        return nullptr;
+    }
+
+    // Many labels can share the address, so take the first of them
+    const u16 labelAddress = (--it)->address;
+    while (it != labels.begin() && (it - 1)->address == labelAddress) {
+        --it;
+    }
+    outOffset = address - labelAddress;
+    return getName(*it);
+}
+
+void SymbolTable::formatAddress(u16 address, char *buffer, size_t bufferSize) const {
+    u16 offset = 0;
+    const char *label = findLabel(address, offset);
+    if (label == nullptr) {
+        snprintf(buffer, bufferSize, "0x%04x", address);
+    } else if (offset == 0) {
+        snprintf(buffer, bufferSize, "%s", label);
+    } else {
+        snprintf(buffer, bufferSize, "%s+0x%x", label, offset);
+    }
+}
+
+std::string SymbolTable::formatAddress(u16 address) const {
+    char buffer[128];
+    formatAddress(address, buffer, sizeof(buffer));
+    return buffer;
+}
+
+void SymbolTable::addUnsorted(std::string_view name, u16 address, Kind kind) {
+    symbols[static_cast<u32>(kind)].byAddress.push_back(Symbol{address, static_cast<u32>(names.size())});
+    names.append(name);
+    names.push_back('\0');
+}
+
+void SymbolTable::sortSymbols() {
+    for (Symbols &kindSymbols : symbols) {
+        // Stable sort keeps the order of definition for symbols at the same address and with the same name
+        std::stable_sort(kindSymbols.byAddress.begin(), kindSymbols.byAddress.end(), [](const Symbol &a, const Symbol &b) {
+            return a.address < b.address;
+        });
+
+        kindSymbols.byName.resize(kindSymbols.byAddress.size());
+        for (u32 index = 0; index < kindSymbols.byName.size(); index++) {
+            kindSymbols.byName[index] = index;
+        }
+        std::stable_sort(kindSymbols.byName.begin(), kindSymbols.byName.end(), [&](u32 a, u32 b) {
+            return strcmp(getName(kindSymbols.byAddress[a]), getName(kindSymbols.byAddress[b])) < 0;
+        });
+    }
+}
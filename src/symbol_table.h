@@ -0,0 +1,58 @@
+#pragma once
+
+#include "src/types.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Names of guest addresses imported from assembler output. Symbols are kept in vectors sorted by address
+// and by name, with all names in one string, so the table is compact and both lookups are binary searches.
+//
+// As65 listings are parsed for labels of the assembled code and data. Listing lines of the assembled bytes
+// have a form of "0400 : d8               start   cld", with the source starting at a fixed column. Labels
+// on lines without code take the address of the next assembled line. Macro invocations are recorded as
+// separate symbols at the address of their first expanded instruction, because test programs often mark
+// interesting places, like success and failure traps, with macros instead of labels. Label files contain
+// one "<name> = <address>" per line, for example "start = $0400".
+class SymbolTable {
+public:
+    enum class Kind : u8 {
+        Label,
+        MacroExpansion,
+    };
+
+    bool loadAs65Listing(const char *text, size_t size);
+    bool loadLabelFile(const char *text, size_t size);
+    bool loadFile(const std::string &path); // listing for .lst files, label file otherwise
+    void add(std::string_view name, u16 address, Kind kind = Kind::Label);
+
+    // Returns the address of the first symbol with given name and kind
+    bool findAddress(std::string_view name, u16 &outAddress, Kind kind = Kind::Label) const;
+
+    // Returns the nearest label at or below the address, or nullptr if there is none
+    const char *findLabel(u16 address, u16 &outOffset) const;
+
+    // Formats the address as "label", "label+0x12" or "0x1234", if there is no label below it
+    void formatAddress(u16 address, char *buffer, size_t bufferSize) const;
+    std::string formatAddress(u16 address) const;
+
+    size_t getSymbolsCount(Kind kind) const { return symbols[static_cast<u32>(kind)].byAddress.size(); }
+
+private:
+    struct Symbol {
+        u16 address;
+        u32 nameOffset; // names are null-terminated
+    };
+    struct Symbols {
+        std::vector<Symbol> byAddress = {};
+        std::vector<u32> byName = {}; // indices to byAddress
+    };
+
+    void addUnsorted(std::string_view name, u16 address, Kind kind);
+    void sortSymbols();
+    const char *getName(const Symbol &symbol) const { return names.data() + symbol.nameOffset; }
+
+    Symbols symbols[2] = {}; // indexed by kind
+    std::string names = {};
+};
@@ -0,0 +1,10 @@
+#include "src/host_counters.h"
+
+// Hardware counters of the host are not exposed to user mode without a kernel driver
+HostCounters::HostCounters() {}
+
+HostCounters::~HostCounters() {}
+
+HostCounterValues HostCounters::read() const {
+    return {};
+}
@@ -0,0 +1,52 @@
+#include "src/error.h"
+#include "src/os_memory.h"
+
+#include <Windows.h>
+
+namespace OsMemory {
+void *allocateHugePages(size_t size) {
+    // Large pages require SeLockMemoryPrivilege, which is usually not granted. Fall back to regular pages.
+    const size_t largePageSize = GetLargePageMinimum();
+    if (largePageSize != 0) {
+        const size_t alignedSize = (size + largePageSize - 1) / largePageSize * largePageSize;
+        void *address = VirtualAlloc(nullptr, alignedSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (address != nullptr) {
+            return address;
+        }
+    }
+
+    void *address = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    FATAL_ERROR_IF(address == nullptr, "Failed to allocate %zu bytes", size);
+    return address;
+}
+
+void freeHugePages(void *address, size_t) {
+    VirtualFree(address, 0, MEM_RELEASE);
+}
+
+const u8 *mapFile(const char *path, size_t &outSize) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    FATAL_ERROR_IF(file == INVALID_HANDLE_VALUE, "Failed to open %s", path);
+
+    LARGE_INTEGER fileSize = {};
+    const bool sizeQueried = GetFileSizeEx(file, &fileSize);
+    outSize = sizeQueried ? static_cast<size_t>(fileSize.QuadPart) : 0;
+    const void *address = nullptr;
+    if (outSize != 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+    FATAL_ERROR_IF(!sizeQueried || (outSize != 0 && address == nullptr), "Failed to map %s", path);
+    return static_cast<const u8 *>(address);
+}
+
+void unmapFile(const u8 *address, size_t) {
+    if (address != nullptr) {
+        UnmapViewOfFile(address);
+    }
+}
+} // namespace OsMemory
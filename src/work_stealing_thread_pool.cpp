@@ -0,0 +1,150 @@
+#include "work_stealing_thread_pool.h"
+
+#include "src/error.h"
+
+#include <algorithm>
+
+namespace {
+thread_local const void *currentPool = nullptr;
+thread_local u32 currentWorkerIndex = WorkStealingThreadPool::invalidWorkerIndex;
+} // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(u32 threadsCount) {
+    if (threadsCount == 0) {
+        threadsCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(threadsCount);
+    for (u32 workerIndex = 0; workerIndex < threadsCount; workerIndex++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (u32 workerIndex = 0; workerIndex < threadsCount; workerIndex++) {
+        workers[workerIndex]->thread = std::thread{&WorkStealingThreadPool::workerLoop, this, workerIndex};
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+    waitForIdle();
+    {
+        std::lock_guard<std::mutex> lock{sleepMutex};
+        stopping = true;
+    }
+    wakeUpCondition.notify_all();
+    for (auto &worker : workers) {
+        worker->thread.join();
+    }
+}
+
+void WorkStealingThreadPool::submit(Task task) {
+    push(std::move(task), false);
+}
+
+void WorkStealingThreadPool::submitLast(Task task) {
+    push(std::move(task), true);
+}
+
+void WorkStealingThreadPool::push(Task task, bool last) {
+    u32 workerIndex = 0;
+    if (currentPool == this) {
+        workerIndex = currentWorkerIndex;
+    } else {
+        workerIndex = nextWorkerIndex++ % getThreadsCount();
+    }
+
+    pendingTasks++;
+    {
+        Worker &worker = *workers[workerIndex];
+        std::lock_guard<std::mutex> workerLock{worker.mutex};
+        if (last) {
+            worker.tasks.push_front(std::move(task));
+        } else {
+            worker.tasks.push_back(std::move(task));
+        }
+    }
+
+    // Worker going to sleep counts itself before it checks the queues, so either it sees the task or we see
+    // the worker. Notifying under the lock makes sure it already waits.
+    if (sleepingWorkers.load() > 0) {
+        std::lock_guard<std::mutex> sleepLock{sleepMutex};
+        wakeUpCondition.notify_one();
+    }
+}
+
+void WorkStealingThreadPool::waitForIdle() {
+    FATAL_ERROR_IF(currentPool == this, "Cannot wait for thread pool from its worker");
+
+    std::unique_lock<std::mutex> lock{sleepMutex};
+    idleCondition.wait(lock, [this]() { return pendingTasks.load() == 0; });
+}
+
+u32 WorkStealingThreadPool::getCurrentWorkerIndex() {
+    return currentWorkerIndex;
+}
+
+void WorkStealingThreadPool::workerLoop(u32 workerIndex) {
+    currentPool = this;
+    currentWorkerIndex = workerIndex;
+
+    Task task{};
+    while (true) {
+        if (popTask(workerIndex, task) || stealTask(workerIndex, task)) {
+            task();
+            task = {};
+
+            if (--pendingTasks == 0) {
+                std::lock_guard<std::mutex> lock{sleepMutex};
+                idleCondition.notify_all();
+            }
+            continue;
+        }
+
+        // No work found. Sleep until something is submitted. We have to check the queues once again after
+        // announcing the sleep, because a task could have been submitted after we looked at the queues.
+        sleepingWorkers++;
+        bool stopRequested = false;
+        {
+            std::unique_lock<std::mutex> lock{sleepMutex};
+            wakeUpCondition.wait(lock, [&]() { return stopping || hasAnyTask(); });
+            stopRequested = stopping;
+        }
+        sleepingWorkers--;
+        if (stopRequested) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingThreadPool::popTask(u32 workerIndex, Task &outTask) {
+    Worker &worker = *workers[workerIndex];
+    std::lock_guard<std::mutex> lock{worker.mutex};
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    outTask = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingThreadPool::hasAnyTask() {
+    for (auto &worker : workers) {
+        std::lock_guard<std::mutex> workerLock{worker->mutex};
+        if (!worker->tasks.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingThreadPool::stealTask(u32 thiefIndex, Task &outTask) {
+    const u32 threadsCount = getThreadsCount();
+    for (u32 i = 1; i < threadsCount; i++) {
+        Worker &victim = *workers[(thiefIndex + i) % threadsCount];
+        std::lock_guard<std::mutex> lock{victim.mutex};
+        if (!victim.tasks.empty()) {
+            outTask = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "src/types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool, in which every worker has its own queue of tasks. Workers take the newest tasks from the back
+// of their own queue, which are the most likely to be in cache, and, when it's empty, steal the oldest tasks
+// from the front of other queues. Tasks submitted from a worker thread go to its own queue, so a task can
+// cheaply resubmit itself or spawn new tasks. Submitting and finishing tasks touch only the queue and atomic
+// counters. The shared sleep lock is taken only when a worker actually sleeps or someone has to be woken up.
+class WorkStealingThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingThreadPool(u32 threadsCount = 0); // 0 means all hardware threads
+    ~WorkStealingThreadPool();
+    WorkStealingThreadPool(const WorkStealingThreadPool &) = delete;
+    WorkStealingThreadPool &operator=(const WorkStealingThreadPool &) = delete;
+
+    void submit(Task task);
+    void submitLast(Task task); // task is run after all tasks already in the queue, for round-robin scheduling
+    void waitForIdle();
+
+    u32 getThreadsCount() const { return static_cast<u32>(workers.size()); }
+    static u32 getCurrentWorkerIndex(); // returns invalidWorkerIndex outside of worker threads
+    constexpr static u32 invalidWorkerIndex = 0xFFFFFFFF;
+
+private:
+    struct Worker {
+        std::mutex mutex = {};
+        std::deque<Task> tasks = {};
+        std::thread thread = {};
+    };
+
+    void push(Task task, bool last);
+    void workerLoop(u32 workerIndex);
+    bool popTask(u32 workerIndex, Task &outTask);
+    bool hasAnyTask();
+    bool stealTask(u32 thiefIndex, Task &outTask);
+
+    std::vector<std::unique_ptr<Worker>> workers = {};
+    std::atomic_uint32_t nextWorkerIndex = 0;
+
+    // Sleeping and waking up workers
+    std::atomic_uint32_t pendingTasks = 0;   // tasks submitted, but not finished yet
+    std::atomic_uint32_t sleepingWorkers = 0; // workers, which are about to sleep or sleep
+    std::mutex sleepMutex = {};
+    std::condition_variable wakeUpCondition = {};
+    std::condition_variable idleCondition = {};
+    bool stopping = false; // guarded by sleepMutex
+};
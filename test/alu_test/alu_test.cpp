@@ -0,0 +1,186 @@
+#include "alu_test/reference_model.h"
+#include "src/lockstep_engine.h"
+#include "src/work_stealing_thread_pool.h"
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace ReferenceModel;
+
+// Description of an operation verified for all inputs. The register is the accumulator for arithmetic
+// operations and the compared register for comparisons. Shifts and rotates take their operand from
+// the accumulator, so they don't depend on the register value.
+struct AluOperation {
+    const char *name;
+    OpCode opCodeImmediate;
+    OpCode opCodeZeroPage;
+    u8 Registers::*reg;
+    bool isDecimal;
+    bool isAccumulatorOperand;
+    u8 checkedFlags; // flags compared with the reference model
+    u8 ignoredFlags; // flags the processor doesn't model
+    void (*reference)(u8 reg, u8 carry, Results &out);
+};
+
+const AluOperation aluOperations[] = {
+    {"AdcBinary", OpCode::ADC_imm, OpCode::ADC_z, &Registers::a, false, false, flagC | flagZ | flagO | flagN, 0,
+     [](u8 reg, u8 carry, Results &out) { addWithCarry(reg, carry, false, out); }},
+    {"AdcDecimal", OpCode::ADC_imm, OpCode::ADC_z, &Registers::a, true, false, flagC, flagZ | flagO | flagN,
+     [](u8 reg, u8 carry, Results &out) { addDecimal(reg, carry, out); }},
+    {"SbcBinary", OpCode::SBC_imm, OpCode::SBC_z, &Registers::a, false, false, flagC | flagZ | flagO | flagN, 0,
+     [](u8 reg, u8 carry, Results &out) { addWithCarry(reg, carry, true, out); }},
+    {"SbcDecimal", OpCode::SBC_imm, OpCode::SBC_z, &Registers::a, true, false, flagC, flagZ | flagO | flagN,
+     [](u8 reg, u8 carry, Results &out) { subtractDecimal(reg, carry, out); }},
+    {"Cmp", OpCode::CMP_imm, OpCode::CMP_z, &Registers::a, false, false, flagC | flagZ | flagN, 0,
+     [](u8 reg, u8, Results &out) { compare(reg, out); }},
+    {"Cpx", OpCode::CPX_imm, OpCode::CPX_z, &Registers::x, false, false, flagC | flagZ | flagN, 0,
+     [](u8 reg, u8, Results &out) { compare(reg, out); }},
+    {"Cpy", OpCode::CPY_imm, OpCode::CPY_z, &Registers::y, false, false, flagC | flagZ | flagN, 0,
+     [](u8 reg, u8, Results &out) { compare(reg, out); }},
+    {"Asl", OpCode::ASL_acc, OpCode::ASL_acc, &Registers::a, false, true, flagC | flagZ | flagN, 0,
+     [](u8, u8 carry, Results &out) { shiftLeft(carry, false, out); }},
+    {"Rol", OpCode::ROL_acc, OpCode::ROL_acc, &Registers::a, false, true, flagC | flagZ | flagN, 0,
+     [](u8, u8 carry, Results &out) { shiftLeft(carry, true, out); }},
+    {"Lsr", OpCode::LSR_acc, OpCode::LSR_acc, &Registers::a, false, true, flagC | flagZ | flagN, 0,
+     [](u8, u8 carry, Results &out) { shiftRight(carry, false, out); }},
+    {"Ror", OpCode::ROR_acc, OpCode::ROR_acc, &Registers::a, false, true, flagC | flagZ | flagN, 0,
+     [](u8, u8 carry, Results &out) { shiftRight(carry, true, out); }},
+};
+
+struct AluTest : testing::TestWithParam<AluOperation> {
+    constexpr static u16 programAddress = 0x0200;
+    constexpr static u16 operandAddress = 0x0010;
+
+    // Calls the check for every register value and carry on all hardware threads. Each task checks
+    // one register value, so it can reuse its processor for all operands.
+    template <typename CheckFunction>
+    void sweep(CheckFunction &&check) {
+        const AluOperation &operation = GetParam();
+        WorkStealingThreadPool threadPool{};
+        const u32 registerValuesCount = operation.isAccumulatorOperand ? 1 : operandsCount;
+        for (u32 regValue = 0; regValue < registerValuesCount; regValue++) {
+            if (operation.isDecimal && !isValidBcd(regValue)) {
+                continue;
+            }
+            threadPool.submit([&, regValue]() {
+                for (u8 carry = 0; carry < 2; carry++) {
+                    check(static_cast<u8>(regValue), carry);
+                }
+            });
+        }
+        threadPool.waitForIdle();
+
+        EXPECT_EQ(0u, mismatchesCount);
+        for (const std::string &mismatch : reportedMismatches) {
+            ADD_FAILURE() << mismatch;
+        }
+    }
+
+    Registers createInitialRegisters(u8 regValue, u8 carry, u8 operand) {
+        const AluOperation &operation = GetParam();
+        Registers regs{};
+        regs.a = 0x5A;
+        regs.x = 0x6B;
+        regs.y = 0x7C;
+        regs.sp = 0xFF;
+        regs.pc = programAddress;
+        regs.*operation.reg = operation.isAccumulatorOperand ? operand : regValue;
+
+        // Flags not modified by the operation are set opposite to the carry, so both of their values are checked
+        const u8 otherFlags = carry ? 0 : (flagZ | flagO | flagN);
+        regs.flags = StatusFlags::fromU8(carry | otherFlags | (operation.isDecimal ? flagD : 0));
+        return regs;
+    }
+
+    bool isOperandSkipped(u32 operand) {
+        return GetParam().isDecimal && !isValidBcd(operand);
+    }
+
+    void verify(u8 regValue, u8 carry, u8 operand, const Results &expected, const Registers &initialRegs, const Registers &regs) {
+        const AluOperation &operation = GetParam();
+        const u8 comparedFlags = ~operation.ignoredFlags;
+        const u8 expectedFlags = static_cast<u8>((initialRegs.flags.toU8() & ~operation.checkedFlags) | expected.flags[operand]);
+        const u8 actualValue = regs.*operation.reg;
+        if (actualValue == expected.values[operand] && (regs.flags.toU8() & comparedFlags) == (expectedFlags & comparedFlags)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mismatchesMutex};
+        if (mismatchesCount++ < maxReportedMismatches) {
+            char message[256];
+            snprintf(message, sizeof(message), "%s reg=0x%02x operand=0x%02x carry=%u: value 0x%02x (expected 0x%02x), flags %s (expected %s)",
+                     operation.name, regValue, operand, carry, actualValue, expected.values[operand],
+                     regs.flags.toString().c_str(), StatusFlags::fromU8(expectedFlags).toString().c_str());
+            reportedMismatches.push_back(message);
+        }
+    }
+
+    static std::string constructParamName(const testing::TestParamInfo<AluOperation> &info) {
+        return info.param.name;
+    }
+
+    constexpr static u32 maxReportedMismatches = 10;
+    std::mutex mismatchesMutex = {};
+    u32 mismatchesCount = 0;
+    std::vector<std::string> reportedMismatches = {};
+};
+
+struct AluProcessor : Processor {
+    using Processor::memory;
+    using Processor::regs;
+};
+
+TEST_P(AluTest, givenAllInputsWhenExecutingOnProcessorThenResultsMatchReferenceModel) {
+    const AluOperation &operation = GetParam();
+    sweep([&](u8 regValue, u8 carry) {
+        Results expected{};
+        operation.reference(regValue, carry, expected);
+
+        AluProcessor processor{};
+        processor.memory[programAddress] = static_cast<u8>(operation.opCodeImmediate);
+        for (u32 operand = 0; operand < operandsCount; operand++) {
+            if (isOperandSkipped(operand)) {
+                continue;
+            }
+            const Registers initialRegs = createInitialRegisters(regValue, carry, static_cast<u8>(operand));
+            processor.regs = initialRegs;
+            processor.memory[programAddress + 1] = static_cast<u8>(operand);
+            processor.executeInstructions(1);
+            verify(regValue, carry, static_cast<u8>(operand), expected, initialRegs, processor.regs);
+        }
+    });
+}
+
+TEST_P(AluTest, givenAllInputsWhenExecutingOnLockstepEngineThenResultsMatchReferenceModel) {
+    // Every operand is executed in its own lane, so binary operations run through the vectorized kernels
+    const AluOperation &operation = GetParam();
+    const u8 program[] = {static_cast<u8>(operation.opCodeZeroPage), static_cast<u8>(operandAddress)};
+    const MemoryImage programImage{programAddress, sizeof(program), program};
+
+    sweep([&](u8 regValue, u8 carry) {
+        Results expected{};
+        operation.reference(regValue, carry, expected);
+
+        LockstepEngine engine{operandsCount};
+        engine.mapMemoryImage(programImage);
+        for (u32 lane = 0; lane < operandsCount; lane++) {
+            // Skipped operands are replaced with a valid one, so the lanes don't fault
+            const u8 operand = isOperandSkipped(lane) ? 0 : static_cast<u8>(lane);
+            engine.loadMemory(lane, operandAddress, 1, &operand);
+            engine.setRegisters(lane, createInitialRegisters(regValue, carry, operand));
+        }
+        engine.executeInstructions(1);
+
+        for (u32 lane = 0; lane < operandsCount; lane++) {
+            if (!isOperandSkipped(lane)) {
+                const u8 operand = static_cast<u8>(lane);
+                verify(regValue, carry, operand, expected, createInitialRegisters(regValue, carry, operand), engine.getRegisters(lane));
+            }
+        }
+    });
+}
+
+INSTANTIATE_TEST_SUITE_P(, AluTest, ::testing::ValuesIn(aluOperations), AluTest::constructParamName);
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "src/types.h"
+
+// Reference model of 6502 ALU operations written independently of the Processor. Every function computes
+// results for one register value and all 256 operand values at once. Loops have no branches and no
+// dependencies between iterations, so the compiler turns them into vector code.
+namespace ReferenceModel {
+
+constexpr static u32 operandsCount = 256;
+
+// Bits of the flags register, as in StatusFlags::toU8()
+constexpr static u8 flagC = 1 << 0;
+constexpr static u8 flagZ = 1 << 1;
+constexpr static u8 flagD = 1 << 3;
+constexpr static u8 flagO = 1 << 6;
+constexpr static u8 flagN = 1 << 7;
+
+struct Results {
+    u8 values[operandsCount];
+    u8 flags[operandsCount]; // only the flags modified by the operation
+};
+
+inline u8 zeroAndNegative(u32 value) {
+    value &= 0xFF;
+    return static_cast<u8>((value == 0 ? flagZ : 0) | (value & flagN));
+}
+
+// Binary ADC. SBC is the same operation with inverted operands.
+inline void addWithCarry(u8 a, u8 carry, bool invertOperands, Results &out) {
+    for (u32 operand = 0; operand < operandsCount; operand++) {
+        const u32 value = invertOperands ? (operand ^ 0xFF) : operand;
+        const u32 sum = a + value + carry;
+        const u32 overflow = (a ^ sum) & (value ^ sum) & 0x80;
+        out.values[operand] = static_cast<u8>(sum);
+        out.flags[operand] = static_cast<u8>((sum >> 8) | (overflow >> 1) | zeroAndNegative(sum));
+    }
+}
+
+// Decimal ADC for valid BCD operands, as in NMOS 6502. Only the carry flag is checked.
+inline void addDecimal(u8 a, u8 carry, Results &out) {
+    for (u32 operand = 0; operand < operandsCount; operand++) {
+        u32 lo = (a & 0x0F) + (operand & 0x0F) + carry;
+        lo = lo > 0x09 ? lo + 0x06 : lo;
+        u32 sum = (a & 0xF0) + (operand & 0xF0) + (lo > 0x0F ? 0x10 : 0) + (lo & 0x0F);
+        sum = sum > 0x9F ? sum + 0x60 : sum;
+        out.values[operand] = static_cast<u8>(sum);
+        out.flags[operand] = static_cast<u8>(sum >> 8);
+    }
+}
+
+// Decimal SBC for valid BCD operands, as in NMOS 6502. Only the carry flag is checked.
+inline void subtractDecimal(u8 a, u8 carry, Results &out) {
+    for (u32 operand = 0; operand < operandsCount; operand++) {
+        int lo = (a & 0x0F) - static_cast<int>(operand & 0x0F) + carry - 1;
+        lo = lo < 0 ? ((lo - 0x06) & 0x0F) - 0x10 : lo;
+        int difference = (a & 0xF0) - static_cast<int>(operand & 0xF0) + lo;
+        difference = difference < 0 ? difference - 0x60 : difference;
+        const int binaryDifference = a - static_cast<int>(operand) + carry - 1;
+        out.values[operand] = static_cast<u8>(difference);
+        out.flags[operand] = binaryDifference >= 0 ? flagC : 0;
+    }
+}
+
+// CMP, CPX and CPY. Register value is the first argument, operands are compared against it.
+inline void compare(u8 reg, Results &out) {
+    for (u32 operand = 0; operand < operandsCount; operand++) {
+        const u32 difference = reg + (operand ^ 0xFF) + 1;
+        out.values[operand] = reg;
+        out.flags[operand] = static_cast<u8>((difference >> 8) | zeroAndNegative(difference));
+    }
+}
+
+// ASL, LSR, ROL and ROR. Shifted value is the operand and carry is shifted in only when rotating.
+inline void shiftLeft(u8 carry, bool rotate, Results &out) {
+    for (u32 operand = 0; operand < operandsCount; operand++) {
+        const u32 shifted = (operand << 1) | (rotate ? carry : 0);
+        out.values[operand] = static_cast<u8>(shifted);
+        out.flags[operand] = static_cast<u8>((shifted >> 8) | zeroAndNegative(shifted));
+    }
+}
+
+inline void shiftRight(u8 carry, bool rotate, Results &out) {
+    for (u32 operand = 0; operand < operandsCount; operand++) {
+        const u32 shifted = (operand >> 1) | (rotate ? carry << 7 : 0);
+        out.values[operand] = static_cast<u8>(shifted);
+        out.flags[operand] = static_cast<u8>((operand & 1) | zeroAndNegative(shifted));
+    }
+}
+
+inline bool isValidBcd(u32 value) {
+    return (value & 0x0F) <= 0x09 && (value & 0xF0) <= 0x90;
+}
+
+} // namespace ReferenceModel
@@ -0,0 +1,31 @@
+#include "src/disassembler.h"
+
+#include <benchmark/benchmark.h>
+
+// Disassembles the whole memory filled with pseudo-random bytes, so all opcodes and operand kinds are
+// rendered. The rate is the size of the produced text.
+static void benchmarkDisassembleMemory(benchmark::State &state) {
+    Memory memory{};
+    u32 seed = 1;
+    for (u32 address = 0; address < memorySize; address++) {
+        seed = seed * 1103515245 + 12345;
+        memory.write(static_cast<u16>(address), static_cast<u8>(seed >> 16));
+    }
+
+    SymbolTable symbols{};
+    if (state.range(0) != 0) {
+        for (u32 address = 0; address < memorySize; address += 64) {
+            symbols.add("label" + std::to_string(address), static_cast<u16>(address));
+        }
+    }
+    Disassembler disassembler{&symbols};
+
+    u64 textSize = 0;
+    for (auto _ : state) {
+        const std::string_view text = disassembler.disassembleRange(memory, 0, memorySize);
+        benchmark::DoNotOptimize(text.data());
+        textSize += text.size();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(textSize));
+}
+BENCHMARK(benchmarkDisassembleMemory)->ArgName("symbols")->Arg(0)->Arg(1);
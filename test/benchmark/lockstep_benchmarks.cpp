@@ -0,0 +1,94 @@
+#include "src/lockstep_engine.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+// Compares the LockstepEngine with the same number of separate processors, executing the same program with
+// a different input in every lane. The program scrambles its input in a loop of instructions, which all have
+// lockstep implementations, so the lanes never diverge. Time per instruction counts instructions of all lanes.
+
+namespace {
+constexpr u16 codeAddress = 0x0400;
+constexpr u8 inputAddress = 0x10;
+constexpr u32 instructionsPerRun = 16 * 1024;
+
+const std::vector<u8> program = {
+    static_cast<u8>(OpCode::LDX_imm), 0x00,
+    static_cast<u8>(OpCode::LDA_z), inputAddress,
+    static_cast<u8>(OpCode::CLC),                 // loop:
+    static_cast<u8>(OpCode::ADC_imm), 0x37,
+    static_cast<u8>(OpCode::ROL_acc),
+    static_cast<u8>(OpCode::EOR_imm), 0x5A,
+    static_cast<u8>(OpCode::STA_z), 0x11,
+    static_cast<u8>(OpCode::INX),
+    static_cast<u8>(OpCode::CPX_imm), 0x10,
+    static_cast<u8>(OpCode::BNE), 0xF3,           // bne loop
+    static_cast<u8>(OpCode::JMP_abs), 0x00, 0x04, // jmp start
+};
+
+Registers createInitialRegisters() {
+    Registers regs{};
+    regs.pc = codeAddress;
+    regs.sp = 0xFF;
+    return regs;
+}
+
+void setCounters(benchmark::State &state, u64 instructions) {
+    using benchmark::Counter;
+    state.counters["time/instr"] = Counter(static_cast<double>(instructions), Counter::kIsRate | Counter::kInvert);
+}
+} // namespace
+
+static void benchmarkLockstepEngine(benchmark::State &state) {
+    const u32 laneCount = static_cast<u32>(state.range(0));
+    const MemoryImage image{codeAddress, static_cast<u32>(program.size()), program.data()};
+
+    LockstepEngine engine{laneCount};
+    engine.mapMemoryImage(image);
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        const u8 input = static_cast<u8>(lane);
+        engine.loadMemory(lane, inputAddress, 1, &input);
+        engine.setRegisters(lane, createInitialRegisters());
+    }
+
+    for (auto _ : state) {
+        engine.executeInstructions(instructionsPerRun);
+    }
+
+    if (engine.getStatistics().scalarInstructions != 0) {
+        state.SkipWithError("Lanes diverged");
+        return;
+    }
+    setCounters(state, u64(state.iterations()) * instructionsPerRun * laneCount);
+}
+
+static void benchmarkSeparateProcessors(benchmark::State &state) {
+    const u32 laneCount = static_cast<u32>(state.range(0));
+    const MemoryImage image{codeAddress, static_cast<u32>(program.size()), program.data()};
+
+    std::vector<std::unique_ptr<Processor>> processors{};
+    for (u32 lane = 0; lane < laneCount; lane++) {
+        auto processor = std::make_unique<Processor>();
+        const u8 input = static_cast<u8>(lane);
+        processor->mapMemoryImage(image);
+        processor->loadMemory(inputAddress, 1, &input);
+        ProcessorState processorState = processor->saveState();
+        processorState.regs = createInitialRegisters();
+        processor->restoreState(processorState);
+        processors.push_back(std::move(processor));
+    }
+
+    for (auto _ : state) {
+        for (auto &processor : processors) {
+            if (processor->executeInstructions(instructionsPerRun).stopReason != StopReason::BudgetExhausted) {
+                state.SkipWithError("Program stopped");
+                return;
+            }
+        }
+    }
+    setCounters(state, u64(state.iterations()) * instructionsPerRun * laneCount);
+}
+
+BENCHMARK(benchmarkLockstepEngine)->RangeMultiplier(4)->Range(4, 256);
+BENCHMARK(benchmarkSeparateProcessors)->RangeMultiplier(4)->Range(4, 256);
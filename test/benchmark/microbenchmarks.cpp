@@ -0,0 +1,231 @@
+#include "src/processor.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HOST_CYCLES_AVAILABLE 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define HOST_CYCLES_AVAILABLE 1
+#else
+#define HOST_CYCLES_AVAILABLE 0
+#endif
+
+// Matrix of microbenchmarks, one for each supported opcode. Each of them executes the same instruction in
+// a tight loop, so the cost of fetching, decoding and resolving the addressing mode can be compared between
+// opcodes and between commits. Indexed addressing modes, which may cross a page boundary, are measured
+// in both variants. Results can be exported with --benchmark_format=json or csv.
+//
+// Most instructions are repeated in a block of 64 copies followed by a jump back to the beginning. Instructions,
+// which transfer the control, are set up to always land at the next copy or at themselves.
+
+namespace {
+constexpr u16 codeAddress = 0x0400;
+constexpr u32 blockSize = 64;
+constexpr u32 instructionsPerIteration = 64 * 1024;
+
+// Operands used by the instructions. Both index registers are set to indexValue.
+constexpr u8 immediateValue = 0x01;
+constexpr u8 zeroPageAddress = 0x80;
+constexpr u8 indexValue = 0x20;
+constexpr u16 absoluteAddress = 0x3000;
+constexpr u16 absoluteAddressPageCross = 0x30F0; // crosses to the next page after adding indexValue
+
+// RTS and RTI are executed with a stack filled with this value, so they return to themselves
+constexpr u8 returnStackValue = 0x35;
+constexpr u16 rtiAddress = returnStackValue * 0x0101;
+constexpr u16 rtsAddress = rtiAddress + 1;
+
+const char *getAddressingModeName(AddressingMode mode) {
+    switch (mode) {
+    case AddressingMode::Accumulator:
+        return "Accumulator";
+    case AddressingMode::Implied:
+        return "Implied";
+    case AddressingMode::Immediate:
+        return "Immediate";
+    case AddressingMode::ZeroPage:
+        return "ZeroPage";
+    case AddressingMode::ZeroPageX:
+        return "ZeroPageX";
+    case AddressingMode::ZeroPageY:
+        return "ZeroPageY";
+    case AddressingMode::Absolute:
+        return "Absolute";
+    case AddressingMode::AbsoluteX:
+        return "AbsoluteX";
+    case AddressingMode::AbsoluteY:
+        return "AbsoluteY";
+    case AddressingMode::IndexedIndirectX:
+        return "IndexedIndirectX";
+    case AddressingMode::IndirectIndexedY:
+        return "IndirectIndexedY";
+    case AddressingMode::Indirect:
+        return "Indirect";
+    case AddressingMode::Relative:
+        return "Relative";
+    default:
+        return "Unknown";
+    }
+}
+
+bool canCrossPage(AddressingMode mode) {
+    return mode == AddressingMode::AbsoluteX || mode == AddressingMode::AbsoluteY || mode == AddressingMode::IndirectIndexedY;
+}
+
+// Writes one copy of the instruction at given address and returns its size
+u16 writeInstruction(Memory &memory, u16 address, u8 opCode, bool pageCross) {
+    const u16 absoluteOperand = pageCross ? absoluteAddressPageCross : absoluteAddress;
+    memory.write(address, opCode);
+    switch (Processor::getAddressingMode(opCode)) {
+    case AddressingMode::Accumulator:
+    case AddressingMode::Implied:
+        return 1;
+    case AddressingMode::Immediate:
+        memory.write(address + 1, immediateValue);
+        return 2;
+    case AddressingMode::ZeroPage:
+    case AddressingMode::ZeroPageX:
+    case AddressingMode::ZeroPageY:
+        memory.write(address + 1, zeroPageAddress);
+        return 2;
+    case AddressingMode::IndexedIndirectX:
+        memory.write(address + 1, static_cast<u8>(zeroPageAddress - indexValue));
+        return 2;
+    case AddressingMode::IndirectIndexedY:
+        memory.write(address + 1, zeroPageAddress);
+        return 2;
+    case AddressingMode::Relative:
+        memory.write(address + 1, 0); // taken or not, the branch lands at the next instruction
+        return 2;
+    case AddressingMode::Absolute:
+    case AddressingMode::AbsoluteX:
+    case AddressingMode::AbsoluteY:
+        if (opCode == static_cast<u8>(OpCode::JSR)) {
+            memory.write(address + 1, static_cast<u8>(address + 3));
+            memory.write(address + 2, static_cast<u8>((address + 3) >> 8));
+        } else {
+            memory.write(address + 1, static_cast<u8>(absoluteOperand));
+            memory.write(address + 2, static_cast<u8>(absoluteOperand >> 8));
+        }
+        return 3;
+    case AddressingMode::Indirect:
+        memory.write(address + 1, zeroPageAddress);
+        memory.write(address + 2, 0);
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+ProcessorState createInitialState(u8 opCode, bool pageCross) {
+    Processor processor{};
+    ProcessorState state = processor.saveState();
+    state.regs.a = 0x01;
+    state.regs.x = indexValue;
+    state.regs.y = indexValue;
+    state.regs.sp = 0xFF;
+    state.regs.pc = codeAddress;
+
+    // Pointer used by indirect modes
+    const u16 pointer = pageCross ? absoluteAddressPageCross : absoluteAddress;
+    state.memory.write(zeroPageAddress, static_cast<u8>(pointer));
+    state.memory.write(zeroPageAddress + 1, static_cast<u8>(pointer >> 8));
+
+    switch (static_cast<OpCode>(opCode)) {
+    case OpCode::JMP_abs:
+        state.memory.write(codeAddress, opCode);
+        state.memory.write(codeAddress + 1, static_cast<u8>(codeAddress));
+        state.memory.write(codeAddress + 2, static_cast<u8>(codeAddress >> 8));
+        break;
+    case OpCode::JMP_i:
+        writeInstruction(state.memory, codeAddress, opCode, pageCross);
+        state.memory.write(zeroPageAddress, static_cast<u8>(codeAddress));
+        state.memory.write(zeroPageAddress + 1, static_cast<u8>(codeAddress >> 8));
+        break;
+    case OpCode::BRK:
+        state.memory.write(codeAddress, opCode);
+        state.memory.write(0xFFFE, static_cast<u8>(codeAddress));
+        state.memory.write(0xFFFF, static_cast<u8>(codeAddress >> 8));
+        break;
+    case OpCode::RTS:
+    case OpCode::RTI:
+        state.regs.pc = static_cast<OpCode>(opCode) == OpCode::RTS ? rtsAddress : rtiAddress;
+        state.memory.write(state.regs.pc, opCode);
+        for (u16 address = 0x0100; address < 0x0200; address++) {
+            state.memory.write(address, returnStackValue);
+        }
+        break;
+    default: {
+        u16 address = codeAddress;
+        for (u32 i = 0; i < blockSize; i++) {
+            address += writeInstruction(state.memory, address, opCode, pageCross);
+        }
+        state.memory.write(address, static_cast<u8>(OpCode::JMP_abs));
+        state.memory.write(address + 1, static_cast<u8>(codeAddress));
+        state.memory.write(address + 2, static_cast<u8>(codeAddress >> 8));
+        break;
+    }
+    }
+    return state;
+}
+
+void benchmarkOpCode(benchmark::State &state, u8 opCode, bool pageCross) {
+    Processor processor{};
+    ProcessorState initialState = createInitialState(opCode, pageCross);
+    processor.restoreState(initialState);
+
+    u64 instructions = 0;
+    [[maybe_unused]] u64 hostCycles = 0;
+    for (auto _ : state) {
+        const u32 instructionsBefore = processor.getCounters().instructionsProcessed;
+#if HOST_CYCLES_AVAILABLE
+        const u64 hostCyclesBefore = __rdtsc();
+#endif
+        const ExecutionResult result = processor.executeInstructions(instructionsPerIteration);
+#if HOST_CYCLES_AVAILABLE
+        hostCycles += __rdtsc() - hostCyclesBefore;
+#endif
+        if (!result) {
+            const std::string error = std::string{"Execution stopped: "} + getStopReasonName(result.stopReason);
+            state.SkipWithError(error.c_str());
+            return;
+        }
+        instructions += processor.getCounters().instructionsProcessed - instructionsBefore;
+
+        // Start over before the 32-bit counters overflow
+        if (processor.getCounters().cyclesProcessed > 0x80000000u) {
+            processor.restoreState(initialState);
+        }
+    }
+
+    using benchmark::Counter;
+    state.counters["time/instr"] = Counter(static_cast<double>(instructions), Counter::kIsRate | Counter::kInvert);
+#if HOST_CYCLES_AVAILABLE
+    // Time stamp counter ticks at a constant reference frequency, which may differ from the actual core clock
+    state.counters["tsc/instr"] = Counter(static_cast<double>(hostCycles) / static_cast<double>(instructions));
+#endif
+}
+
+const bool microbenchmarksRegistered = []() {
+    for (u32 opCode = 0; opCode <= 0xFF; opCode++) {
+        if (!Processor::isInstructionSupported(static_cast<u8>(opCode))) {
+            continue;
+        }
+
+        const AddressingMode mode = Processor::getAddressingMode(static_cast<u8>(opCode));
+        char name[64];
+        snprintf(name, sizeof(name), "Opcode/%02X/%s/%s", opCode, Processor::getMnemonic(static_cast<u8>(opCode)), getAddressingModeName(mode));
+        if (canCrossPage(mode)) {
+            benchmark::RegisterBenchmark((std::string{name} + "/NoPageCross").c_str(), benchmarkOpCode, static_cast<u8>(opCode), false);
+            benchmark::RegisterBenchmark((std::string{name} + "/PageCross").c_str(), benchmarkOpCode, static_cast<u8>(opCode), true);
+        } else {
+            benchmark::RegisterBenchmark(name, benchmarkOpCode, static_cast<u8>(opCode), false);
+        }
+    }
+    return true;
+}();
+} // namespace
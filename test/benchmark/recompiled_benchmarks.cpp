@@ -0,0 +1,122 @@
+#include "benchmark/workloads.h"
+#include "src/recompiled_processor.h"
+
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+extern const RecompiledProgram sieveProgram;
+extern const RecompiledProgram crc32Program;
+extern const RecompiledProgram bubbleSortProgram;
+extern const RecompiledProgram quickSortProgram;
+extern const RecompiledProgram memcpyProgram;
+extern const RecompiledProgram bcdProgram;
+
+// Recompiled code cannot detect hangs, so the number of instructions needed to reach the end of the program
+// is found by executing it with a growing budget and then bisecting. The end is a jump to itself, so the
+// program is at the success address after every budget at least as big as the searched count.
+static bool findInstructionsCount(RecompiledProcessor &processor, ProcessorState &initialState, u16 successAddress, u32 &outCount) {
+    auto reachesEnd = [&](u32 budget) {
+        processor.restoreState(initialState);
+        return processor.executeRecompiled(budget).pc == successAddress;
+    };
+
+    constexpr u32 maxInstructionCount = 1'000'000'000;
+    u32 budget = 1 << 16;
+    while (!reachesEnd(budget)) {
+        if (budget >= maxInstructionCount) {
+            return false;
+        }
+        budget *= 2;
+    }
+
+    u32 low = budget / 2; // doesn't reach the end, unless it's the initial budget
+    u32 high = budget;
+    while (low + 1 < high) {
+        const u32 middle = low + (high - low) / 2;
+        (reachesEnd(middle) ? high : low) = middle;
+    }
+    outCount = high;
+    return true;
+}
+
+// Benchmark programs recompiled to C++ at build time, executed until they reach the end of the program.
+static void benchmarkRecompiledWorkload(benchmark::State &state, const Workload &workload, const RecompiledProgram &program) {
+    std::ifstream file{workload.path, std::ios::in | std::ios::binary};
+    if (!file) {
+        state.SkipWithError("Failed loading the program");
+        return;
+    }
+    const std::vector<u8> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    const MemoryImage image{workload.loadAddress, static_cast<u32>(data.size()), data.data()};
+    RecompiledProcessor processor{program};
+    processor.mapMemoryImage(image);
+    processor.loadProgramCounter(workload.startPc);
+    ProcessorState initialState = processor.saveState();
+
+    u32 instructionsCount = 0;
+    if (!findInstructionsCount(processor, initialState, workload.successAddress, instructionsCount)) {
+        state.SkipWithError("Program did not end at the success address");
+        return;
+    }
+
+    u64 cycles = 0;
+    u64 instructions = 0;
+    const u32 interpretedBefore = processor.getInterpretedInstructionsCount();
+    for (auto _ : state) {
+        processor.restoreState(initialState);
+        const ExecutionResult result = processor.executeRecompiled(instructionsCount);
+        if (result.pc != workload.successAddress) {
+            state.SkipWithError("Program did not end at the success address");
+            return;
+        }
+        cycles += result.cyclesExecuted;
+        instructions += result.instructionsExecuted;
+    }
+
+    using benchmark::Counter;
+    state.counters["clock"] = Counter(static_cast<double>(cycles), Counter::kIsRate);
+    state.counters["time/instr"] = Counter(static_cast<double>(instructions), Counter::kIsRate | Counter::kInvert);
+    state.counters["instructions"] = Counter(static_cast<double>(instructions), Counter::kAvgIterations);
+    state.counters["interpreted"] = Counter(static_cast<double>(processor.getInterpretedInstructionsCount() - interpretedBefore), Counter::kAvgIterations);
+}
+
+// Writes to a data byte on a page with recompiled code are trapped, unlike writes to other pages
+static void benchmarkRecompiledWrite(benchmark::State &state, u16 address) {
+    RecompiledProcessor processor{sieveProgram};
+    u64 writes = 0;
+    for (auto _ : state) {
+        for (u32 i = 0; i < 4096; i++) {
+            benchmark::DoNotOptimize(processor.write(address, static_cast<u8>(i)));
+        }
+        writes += 4096;
+    }
+
+    using benchmark::Counter;
+    state.counters["time/write"] = Counter(static_cast<double>(writes), Counter::kIsRate | Counter::kInvert);
+}
+
+BENCHMARK_CAPTURE(benchmarkRecompiledWrite, DataPage, u16{0x0600});
+BENCHMARK_CAPTURE(benchmarkRecompiledWrite, CodePage, u16{0x04F0});
+
+static const bool recompiledWorkloadsRegistered = []() {
+    const std::pair<const char *, const RecompiledProgram *> programs[] = {
+        {"Sieve", &sieveProgram},
+        {"Crc32", &crc32Program},
+        {"BubbleSort", &bubbleSortProgram},
+        {"QuickSort", &quickSortProgram},
+        {"Memcpy", &memcpyProgram},
+        {"Bcd", &bcdProgram},
+    };
+    for (const Workload &workload : getWorkloads()) {
+        for (const auto &[name, program] : programs) {
+            if (strcmp(workload.name, name) == 0) {
+                const std::string benchmarkName = std::string{"Recompiled"} + name;
+                benchmark::RegisterBenchmark(benchmarkName.c_str(), benchmarkRecompiledWorkload, workload, *program)->Unit(benchmark::kMillisecond);
+            }
+        }
+    }
+    return true;
+}();
@@ -0,0 +1,52 @@
+#include "benchmark/workloads.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+
+static void benchmarkWorkload(benchmark::State &state, const Workload &workload) {
+    std::unique_ptr<WorkloadRunner> runner{};
+    try {
+        runner = std::make_unique<WorkloadRunner>(workload);
+    } catch (const std::exception &) {
+        state.SkipWithError("Failed loading the program");
+        return;
+    }
+
+    // Host counters are read only around whole runs, so they do not perturb the measurement
+    HostProfiler profiler{false};
+    runner->activateHostProfiler(&profiler);
+
+    u64 cycles = 0;
+    u64 instructions = 0;
+    for (auto _ : state) {
+        if (!runner->run()) {
+            state.SkipWithError("Program did not end at the success address");
+            return;
+        }
+        cycles += runner->getCounters().cyclesProcessed;
+        instructions += runner->getCounters().instructionsProcessed;
+    }
+
+    // Rates are computed from the measured time. Cycles per second are the emulated clock frequency and
+    // inverted instructions per second are the host time per instruction.
+    using benchmark::Counter;
+    state.counters["clock"] = Counter(static_cast<double>(cycles), Counter::kIsRate);
+    state.counters["time/instr"] = Counter(static_cast<double>(instructions), Counter::kIsRate | Counter::kInvert);
+    state.counters["instructions"] = Counter(static_cast<double>(instructions), Counter::kAvgIterations);
+
+    if (profiler.isAvailable()) {
+        const HostCounterValues &total = profiler.getTotal();
+        const double emulatedInstructions = static_cast<double>(profiler.getEmulatedInstructions());
+        state.counters["host instr/instr"] = static_cast<double>(total[HostEvent::Instructions]) / emulatedInstructions;
+        state.counters["host cycles/instr"] = static_cast<double>(total[HostEvent::Cycles]) / emulatedInstructions;
+        state.counters["branch misses/instr"] = static_cast<double>(total[HostEvent::BranchMisses]) / emulatedInstructions;
+        state.counters["L1D misses/instr"] = static_cast<double>(total[HostEvent::L1DataMisses]) / emulatedInstructions;
+    }
+}
+
+static const bool workloadsRegistered = []() {
+    for (const Workload &workload : getWorkloads()) {
+        benchmark::RegisterBenchmark(workload.name, benchmarkWorkload, workload)->Unit(benchmark::kMillisecond);
+    }
+    return true;
+}();
@@ -0,0 +1,44 @@
+#include "workloads.h"
+
+#include "src/error.h"
+
+#include <fstream>
+#include <iterator>
+
+const std::vector<Workload> &getWorkloads() {
+    // Benchmark programs are loaded at $0400 and end at $0403, or at $0406 when their result is wrong. Values
+    // for the functional test are taken from its .lst file, the same as in the functional test runner.
+    const std::string programs = BENCHMARK_PROGRAMS_DIRECTORY "/";
+    static const std::vector<Workload> workloads = {
+        {"Sieve", programs + "sieve.bin", 0, 0x0400, 0x0400, 0x0403},
+        {"Crc32", programs + "crc32.bin", 0, 0x0400, 0x0400, 0x0403},
+        {"BubbleSort", programs + "bubble_sort.bin", 0, 0x0400, 0x0400, 0x0403},
+        {"QuickSort", programs + "quick_sort.bin", 0, 0x0400, 0x0400, 0x0403},
+        {"Memcpy", programs + "memcpy.bin", 0, 0x0400, 0x0400, 0x0403},
+        {"Bcd", programs + "bcd.bin", 0, 0x0400, 0x0400, 0x0403},
+        {"FunctionalTest", FUNCTIONAL_TEST_BINARY_FILE, 0, 0x000A, 0x0400, 0x336d},
+    };
+    return workloads;
+}
+
+WorkloadRunner::WorkloadRunner(const Workload &workload) : workload(workload) {
+    std::ifstream file{workload.path, std::ios::in | std::ios::binary};
+    FATAL_ERROR_IF(!file, "Failed loading %s", workload.path.c_str());
+    const std::vector<u8> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    FATAL_ERROR_IF(data.size() <= workload.fileOffset, "Invalid program %s", workload.path.c_str());
+
+    const u32 size = static_cast<u32>(data.size() - workload.fileOffset);
+    image = std::make_unique<MemoryImage>(workload.loadAddress, size, data.data() + workload.fileOffset);
+    processor.mapMemoryImage(*image);
+    processor.loadProgramCounter(workload.startPc);
+    processor.activateHangDetector();
+    initialState = processor.saveState();
+}
+
+bool WorkloadRunner::run() {
+    // All workloads finish in well under a billion instructions
+    constexpr u32 maxInstructionCount = 1'000'000'000;
+    processor.restoreState(initialState);
+    const ExecutionResult result = processor.executeInstructions(maxInstructionCount);
+    return result.stopReason == StopReason::Hang && result.pc == workload.successAddress;
+}
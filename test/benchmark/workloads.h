@@ -0,0 +1,40 @@
+#pragma once
+
+#include "src/processor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Complete 6502 program executed as a benchmark. Programs are assembled with as65, verify their own results
+// and end in an infinite loop, which is detected by the hang detector. Wrong results are trapped in another
+// loop, and hanging at any other address than the success address means the program failed, so a broken
+// engine cannot produce good numbers.
+struct Workload {
+    const char *name;
+    std::string path;
+    u32 fileOffset;  // offset of the first loaded byte in the file
+    u16 loadAddress; // address of the first loaded byte
+    u16 startPc;
+    u16 successAddress;
+};
+
+const std::vector<Workload> &getWorkloads();
+
+// Processor with the workload mapped as a memory image, ready to be executed from the initial state many times.
+class WorkloadRunner {
+public:
+    explicit WorkloadRunner(const Workload &workload);
+
+    // Returns false, if the program did not end at the success address
+    bool run();
+
+    const Counters &getCounters() const { return processor.getCounters(); }
+    void activateHostProfiler(HostProfiler *profiler) { processor.activateHostProfiler(profiler); }
+
+private:
+    const Workload &workload;
+    std::unique_ptr<MemoryImage> image = {};
+    Processor processor = {};
+    ProcessorState initialState = {};
+};
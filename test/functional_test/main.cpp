@@ -1,65 +1,157 @@
+#include "src/differential_checker.h"
 #include "src/error.h"
+#include "src/image_loader.h"
 #include "src/processor.h"
+#include "src/symbol_table.h"
 
 #include <cstring>
-#include <fstream>
+#include <filesystem>
+
+// Programs with a result byte also reach the success address after a failure, so only a zero byte there
+// means the program passed. Other programs pass by reaching the success address.
+int verifyResult(const Processor &processor, const SymbolTable &symbols, const char *resultSymbol, u16 resultAddress) {
+    if (resultSymbol == nullptr) {
+        return 0;
+    }
+    const u8 result = processor.getMemory().read(resultAddress);
+    if (result != 0) {
+        INFO("Program ended with %s=%u", symbols.formatAddress(resultAddress).c_str(), static_cast<u32>(result));
+        return 1;
+    }
+    return 0;
+}
+
+// Executes the program on the Processor and on a LockstepEngine, comparing their states after every batch
+// of instructions. Test programs end in a jump to itself, so the program ends when the pc stops changing.
+int runDifferentialCheck(Processor &processor, const SymbolTable &symbols, u16 programSuccessAddress, const char *resultSymbol, u16 resultAddress) {
+    LockstepEngine lockstepEngine{1};
+    ProcessorState initialState = processor.saveState();
+    lockstepEngine.restoreState(0, initialState);
+
+    ProcessorExecutionEngine reference{processor};
+    LockstepExecutionEngine tested{lockstepEngine, 0};
+    DifferentialChecker checker{reference, tested, 10000};
+    auto execute = [&](u32 instructionCount) {
+        const DifferentialChecker::Result result = checker.executeInstructions(instructionCount);
+        if (result == DifferentialChecker::Result::Fault) {
+            const DifferentialChecker::Divergence &divergence = checker.getDivergence();
+            INFO("Both engines raised an error at instruction %u, pc=%s, opCode=0x%02x", divergence.instructionIndex, symbols.formatAddress(divergence.pc).c_str(), divergence.opCode);
+            return false;
+        }
+        if (result != DifferentialChecker::Result::Match) {
+            const DifferentialChecker::Divergence &divergence = checker.getDivergence();
+            INFO("Divergence at instruction %u, pc=%s, opCode=0x%02x", divergence.instructionIndex, symbols.formatAddress(divergence.pc).c_str(), divergence.opCode);
+            INFO("%s", divergence.description.c_str());
+            return false;
+        }
+        return true;
+    };
+
+    // Execute a batch of instructions and then a single instruction to see, if the pc changes.
+    u16 hangAddress = 0;
+    while (true) {
+        if (!execute(10000)) {
+            return 1;
+        }
+        hangAddress = processor.getRegisters().pc;
+        if (!execute(1)) {
+            return 1;
+        }
+        if (processor.getRegisters().pc == hangAddress) {
+            break;
+        }
+    }
+
+    if (hangAddress == programSuccessAddress) {
+        return verifyResult(processor, symbols, resultSymbol, resultAddress);
+    } else {
+        INFO("Hang detected at %s", symbols.formatAddress(hangAddress).c_str());
+        return 1;
+    }
+}
 
 int main(int argc, char **argv) {
     bool enableInstructionTracing = false;
+    bool enableDifferentialChecking = false;
     for (int argIndex = 1; argIndex < argc; argIndex++) {
         const char *arg = argv[argIndex];
         if (strcmp(arg, "-t") == 0) {
             enableInstructionTracing = true;
         }
+        if (strcmp(arg, "-d") == 0) {
+            enableDifferentialChecking = true;
+        }
     }
 
-    // These numbers are taken from .lst files. They could change if we change the programs
-    // or assembler, but it's not very likely, so let's just hardcode them.
+    // Load address of the binary is where the assembler started emitting bytes. Everything else is taken by
+    // name from the listing, which the assembler creates next to the binary. The success point of programs
+    // with traps is a macro invocation rather than a label, so it's looked up as a macro expansion.
 #if TEST_INDEX == 0
     // Functional test
     const u32 binaryStartOffset = 0x000A;
-    const u32 binarySize = 65526;
-    const u16 programStartAddress = 0x0400;
-    const u16 programSuccessAddress = 0x336d;
+    const char *startLabel = "start";
+    const char *successSymbol = "success";
+    const SymbolTable::Kind successSymbolKind = SymbolTable::Kind::MacroExpansion;
+    const char *resultSymbol = nullptr;
 #elif TEST_INDEX == 1
     // Decimal test
     const u32 binaryStartOffset = 0x0200;
-    const u32 binarySize = 274;
-    const u16 programStartAddress = 0x0200;
-    const u16 programSuccessAddress = 0x024b; // not sure about that one
+    const char *startLabel = "TEST";
+    const char *successSymbol = "DONE";
+    const SymbolTable::Kind successSymbolKind = SymbolTable::Kind::Label;
+    const char *resultSymbol = "ERROR"; // failures branch to DONE as well
 #elif TEST_INDEX == 2
     // Interrupt test
     const u32 binaryStartOffset = 0x000A;
-    const u32 binarySize = 65526;
-    const u16 programStartAddress = 0x0400;
-    const u16 programSuccessAddress = 0x06f5;
+    const char *startLabel = "start";
+    const char *successSymbol = "success";
+    const SymbolTable::Kind successSymbolKind = SymbolTable::Kind::MacroExpansion;
+    const char *resultSymbol = nullptr;
 #else
 #error "Invalid test index"
 #endif
 
-    // Read program from file
-    std::ifstream file{TEST_BINARY_FILE, std::ios::in | std::ios::binary};
-    u8 binary[binarySize];
-    file.read(reinterpret_cast<char *>(binary), binarySize);
-    FATAL_ERROR_IF(!file, "Failed loading " TEST_BINARY_FILE);
+    const std::string listingPath = std::filesystem::path(TEST_BINARY_FILE).replace_extension(".lst").string();
+    SymbolTable symbols{};
+    u16 programStartAddress = 0;
+    u16 programSuccessAddress = 0;
+    FATAL_ERROR_IF(!symbols.loadFile(listingPath), "Failed loading %s", listingPath.c_str());
+    FATAL_ERROR_IF(!symbols.findAddress(startLabel, programStartAddress), "Label %s not found in %s", startLabel, listingPath.c_str());
+    FATAL_ERROR_IF(!symbols.findAddress(successSymbol, programSuccessAddress, successSymbolKind), "Symbol %s not found in %s", successSymbol, listingPath.c_str());
+    u16 resultAddress = 0;
+    FATAL_ERROR_IF(resultSymbol != nullptr && !symbols.findAddress(resultSymbol, resultAddress), "Label %s not found in %s", resultSymbol, listingPath.c_str());
+
+    // Map program from file. Its pages are shared with the file and copied only when the program writes them.
+    LoadedImage image{};
+    FATAL_ERROR_IF(!loadImageFile(TEST_BINARY_FILE, ImageFormat::Raw, binaryStartOffset, image), "Failed loading " TEST_BINARY_FILE ": %s", image.error);
 
     // Execute the program. If it ends, it's a success.
     Processor processor{};
-    processor.loadMemory(binaryStartOffset, binarySize, binary);
+    processor.mapMemoryImage(image.image);
     processor.loadProgramCounter(programStartAddress);
+    if (enableDifferentialChecking) {
+        return runDifferentialCheck(processor, symbols, programSuccessAddress, resultSymbol, resultAddress);
+    }
+    processor.setBreakpoint(programSuccessAddress);
     processor.activateHangDetector();
     if (enableInstructionTracing) {
-        processor.activateInstructionTracing();
+        processor.activateInstructionTracing(&symbols);
     }
-    processor.executeInstructions(0);
+    const ExecutionResult result = processor.executeInstructions(0);
 
-    // Verify success. The test program will always hang, but one designated location means
-    // it actually succeeded.
-    const u16 hangAddress = processor.getHangAddress();
-    if (hangAddress == programSuccessAddress) {
-        return 0;
-    } else {
-        INFO("Hang detected at 0x%04x", hangAddress);
+    // Verify success. The test programs trap failures in infinite loops, which are caught by the hang
+    // detector, or report them in the result byte.
+    switch (result.stopReason) {
+    case StopReason::Breakpoint:
+        return verifyResult(processor, symbols, resultSymbol, resultAddress);
+    case StopReason::InvalidOpcode:
+        INFO("Invalid opcode at %s", symbols.formatAddress(result.pc).c_str());
+        return 1;
+    case StopReason::Hang:
+        INFO("Hang detected at %s", symbols.formatAddress(result.pc).c_str());
+        return 1;
+    default:
+        INFO("Execution stopped at %s, reason: %s", symbols.formatAddress(processor.getRegisters().pc).c_str(), getStopReasonName(result.stopReason));
         return 1;
     }
 }
@@ -0,0 +1,127 @@
+#include "fuzz_target.h"
+
+#include "src/differential_checker.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+ProcessorState createInitialState(const u8 *data, size_t size) {
+    auto getByte = [&](size_t offset) -> u8 {
+        return offset < size ? data[offset] : 0;
+    };
+
+    Processor processor{};
+    ProcessorState state = processor.saveState();
+    state.regs.a = getByte(0);
+    state.regs.x = getByte(1);
+    state.regs.y = getByte(2);
+    state.regs.sp = getByte(3);
+    state.regs.flags = StatusFlags::fromU8(getByte(4));
+    state.regs.flags.d = 0;
+    state.regs.pc = FuzzInput::codeAddress;
+
+    if (size > FuzzInput::zeroPageOffset) {
+        const size_t zeroPageSize = std::min<size_t>(size - FuzzInput::zeroPageOffset, FuzzInput::zeroPageSize);
+        state.memory.load(0x0000, static_cast<u32>(zeroPageSize), data + FuzzInput::zeroPageOffset);
+    }
+    if (size > FuzzInput::codeOffset) {
+        const size_t codeSize = std::min<size_t>(size - FuzzInput::codeOffset, FuzzInput::maxCodeSize);
+        state.memory.load(FuzzInput::codeAddress, static_cast<u32>(codeSize), data + FuzzInput::codeOffset);
+    }
+    return state;
+}
+
+bool isDecimalArithmetic(u8 opCode, const Registers &regs) {
+    // All ADC opcodes have a form of 011xxx01 and all SBC opcodes have a form of 111xxx01.
+    const u8 group = opCode & 0b11100011;
+    return regs.flags.d && (group == 0b01100001 || group == 0b11100001);
+}
+
+bool checkInvariants(ProcessorState &initialState, u32 &instructionCount, std::string &outFailure) {
+    char message[128];
+    Processor processor{};
+    processor.restoreState(initialState);
+
+    for (u32 instructionIndex = 0; instructionIndex < instructionCount; instructionIndex++) {
+        const Registers regs = processor.getRegisters();
+        const Counters counters = processor.getCounters();
+        // Undocumented opcodes and decimal arithmetic on invalid BCD values, which is not implemented, stop the
+        // processor. Execution cannot continue after them, so only preceding instructions are checked further.
+        const u8 opCode = processor.getMemory().read(regs.pc);
+        const StopReason stopReason = processor.executeInstructions(1).stopReason;
+        if (!Processor::isInstructionSupported(opCode)) {
+            if (stopReason != StopReason::InvalidOpcode || processor.getRegisters().pc != regs.pc || processor.getCounters().cyclesProcessed != counters.cyclesProcessed) {
+                snprintf(message, sizeof(message), "Undocumented opcode 0x%02x at pc=0x%04x was not reported", opCode, regs.pc);
+                outFailure = message;
+                return false;
+            }
+            instructionCount = instructionIndex;
+            return true;
+        }
+        if (stopReason == StopReason::GuestError) {
+            if (isDecimalArithmetic(opCode, regs)) {
+                instructionCount = instructionIndex;
+                return true;
+            }
+            snprintf(message, sizeof(message), "Error raised by documented opcode 0x%02x at pc=0x%04x", opCode, regs.pc);
+            outFailure = message;
+            return false;
+        }
+
+        const Counters &newCounters = processor.getCounters();
+        const u32 bytesDelta = newCounters.bytesProcessed - counters.bytesProcessed;
+        const u32 cyclesDelta = newCounters.cyclesProcessed - counters.cyclesProcessed;
+        const u32 instructionsDelta = newCounters.instructionsProcessed - counters.instructionsProcessed;
+        if (bytesDelta < 1 || bytesDelta > 3 || cyclesDelta < 2 || cyclesDelta > 7 || instructionsDelta != 1) {
+            snprintf(message, sizeof(message), "Invalid counters change at pc=0x%04x: bytes=%u, cycles=%u, instructions=%u",
+                     regs.pc, bytesDelta, cyclesDelta, instructionsDelta);
+            outFailure = message;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool checkDifferential(ProcessorState &initialState, u32 instructionCount, std::string &outFailure) {
+    if (instructionCount == 0) {
+        return true;
+    }
+
+    Processor processor{};
+    processor.restoreState(initialState);
+    LockstepEngine lockstepEngine{1};
+    lockstepEngine.restoreState(0, initialState);
+
+    ProcessorExecutionEngine reference{processor};
+    LockstepExecutionEngine tested{lockstepEngine, 0};
+    DifferentialChecker checker{reference, tested, instructionCount};
+    if (checker.executeInstructions(instructionCount) != DifferentialChecker::Result::Divergence) {
+        return true;
+    }
+
+    const DifferentialChecker::Divergence &divergence = checker.getDivergence();
+    char message[128];
+    snprintf(message, sizeof(message), "Divergence from LockstepEngine at instruction %u, pc=0x%04x, opCode=0x%02x\n",
+             divergence.instructionIndex, divergence.pc, divergence.opCode);
+    outFailure = message + divergence.description;
+    return false;
+}
+} // namespace
+
+bool runFuzzInput(const u8 *data, size_t size, std::string &outFailure) {
+    ProcessorState initialState = createInitialState(data, size);
+    u32 instructionCount = (size > 5 ? data[5] : 0) + 1u;
+    return checkInvariants(initialState, instructionCount, outFailure) &&
+           checkDifferential(initialState, instructionCount, outFailure);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const u8 *data, size_t size) {
+    std::string failure{};
+    if (!runFuzzInput(data, size, failure)) {
+        fprintf(stderr, "%s\n", failure.c_str());
+        abort();
+    }
+    return 0;
+}
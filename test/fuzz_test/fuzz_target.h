@@ -0,0 +1,24 @@
+#pragma once
+
+#include "src/types.h"
+
+#include <cstddef>
+#include <string>
+
+// Layout of fuzzer input. Missing bytes are treated as zeros.
+//     bytes 0-4     registers a, x, y, sp and flags (decimal flag is always cleared)
+//     byte 5        number of instructions to execute minus one
+//     bytes 6-261   zero page
+//     bytes 262-    code loaded at codeAddress, where the execution starts
+namespace FuzzInput {
+constexpr u32 headerSize = 6;
+constexpr u32 zeroPageOffset = headerSize;
+constexpr u32 zeroPageSize = 256;
+constexpr u32 codeOffset = zeroPageOffset + zeroPageSize;
+constexpr u32 maxCodeSize = 512;
+constexpr u16 codeAddress = 0x0200;
+} // namespace FuzzInput
+
+// Executes the input on a Processor, checking invariants after every instruction, and then compares
+// the Processor with a LockstepEngine. Returns false and describes the problem if anything is wrong.
+bool runFuzzInput(const u8 *data, size_t size, std::string &outFailure);
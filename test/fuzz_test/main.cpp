@@ -0,0 +1,256 @@
+#include "fuzz_target.h"
+
+#include "src/error.h"
+#include "src/processor.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Standalone driver for the fuzz target, which doesn't need libFuzzer. It generates random machine states
+// and instruction streams, replays existing inputs (for example a libFuzzer corpus or previous failures) and
+// minimizes failing inputs. Generated memory contents consist only of documented opcodes, so the processor
+// rarely stops on an undocumented one, even after jumping into data.
+
+using Input = std::vector<u8>;
+
+Input readInput(const std::string &path) {
+    std::ifstream file{path, std::ios::in | std::ios::binary};
+    FATAL_ERROR_IF(!file, "Failed loading %s", path.c_str());
+    return Input{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void writeInput(const std::string &path, const Input &input) {
+    std::ofstream file{path, std::ios::out | std::ios::binary};
+    file.write(reinterpret_cast<const char *>(input.data()), input.size());
+    FATAL_ERROR_IF(!file, "Failed writing %s", path.c_str());
+}
+
+bool runInput(const Input &input, std::string &outFailure) {
+    return runFuzzInput(input.data(), input.size(), outFailure);
+}
+
+Input generateInput(std::mt19937 &random, const std::vector<u8> &documentedOpCodes) {
+    std::uniform_int_distribution<u32> byteDistribution{0, 0xFF};
+    std::uniform_int_distribution<size_t> opCodeDistribution{0, documentedOpCodes.size() - 1};
+    std::uniform_int_distribution<u32> codeSizeDistribution{1, 64};
+
+    Input input(FuzzInput::codeOffset + codeSizeDistribution(random));
+    for (u32 offset = 0; offset < FuzzInput::headerSize; offset++) {
+        input[offset] = static_cast<u8>(byteDistribution(random));
+    }
+    for (u32 offset = FuzzInput::headerSize; offset < input.size(); offset++) {
+        input[offset] = documentedOpCodes[opCodeDistribution(random)];
+    }
+    return input;
+}
+
+int minimizeInput(const std::string &path) {
+    Input input = readInput(path);
+    input.resize(std::max<size_t>(input.size(), FuzzInput::codeOffset));
+    std::string failure{};
+    if (runInput(input, failure)) {
+        INFO("Input %s does not fail", path.c_str());
+        return 1;
+    }
+
+    auto tryCandidate = [&](const Input &candidate) {
+        std::string candidateFailure{};
+        if (!runInput(candidate, candidateFailure)) {
+            input = candidate;
+            failure = candidateFailure;
+            return true;
+        }
+        return false;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        // Execute fewer instructions
+        while (input[5] > 0) {
+            Input candidate = input;
+            candidate[5]--;
+            if (!tryCandidate(candidate)) {
+                break;
+            }
+            changed = true;
+        }
+
+        // Remove chunks of code, starting from big ones
+        for (size_t chunkSize = (input.size() - FuzzInput::codeOffset + 1) / 2; chunkSize > 0; chunkSize /= 2) {
+            for (size_t offset = FuzzInput::codeOffset; offset + chunkSize <= input.size();) {
+                Input candidate = input;
+                candidate.erase(candidate.begin() + offset, candidate.begin() + offset + chunkSize);
+                if (tryCandidate(candidate)) {
+                    changed = true;
+                } else {
+                    offset += chunkSize;
+                }
+            }
+        }
+
+        // Clear unneeded zero page bytes
+        for (size_t offset = FuzzInput::zeroPageOffset; offset < FuzzInput::codeOffset; offset++) {
+            if (input[offset] != 0) {
+                Input candidate = input;
+                candidate[offset] = 0;
+                changed = tryCandidate(candidate) || changed;
+            }
+        }
+    }
+
+    const std::string outputPath = path + ".min";
+    writeInput(outputPath, input);
+    INFO("Minimized input written to %s (%zu bytes of code)", outputPath.c_str(), input.size() - FuzzInput::codeOffset);
+    INFO("%s", failure.c_str());
+    return 0;
+}
+
+int replayInputs(const std::vector<std::string> &paths) {
+    std::vector<std::string> files{};
+    for (const std::string &path : paths) {
+        if (std::filesystem::is_directory(path)) {
+            for (const auto &entry : std::filesystem::directory_iterator(path)) {
+                if (entry.is_regular_file()) {
+                    files.push_back(entry.path().string());
+                }
+            }
+        } else {
+            files.push_back(path);
+        }
+    }
+
+    int result = 0;
+    for (const std::string &file : files) {
+        std::string failure{};
+        if (!runInput(readInput(file), failure)) {
+            INFO("%s failed: %s", file.c_str(), failure.c_str());
+            result = 1;
+        }
+    }
+    INFO("Replayed %zu inputs", files.size());
+    return result;
+}
+
+void printUsage() {
+    INFO("Usage: emos_fuzz_test [options] [inputs...]");
+    INFO("Inputs can be files or directories. If any are given, they are executed instead of random inputs.");
+    INFO("Options:");
+    INFO("  -n <count>     number of random inputs to execute, 10000 by default");
+    INFO("  -s <seed>      seed of the random generator, 0 by default");
+    INFO("  -j <threads>   number of threads, all hardware threads by default");
+    INFO("  -o <dir>       directory to save failing inputs in, current directory by default");
+    INFO("  -m <file>      minimize failing input and save it as <file>.min");
+}
+
+int main(int argc, char **argv) {
+    u32 runsCount = 10000;
+    u32 seed = 0;
+    u32 threadsCount = std::max(1u, std::thread::hardware_concurrency());
+    std::string outputDirectory = ".";
+    std::vector<std::string> inputPaths{};
+
+    for (int argIndex = 1; argIndex < argc; argIndex++) {
+        const char *arg = argv[argIndex];
+        const bool hasValue = argIndex + 1 < argc;
+        const char *value = hasValue ? argv[argIndex + 1] : "";
+        if (arg[0] != '-') {
+            inputPaths.push_back(arg);
+            continue;
+        }
+        if (!hasValue) {
+            printUsage();
+            return 1;
+        }
+
+        if (strcmp(arg, "-n") == 0) {
+            runsCount = static_cast<u32>(strtoul(value, nullptr, 0));
+        } else if (strcmp(arg, "-s") == 0) {
+            seed = static_cast<u32>(strtoul(value, nullptr, 0));
+        } else if (strcmp(arg, "-j") == 0) {
+            threadsCount = std::max(1u, static_cast<u32>(strtoul(value, nullptr, 0)));
+        } else if (strcmp(arg, "-o") == 0) {
+            outputDirectory = value;
+        } else if (strcmp(arg, "-m") == 0) {
+            return minimizeInput(value);
+        } else {
+            printUsage();
+            return 1;
+        }
+        argIndex++;
+    }
+
+    if (!inputPaths.empty()) {
+        return replayInputs(inputPaths);
+    }
+
+    std::vector<u8> documentedOpCodes{};
+    for (u32 opCode = 0; opCode < 0x100; opCode++) {
+        if (Processor::isInstructionSupported(static_cast<u8>(opCode))) {
+            documentedOpCodes.push_back(static_cast<u8>(opCode));
+        }
+    }
+
+    // Every input is generated from the seed and its run index, so the inputs don't depend on the number of
+    // threads and on their scheduling. After a failure, threads still execute all runs with lower indices, so
+    // the reported failure is always the first one for given seed.
+    std::atomic_uint32_t nextRunIndex = 0;
+    std::atomic_uint32_t firstFailedRunIndex = std::numeric_limits<u32>::max();
+    std::mutex failureMutex{};
+    Input failedInput{};
+    std::string failure{};
+    auto fuzz = [&]() {
+        while (true) {
+            const u32 runIndex = nextRunIndex++;
+            if (runIndex >= runsCount || runIndex > firstFailedRunIndex) {
+                break;
+            }
+
+            std::seed_seq seedSequence{seed, runIndex};
+            std::mt19937 random{seedSequence};
+            const Input input = generateInput(random, documentedOpCodes);
+            std::string runFailure{};
+            if (!runInput(input, runFailure)) {
+                std::lock_guard lock{failureMutex};
+                if (runIndex < firstFailedRunIndex) {
+                    firstFailedRunIndex = runIndex;
+                    failedInput = input;
+                    failure = runFailure;
+                }
+            }
+        }
+    };
+
+    const auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads{};
+    for (u32 threadIndex = 0; threadIndex < threadsCount; threadIndex++) {
+        threads.emplace_back(fuzz);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    const auto endTime = std::chrono::steady_clock::now();
+
+    const auto totalTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    const u32 executedCount = std::min(nextRunIndex.load(), runsCount);
+    INFO("Executed %u inputs in %lld ms", executedCount, static_cast<long long>(totalTimeMs));
+    if (!failedInput.empty()) {
+        const std::string path = outputDirectory + "/crash-" + std::to_string(seed) + "-" + std::to_string(firstFailedRunIndex.load()) + ".bin";
+        writeInput(path, failedInput);
+        INFO("%s", failure.c_str());
+        INFO("Failing input saved to %s", path.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include "benchmark/workloads.h"
+#include "src/error.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Performance regression tests. Every workload is first executed once and its counters are compared with
+// golden values, which catches broken cycle accounting. Then all workloads are executed repeatedly and
+// the median host time per instruction is compared with a baseline. Medians and median absolute deviations
+// are not affected by a few outliers, for example runs preempted by other processes.
+
+struct GoldenValues {
+    const char *name;
+    u32 instructionsProcessed;
+    u32 cyclesProcessed;
+    u32 bytesProcessed;
+};
+
+// Counters include the final jump, which is fetched when the hang is detected
+const GoldenValues goldenValues[] = {
+    {"Sieve", 383164, 1221786, 814002},
+    {"Crc32", 482390, 1787069, 1099418},
+    {"BubbleSort", 533200, 1597294, 1147365},
+    {"QuickSort", 1042546, 3122864, 2169551},
+    {"Memcpy", 674294, 2549315, 1152522},
+    {"Bcd", 450309, 1400821, 1040720},
+};
+
+struct Measurement {
+    double median = 0;
+    double mad = 0; // median absolute deviation
+};
+
+using Baseline = std::map<std::string, Measurement>;
+
+struct Options {
+    std::string baselinePath = "perf_baseline.txt";
+    bool updateBaseline = false;
+    bool printHostProfile = false;
+    u32 runsCount = 15;
+};
+
+// Slowdown is reported if it exceeds both the noise and the minimum relative tolerance. MAD is scaled to be
+// comparable with a standard deviation of normally distributed values.
+constexpr double madToSigma = 1.4826;
+constexpr double toleranceSigmas = 4.0;
+constexpr double minRelativeTolerance = 0.10;
+
+const Workload *findWorkload(const char *name) {
+    for (const Workload &workload : getWorkloads()) {
+        if (strcmp(workload.name, name) == 0) {
+            return &workload;
+        }
+    }
+    return nullptr;
+}
+
+double computeMedian(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t middle = values.size() / 2;
+    return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+Measurement computeMeasurement(const std::vector<double> &values) {
+    Measurement result{};
+    result.median = computeMedian(values);
+    std::vector<double> deviations{};
+    for (double value : values) {
+        deviations.push_back(std::abs(value - result.median));
+    }
+    result.mad = computeMedian(deviations);
+    return result;
+}
+
+Baseline loadBaseline(const std::string &path) {
+    Baseline result{};
+    std::ifstream file{path};
+    std::string name{};
+    Measurement measurement{};
+    while (file >> name >> measurement.median >> measurement.mad) {
+        result[name] = measurement;
+    }
+    return result;
+}
+
+void saveBaseline(const std::string &path, const Baseline &baseline) {
+    std::ofstream file{path};
+    for (const auto &[name, measurement] : baseline) {
+        file << name << ' ' << measurement.median << ' ' << measurement.mad << '\n';
+    }
+    FATAL_ERROR_IF(!file, "Failed writing %s", path.c_str());
+}
+
+bool checkGoldenValues(std::vector<std::unique_ptr<WorkloadRunner>> &runners) {
+    bool result = true;
+    for (size_t index = 0; index < runners.size(); index++) {
+        const GoldenValues &golden = goldenValues[index];
+        if (!runners[index]->run()) {
+            INFO("%s: program did not end at the success address", golden.name);
+            result = false;
+            continue;
+        }
+
+        const Counters &counters = runners[index]->getCounters();
+        auto compare = [&](const char *counterName, u32 expected, u32 actual) {
+            if (expected != actual) {
+                INFO("%s: %s is %u, expected %u", golden.name, counterName, actual, expected);
+                result = false;
+            }
+        };
+        compare("instructionsProcessed", golden.instructionsProcessed, counters.instructionsProcessed);
+        compare("cyclesProcessed", golden.cyclesProcessed, counters.cyclesProcessed);
+        compare("bytesProcessed", golden.bytesProcessed, counters.bytesProcessed);
+    }
+    return result;
+}
+
+Baseline measureThroughput(std::vector<std::unique_ptr<WorkloadRunner>> &runners, u32 runsCount) {
+    // Workloads are interleaved, so a temporary slowdown of the machine affects all of them equally
+    std::vector<std::vector<double>> timesPerInstruction(runners.size());
+    for (u32 run = 0; run < runsCount; run++) {
+        for (size_t index = 0; index < runners.size(); index++) {
+            const auto startTime = std::chrono::steady_clock::now();
+            runners[index]->run();
+            const auto endTime = std::chrono::steady_clock::now();
+            const double timeNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+            timesPerInstruction[index].push_back(timeNs / runners[index]->getCounters().instructionsProcessed);
+        }
+    }
+
+    Baseline result{};
+    for (size_t index = 0; index < runners.size(); index++) {
+        result[goldenValues[index].name] = computeMeasurement(timesPerInstruction[index]);
+    }
+    return result;
+}
+
+bool compareWithBaseline(const Baseline &measured, const Baseline &baseline) {
+    bool result = true;
+    for (const auto &[name, measurement] : measured) {
+        const auto baselineEntry = baseline.find(name);
+        if (baselineEntry == baseline.end()) {
+            INFO("%-12s %.3f ns/instr, missing in the baseline", name.c_str(), measurement.median);
+            result = false;
+            continue;
+        }
+
+        const Measurement &expected = baselineEntry->second;
+        const double noise = toleranceSigmas * madToSigma * std::max(expected.mad, measurement.mad);
+        const double tolerance = std::max(noise, minRelativeTolerance * expected.median);
+        const double change = (measurement.median - expected.median) / expected.median * 100;
+        const bool regressed = measurement.median > expected.median + tolerance;
+        INFO("%-12s %.3f ns/instr, baseline %.3f ns/instr (%+.1f%%, tolerance %.1f%%)%s", name.c_str(), measurement.median,
+             expected.median, change, tolerance / expected.median * 100, regressed ? " REGRESSION" : "");
+        result &= !regressed;
+    }
+    return result;
+}
+
+void printHostProfiles(std::vector<std::unique_ptr<WorkloadRunner>> &runners) {
+    for (size_t index = 0; index < runners.size(); index++) {
+        HostProfiler profiler{true};
+        runners[index]->activateHostProfiler(&profiler);
+        runners[index]->run();
+        INFO("%s:", goldenValues[index].name);
+        profiler.printReport();
+    }
+}
+
+bool parseOptions(int argc, char **argv, Options &options) {
+    for (int argIndex = 1; argIndex < argc; argIndex++) {
+        const char *arg = argv[argIndex];
+        if (strcmp(arg, "-u") == 0) {
+            options.updateBaseline = true;
+        } else if (strcmp(arg, "-p") == 0) {
+            options.printHostProfile = true;
+        } else if (strcmp(arg, "-b") == 0 && argIndex + 1 < argc) {
+            options.baselinePath = argv[++argIndex];
+        } else if (strcmp(arg, "-r") == 0 && argIndex + 1 < argc) {
+            const char *value = argv[++argIndex];
+            char *valueEnd = nullptr;
+            const unsigned long runsCount = strtoul(value, &valueEnd, 10);
+            if (!isdigit(static_cast<unsigned char>(value[0])) || *valueEnd != '\0' || runsCount > 1000) {
+                return false;
+            }
+            options.runsCount = static_cast<u32>(runsCount);
+        } else {
+            return false;
+        }
+    }
+    return options.runsCount > 0;
+}
+
+int main(int argc, char **argv) {
+    Options options{};
+    if (!parseOptions(argc, argv, options)) {
+        INFO("Usage: emos_perf_tests [-b <baseline file>] [-r <runs count, 1 to 1000>] [-u] [-p]");
+        INFO("  -u  store measured throughput as the new baseline");
+        INFO("  -p  print host hardware counters of every workload per opcode instead of checking the baseline");
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<WorkloadRunner>> runners{};
+    for (const GoldenValues &golden : goldenValues) {
+        const Workload *workload = findWorkload(golden.name);
+        FATAL_ERROR_IF(workload == nullptr, "Unknown workload %s", golden.name);
+        runners.push_back(std::make_unique<WorkloadRunner>(*workload));
+    }
+
+    if (!checkGoldenValues(runners)) {
+        return 1;
+    }
+
+    if (options.printHostProfile) {
+        printHostProfiles(runners);
+        return 0;
+    }
+
+    const Baseline measured = measureThroughput(runners, options.runsCount);
+    if (options.updateBaseline) {
+        saveBaseline(options.baselinePath, measured);
+        INFO("Baseline saved to %s", options.baselinePath.c_str());
+        return 0;
+    }
+    const Baseline baseline = loadBaseline(options.baselinePath);
+    if (baseline.empty()) {
+        INFO("Baseline %s is missing or empty, create it with -u", options.baselinePath.c_str());
+        return 1;
+    }
+    return compareWithBaseline(measured, baseline) ? 0 : 1;
+}
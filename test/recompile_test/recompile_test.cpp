@@ -0,0 +1,131 @@
+#include "src/error.h"
+#include "src/recompiled_processor.h"
+#include "src/semihosting.h"
+
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern const RecompiledProgram fallbacksProgram;
+extern const RecompiledProgram sieveProgram;
+extern const RecompiledProgram crc32Program;
+extern const RecompiledProgram bubbleSortProgram;
+extern const RecompiledProgram quickSortProgram;
+extern const RecompiledProgram memcpyProgram;
+extern const RecompiledProgram bcdProgram;
+
+// Programs are executed both by the interpreter and by the recompiled code in chunks of varying sizes, so
+// blocks are also cut by the instruction budget. Complete state is compared after every chunk.
+struct RecompileTest : ::testing::Test {
+    void load(const std::string &path, const RecompiledProgram &program) {
+        std::ifstream file{path, std::ios::in | std::ios::binary};
+        ASSERT_TRUE(file) << path;
+        const std::vector<u8> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        ASSERT_FALSE(data.empty()) << path;
+
+        recompiledProcessor = std::make_unique<RecompiledProcessor>(program);
+        for (Processor *processor : {static_cast<Processor *>(&interpreter), static_cast<Processor *>(recompiledProcessor.get())}) {
+            processor->loadMemory(loadAddress, static_cast<u32>(data.size()), data.data());
+            processor->loadProgramCounter(loadAddress);
+        }
+    }
+
+    // Returns the stop reason of the last chunk
+    StopReason runAndCompare(u32 maxInstructionCount) {
+        constexpr u32 chunkSizes[] = {1, 2, 5, 100, 4096, 65536};
+        u32 chunkIndex = 0;
+        u32 instructionsCount = 0;
+        while (instructionsCount < maxInstructionCount) {
+            const u32 chunkSize = chunkSizes[chunkIndex++ % std::size(chunkSizes)];
+            const ExecutionResult expected = interpreter.executeInstructions(chunkSize);
+            const ExecutionResult actual = recompiledProcessor->executeRecompiled(chunkSize);
+            instructionsCount += expected.instructionsExecuted;
+
+            EXPECT_EQ(expected.stopReason, actual.stopReason);
+            EXPECT_EQ(expected.pc, actual.pc);
+            EXPECT_EQ(expected.instructionsExecuted, actual.instructionsExecuted);
+            EXPECT_EQ(expected.cyclesExecuted, actual.cyclesExecuted);
+            expectEqualState();
+            if (::testing::Test::HasFailure() || !expected) {
+                return expected.stopReason;
+            }
+        }
+        return StopReason::BudgetExhausted;
+    }
+
+    void expectEqualState() {
+        const Registers &expected = interpreter.getRegisters();
+        const Registers &actual = recompiledProcessor->getRegisters();
+        EXPECT_EQ(expected.a, actual.a);
+        EXPECT_EQ(expected.x, actual.x);
+        EXPECT_EQ(expected.y, actual.y);
+        EXPECT_EQ(expected.pc, actual.pc);
+        EXPECT_EQ(expected.sp, actual.sp);
+        EXPECT_EQ(expected.flags.toU8(), actual.flags.toU8());
+
+        EXPECT_EQ(interpreter.getCounters().instructionsProcessed, recompiledProcessor->getCounters().instructionsProcessed);
+        EXPECT_EQ(interpreter.getCounters().cyclesProcessed, recompiledProcessor->getCounters().cyclesProcessed);
+        EXPECT_EQ(interpreter.getCounters().bytesProcessed, recompiledProcessor->getCounters().bytesProcessed);
+        EXPECT_TRUE(interpreter.getMemory().isEqual(recompiledProcessor->getMemory()));
+    }
+
+    void runBenchmarkProgram(const char *fileName, const RecompiledProgram &program) {
+        load(std::string{BENCHMARK_PROGRAMS_DIRECTORY "/"} + fileName, program);
+
+        // All benchmark programs finish in less instructions and end in an infinite loop
+        constexpr u32 maxInstructionCount = 1'200'000;
+        ASSERT_EQ(StopReason::BudgetExhausted, runAndCompare(maxInstructionCount));
+        EXPECT_EQ(successAddress, recompiledProcessor->getRegisters().pc);
+        EXPECT_LT(recompiledProcessor->getInterpretedInstructionsCount(), maxInstructionCount / 100);
+    }
+
+    static constexpr u16 loadAddress = 0x0400;
+    static constexpr u16 successAddress = 0x0403;
+    Processor interpreter{};
+    std::unique_ptr<RecompiledProcessor> recompiledProcessor = {};
+};
+
+TEST_F(RecompileTest, givenProgramLeavingRecompiledCodeThenBehaveAsInterpreter) {
+    load(RECOMPILE_TEST_PROGRAMS_DIRECTORY "/fallbacks.bin", fallbacksProgram);
+    Semihosting expectedSemihosting{};
+    Semihosting actualSemihosting{};
+    interpreter.attachSemihosting(&expectedSemihosting);
+    recompiledProcessor->attachSemihosting(&actualSemihosting);
+
+    ASSERT_EQ(StopReason::GuestExit, runAndCompare(100'000));
+    EXPECT_EQ(expectedSemihosting.getOutput(), actualSemihosting.getOutput());
+    EXPECT_EQ(expectedSemihosting.getExitCode(), actualSemihosting.getExitCode());
+    EXPECT_NE(std::string::npos, actualSemihosting.getOutput().find("abc"));
+    EXPECT_NE(0u, recompiledProcessor->getInterpretedInstructionsCount());
+    EXPECT_LT(recompiledProcessor->getInterpretedInstructionsCount(), recompiledProcessor->getCounters().instructionsProcessed);
+
+    recompiledProcessor->attachSemihosting(nullptr);
+    interpreter.attachSemihosting(nullptr);
+}
+
+TEST_F(RecompileTest, givenSieveThenBehaveAsInterpreter) {
+    runBenchmarkProgram("sieve.bin", sieveProgram);
+}
+
+TEST_F(RecompileTest, givenCrc32ThenBehaveAsInterpreter) {
+    runBenchmarkProgram("crc32.bin", crc32Program);
+}
+
+TEST_F(RecompileTest, givenBubbleSortThenBehaveAsInterpreter) {
+    runBenchmarkProgram("bubble_sort.bin", bubbleSortProgram);
+}
+
+TEST_F(RecompileTest, givenQuickSortThenBehaveAsInterpreter) {
+    runBenchmarkProgram("quick_sort.bin", quickSortProgram);
+}
+
+TEST_F(RecompileTest, givenMemcpyThenBehaveAsInterpreter) {
+    runBenchmarkProgram("memcpy.bin", memcpyProgram);
+}
+
+TEST_F(RecompileTest, givenBcdThenBehaveAsInterpreter) {
+    runBenchmarkProgram("bcd.bin", bcdProgram);
+}
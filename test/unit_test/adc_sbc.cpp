@@ -555,6 +555,42 @@ TEST_P(SbcTest, givenTwoNegativeValuesAndCarrySetWhenExecutingSbcThenProperResul
     runAdcSbcTest(params);
 }
 
+TEST_P(SbcTest, givenNoBorrowingNibblesWhenExecutingDecimalSbcThenReturnValue) {
+    flags.expectDecimalFlag(true, true);
+    flags.expectCarryFlag(true, true);
+
+    ParamsAdcSbcTests params{};
+    params.opcode = GetParam();
+    params.regA = 0b0100'0111;     // 47
+    params.memValue = 0b0011'0010; // 32
+    params.result = 0b0001'0101;   // 15
+    runAdcSbcTest(params);
+}
+
+TEST_P(SbcTest, givenLowNibbleBorrowingWhenExecutingDecimalSbcThenReturnValue) {
+    flags.expectDecimalFlag(true, true);
+    flags.expectCarryFlag(true, true);
+
+    ParamsAdcSbcTests params{};
+    params.opcode = GetParam();
+    params.regA = 0b0100'0001;     // 41
+    params.memValue = 0b0011'0011; // 33
+    params.result = 0b0000'1000;   // 8
+    runAdcSbcTest(params);
+}
+
+TEST_P(SbcTest, givenHighNibbleBorrowingWhenExecutingDecimalSbcThenReturnValueAndClearCarryFlag) {
+    flags.expectDecimalFlag(true, true);
+    flags.expectCarryFlag(false, false);
+
+    ParamsAdcSbcTests params{};
+    params.opcode = GetParam();
+    params.regA = 0b0011'0011;     // 33
+    params.memValue = 0b0100'0001; // 41
+    params.result = 0b1001'0001;   // 33 - 41 - (1-0) = 91
+    runAdcSbcTest(params);
+}
+
 OpCode opcodesSbc[] = {OpCode::SBC_imm, OpCode::SBC_z, OpCode::SBC_zx, OpCode::SBC_abs, OpCode::SBC_absx, OpCode::SBC_absy, OpCode::SBC_ix, OpCode::SBC_iy};
 
 INSTANTIATE_TEST_SUITE_P(, SbcTest,
@@ -0,0 +1,87 @@
+#include "tools/batch/batch_job.h"
+#include "unit_test/fixtures/temporary_path.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+struct BatchJobTest : ::testing::Test {
+    void SetUp() override {
+        std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::string writeFile(const std::string &name, const std::string &content) {
+        const std::string path = (std::filesystem::path(directory) / name).string();
+        std::ofstream file{path, std::ios::out | std::ios::binary};
+        file.write(content.data(), content.size());
+        return path;
+    }
+
+    const std::string directory = createTemporaryPath("emos_batch_job_");
+    Processor processor{};
+};
+
+TEST_F(BatchJobTest, givenManifestWithArchiveEntriesWhenLoadingThenMapOnlyTheSelectedEntry) {
+    std::string archive(48, '\0');
+    for (u32 i = 0; i < archive.size(); i++) {
+        archive[i] = static_cast<char>(i);
+    }
+    writeFile("archive.bin", archive);
+    const std::string manifestPath = writeFile("jobs.txt", "# archive entries\n"
+                                                           "archive.bin@16:16 $0400 $0402 hang\n"
+                                                           "archive.bin@0:16 $0800 - count:5\n");
+
+    std::vector<Job> jobs = readManifest(manifestPath);
+    ASSERT_EQ(2u, jobs.size());
+    EXPECT_EQ(16u, jobs[0].offset);
+    EXPECT_EQ(16u, jobs[0].size);
+    EXPECT_EQ(0x0400, jobs[0].loadAddress);
+    EXPECT_EQ(0x0402, jobs[0].startPc);
+    EXPECT_EQ(StopCondition::Hang, jobs[0].stopCondition);
+    EXPECT_EQ(0u, jobs[1].offset);
+    EXPECT_TRUE(jobs[1].startPcFromFile);
+    EXPECT_EQ(StopCondition::InstructionCount, jobs[1].stopCondition);
+    EXPECT_EQ(5u, jobs[1].stopValue);
+
+    mapFiles(jobs);
+    ASSERT_NE(nullptr, jobs[0].file);
+    EXPECT_EQ(jobs[0].file, jobs[1].file);
+
+    ASSERT_TRUE(loadJobImage(processor, jobs[0]));
+    for (u16 i = 0; i < 16; i++) {
+        EXPECT_EQ(16 + i, processor.getMemory().read(0x0400 + i));
+    }
+    EXPECT_EQ(0, processor.getMemory().read(0x0410));
+    EXPECT_EQ(0x0402, processor.getRegisters().pc);
+}
+
+TEST_F(BatchJobTest, givenRawBinaryWithAs65ListingWhenLoadAddressIsFromFileThenLoadAtListedAddress) {
+    writeFile("program.bin", std::string{"\xA9\x01\xEA", 3});
+    writeFile("program.lst", "0600 : a9 01              start   lda #1\n"
+                             "0602 : ea                         nop\n");
+    const std::string manifestPath = writeFile("jobs.txt", "program.bin - $0600 hang\n");
+
+    std::vector<Job> jobs = readManifest(manifestPath);
+    ASSERT_EQ(1u, jobs.size());
+    EXPECT_TRUE(jobs[0].loadAddressFromFile);
+
+    mapFiles(jobs);
+    ASSERT_TRUE(loadJobImage(processor, jobs[0]));
+    EXPECT_EQ(0xA9, processor.getMemory().read(0x0600));
+    EXPECT_EQ(0xEA, processor.getMemory().read(0x0602));
+}
+
+TEST_F(BatchJobTest, givenArchiveEntryWithLoadAddressFromFileThenRejectManifest) {
+#ifdef EMOS_NO_EXCEPTIONS
+    GTEST_SKIP() << "Manifest errors terminate the process";
+#endif
+    writeFile("archive.bin", std::string(32, '\0'));
+    const std::string manifestPath = writeFile("jobs.txt", "archive.bin@16:16 - $0400 hang\n");
+
+    EXPECT_ANY_THROW(readManifest(manifestPath));
+}
@@ -0,0 +1,106 @@
+#include "unit_test/fixtures/emos_test.h"
+
+struct BreakpointsTest : EmosTest {};
+
+TEST_F(BreakpointsTest, givenBreakpointWhenExecutingInstructionsThenStopBeforeInstructionAtBreakpoint) {
+    std::fill_n(&processor.memory[startAddress], 10, static_cast<u8>(OpCode::INX));
+    processor.setBreakpoint(startAddress + 3);
+
+    const ExecutionResult result = processor.executeInstructions(10);
+    EXPECT_EQ(StopReason::Breakpoint, result.stopReason);
+    EXPECT_EQ(startAddress + 3, result.pc);
+    EXPECT_EQ(startAddress + 3, processor.regs.pc);
+    EXPECT_EQ(3u, result.instructionsExecuted);
+
+    expectedBytesProcessed = 3;
+    expectedCyclesProcessed = 6;
+}
+
+TEST_F(BreakpointsTest, givenBreakpointAtCurrentInstructionWhenExecutingInstructionsThenStopImmediately) {
+    processor.memory[startAddress] = static_cast<u8>(OpCode::INX);
+    processor.setBreakpoint(startAddress);
+
+    const ExecutionResult result = processor.executeInstructions(10);
+    EXPECT_EQ(StopReason::Breakpoint, result.stopReason);
+    EXPECT_EQ(0u, result.instructionsExecuted);
+    EXPECT_EQ(startAddress, processor.regs.pc);
+}
+
+TEST_F(BreakpointsTest, givenStoppedAtBreakpointWhenExecutingInstructionsAgainThenResumeExecution) {
+    std::fill_n(&processor.memory[startAddress], 10, static_cast<u8>(OpCode::INX));
+    processor.setBreakpoint(startAddress + 3);
+    EXPECT_FALSE(processor.executeInstructions(10));
+
+    const ExecutionResult result = processor.executeInstructions(2);
+    EXPECT_EQ(StopReason::BudgetExhausted, result.stopReason);
+    EXPECT_EQ(startAddress + 5, processor.regs.pc);
+
+    expectedBytesProcessed = 5;
+    expectedCyclesProcessed = 10;
+}
+
+TEST_F(BreakpointsTest, givenClearedBreakpointWhenExecutingInstructionsThenDoNotStop) {
+    std::fill_n(&processor.memory[startAddress], 10, static_cast<u8>(OpCode::INX));
+    processor.setBreakpoint(startAddress + 3);
+    processor.clearBreakpoint(startAddress + 3);
+
+    EXPECT_EQ(StopReason::BudgetExhausted, processor.executeInstructions(5).stopReason);
+
+    expectedBytesProcessed = 5;
+    expectedCyclesProcessed = 10;
+}
+
+TEST_F(BreakpointsTest, givenWriteWatchpointWhenInstructionWritesAddressThenStopAfterInstruction) {
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::STA_z);
+    processor.memory[startAddress + 1] = 0x10;
+    processor.memory[startAddress + 2] = static_cast<u8>(OpCode::INX);
+    processor.setWriteWatchpoint(0x10);
+
+    EXPECT_EQ(StopReason::WriteWatchpoint, processor.executeInstructions(2).stopReason);
+    EXPECT_EQ(0x10, processor.getWatchpointAddress());
+    EXPECT_EQ(startAddress + 2, processor.regs.pc);
+    EXPECT_EQ(processor.regs.a, processor.memory[0x10]);
+
+    expectedBytesProcessed = 2;
+    expectedCyclesProcessed = 3;
+}
+
+TEST_F(BreakpointsTest, givenReadWatchpointWhenInstructionReadsAddressThenStopAfterInstruction) {
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::STA_z);
+    processor.memory[startAddress + 1] = 0x10;
+    processor.memory[startAddress + 2] = static_cast<u8>(OpCode::LDX_z);
+    processor.memory[startAddress + 3] = 0x10;
+    processor.memory[startAddress + 4] = static_cast<u8>(OpCode::INX);
+    processor.setReadWatchpoint(0x10);
+
+    EXPECT_EQ(StopReason::ReadWatchpoint, processor.executeInstructions(10).stopReason);
+    EXPECT_EQ(0x10, processor.getWatchpointAddress());
+    EXPECT_EQ(startAddress + 4, processor.regs.pc);
+    EXPECT_EQ(processor.regs.a, processor.regs.x);
+
+    expectedBytesProcessed = 4;
+    expectedCyclesProcessed = 6;
+}
+
+TEST_F(BreakpointsTest, givenWatchpointOnInstructionBytesWhenExecutingInstructionsThenDoNotStopOnFetch) {
+    std::fill_n(&processor.memory[startAddress], 10, static_cast<u8>(OpCode::INX));
+    processor.setReadWatchpoint(startAddress + 1);
+
+    EXPECT_TRUE(processor.executeInstructions(5));
+
+    expectedBytesProcessed = 5;
+    expectedCyclesProcessed = 10;
+}
+
+TEST_F(BreakpointsTest, givenClearedWatchpointWhenInstructionWritesAddressThenDoNotStop) {
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::STA_z);
+    processor.memory[startAddress + 1] = 0x10;
+    processor.setWriteWatchpoint(0x10);
+    processor.setReadWatchpoint(0x10);
+    processor.clearWatchpoints(0x10);
+
+    EXPECT_TRUE(processor.executeInstructions(1));
+
+    expectedBytesProcessed = 2;
+    expectedCyclesProcessed = 3;
+}
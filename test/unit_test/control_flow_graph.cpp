@@ -0,0 +1,138 @@
+#include "src/control_flow_graph.h"
+#include "src/instructions.h"
+
+#include <gtest/gtest.h>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct ControlFlowGraphTest : ::testing::Test {
+    void SetUp() override {
+        const u8 program[] = {
+            static_cast<u8>(OpCode::LDX_imm), 0x03,       // 0400: LDX #3
+            static_cast<u8>(OpCode::JSR), 0x10, 0x04,     // 0402: JSR subroutine
+            static_cast<u8>(OpCode::DEX),                 // 0405: DEX
+            static_cast<u8>(OpCode::BNE), 0xFA,           // 0406: BNE $0402
+            static_cast<u8>(OpCode::JMP_abs), 0x08, 0x04, // 0408: JMP *
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF,                 // 040B: data, which is not code
+            static_cast<u8>(OpCode::LDA_z), 0x20,         // 0410: LDA $20
+            static_cast<u8>(OpCode::BEQ), 0x01,           // 0412: BEQ $0415
+            static_cast<u8>(OpCode::RTS),                 // 0414: RTS
+            static_cast<u8>(OpCode::RTS),                 // 0415: RTS
+        };
+        write(0x0400, program, sizeof(program));
+        write(0x0420, static_cast<u8>(OpCode::RTI));
+
+        write(0xFFFA, 0x20); // NMI
+        write(0xFFFB, 0x04);
+        write(0xFFFC, 0x00); // reset
+        write(0xFFFD, 0x04);
+        write(0xFFFE, 0x20); // IRQ
+        write(0xFFFF, 0x04);
+    }
+
+    void write(u16 address, const u8 *data, u32 size) {
+        for (u32 i = 0; i < size; i++) {
+            memory.write(static_cast<u16>(address + i), data[i]);
+        }
+    }
+
+    void write(u16 address, u8 value) {
+        memory.write(address, value);
+    }
+
+    void expectSuccessors(u16 blockStart, std::vector<std::pair<u16, ControlFlowGraph::EdgeKind>> expectedSuccessors) {
+        const u32 blockIndex = graph.findBlock(blockStart);
+        ASSERT_NE(ControlFlowGraph::invalidBlock, blockIndex);
+        const ControlFlowGraph::BasicBlock &block = graph.getBlocks()[blockIndex];
+        ASSERT_EQ(expectedSuccessors.size(), block.edgesCount) << "block " << blockStart;
+        for (u32 i = 0; i < block.edgesCount; i++) {
+            const ControlFlowGraph::Edge &edge = graph.getSuccessors(block)[i];
+            EXPECT_EQ(expectedSuccessors[i].first, graph.getBlocks()[edge.targetBlock].start) << "block " << blockStart;
+            EXPECT_EQ(expectedSuccessors[i].second, edge.kind) << "block " << blockStart;
+        }
+    }
+
+    Memory memory{};
+    ControlFlowGraph graph{};
+};
+
+TEST_F(ControlFlowGraphTest, givenProgramWithSubroutineThenBuildBlocksAndEdges) {
+    using EdgeKind = ControlFlowGraph::EdgeKind;
+    using Terminator = ControlFlowGraph::Terminator;
+
+    graph.addVectorEntryPoints(memory);
+    graph.build(memory);
+
+    const u16 expectedStarts[] = {0x0400, 0x0402, 0x0405, 0x0408, 0x0410, 0x0414, 0x0415, 0x0420};
+    ASSERT_EQ(std::size(expectedStarts), graph.getBlocks().size());
+    for (u32 i = 0; i < std::size(expectedStarts); i++) {
+        EXPECT_EQ(expectedStarts[i], graph.getBlocks()[i].start);
+    }
+
+    const ControlFlowGraph::BasicBlock &loopBlock = graph.getBlocks()[graph.findBlock(0x0405)];
+    EXPECT_EQ(0x0408u, loopBlock.end);
+    EXPECT_EQ(0x0406, loopBlock.lastInstruction);
+    EXPECT_EQ(2u, loopBlock.instructionsCount);
+    EXPECT_EQ(Terminator::Branch, loopBlock.terminator);
+    EXPECT_EQ(Terminator::ReturnFromInterrupt, graph.getBlocks()[graph.findBlock(0x0420)].terminator);
+    EXPECT_EQ(ControlFlowGraph::invalidBlock, graph.findBlock(0x040B));
+
+    expectSuccessors(0x0400, {{0x0402, EdgeKind::Fallthrough}});
+    expectSuccessors(0x0402, {{0x0410, EdgeKind::Call}, {0x0405, EdgeKind::Fallthrough}});
+    expectSuccessors(0x0405, {{0x0402, EdgeKind::Branch}, {0x0408, EdgeKind::Fallthrough}});
+    expectSuccessors(0x0408, {{0x0408, EdgeKind::Jump}});
+    expectSuccessors(0x0410, {{0x0415, EdgeKind::Branch}, {0x0414, EdgeKind::Fallthrough}});
+    expectSuccessors(0x0414, {{0x0405, EdgeKind::Return}});
+    expectSuccessors(0x0415, {{0x0405, EdgeKind::Return}});
+    expectSuccessors(0x0420, {});
+}
+
+TEST_F(ControlFlowGraphTest, givenIndirectJumpBrkAndInvalidOpCodeThenEndBlocks) {
+    using EdgeKind = ControlFlowGraph::EdgeKind;
+    using Terminator = ControlFlowGraph::Terminator;
+
+    write(0x0500, static_cast<u8>(OpCode::JMP_i));
+    write(0x0501, 0x34);
+    write(0x0502, 0x12);
+    write(0x0600, static_cast<u8>(OpCode::NOP));
+    write(0x0601, static_cast<u8>(OpCode::_INVALID));
+    write(0x0700, static_cast<u8>(OpCode::BRK));
+    graph.addEntryPoint(0x0500);
+    graph.addEntryPoint(0x0600);
+    graph.addEntryPoint(0x0700);
+    graph.build(memory);
+
+    ASSERT_EQ(4u, graph.getBlocks().size());
+    EXPECT_EQ(Terminator::IndirectJump, graph.getBlocks()[graph.findBlock(0x0500)].terminator);
+    const ControlFlowGraph::BasicBlock &invalidBlock = graph.getBlocks()[graph.findBlock(0x0600)];
+    EXPECT_EQ(Terminator::InvalidOpCode, invalidBlock.terminator);
+    EXPECT_EQ(1u, invalidBlock.instructionsCount);
+    EXPECT_EQ(0x0601u, invalidBlock.end);
+    EXPECT_EQ(Terminator::Interrupt, graph.getBlocks()[graph.findBlock(0x0700)].terminator);
+
+    expectSuccessors(0x0500, {});
+    expectSuccessors(0x0600, {});
+    expectSuccessors(0x0700, {{0x0420, EdgeKind::Interrupt}});
+}
+
+TEST_F(ControlFlowGraphTest, givenGraphThenExportDotAndJson) {
+    SymbolTable symbols{};
+    symbols.add("subroutine", 0x0410);
+    graph.addVectorEntryPoints(memory);
+    graph.build(memory);
+
+    std::string dot{};
+    graph.writeDot(memory, &symbols, dot);
+    EXPECT_EQ(0u, dot.find("digraph cfg {\n"));
+    EXPECT_NE(std::string::npos, dot.find("b0400 [label=\"[reset] \\l0400  LDX #$03\\l\"];\n"));
+    EXPECT_NE(std::string::npos, dot.find("b0410 [label=\"subroutine:\\l0410  LDA $20\\l0412  BEQ $0415\\l\"];\n"));
+    EXPECT_NE(std::string::npos, dot.find("b0402 -> b0410 [label=\"call\", style=dashed];\n"));
+    EXPECT_NE(std::string::npos, dot.find("b0414 -> b0405 [label=\"return\", style=dotted];\n"));
+
+    std::string json{};
+    graph.writeJson(&symbols, json);
+    EXPECT_NE(std::string::npos, json.find("{\"address\": 1024, \"kind\": \"reset\"}"));
+    EXPECT_NE(std::string::npos, json.find("{\"start\": 1040, \"end\": 1044, \"instructions\": 2, \"terminator\": \"branch\", \"label\": \"subroutine\", "
+                                           "\"successors\": [{\"start\": 1045, \"kind\": \"branch\"}, {\"start\": 1044, \"kind\": \"fallthrough\"}]}"));
+}
@@ -0,0 +1,145 @@
+#include "src/differential_checker.h"
+#include "unit_test/fixtures/emos_test.h"
+
+// Engine modifying its state after executing given instruction, to simulate a bug.
+struct BuggyExecutionEngine : ProcessorExecutionEngine {
+    BuggyExecutionEngine(WhiteboxProcessor &processor, u32 buggyInstructionIndex, bool corruptMemory)
+        : ProcessorExecutionEngine(processor), processor(processor), buggyInstructionIndex(buggyInstructionIndex), corruptMemory(corruptMemory) {}
+
+    bool executeInstructions(u32 instructionCount) override {
+        for (u32 i = 0; i < instructionCount; i++) {
+            if (!ProcessorExecutionEngine::executeInstructions(1)) {
+                return false;
+            }
+            if (processor.counters.instructionsProcessed == buggyInstructionIndex + 1) {
+                if (corruptMemory) {
+                    processor.memory.write(0x0020, 0xFF);
+                } else {
+                    processor.regs.x++;
+                }
+            }
+        }
+        return true;
+    }
+
+    WhiteboxProcessor &processor;
+    const u32 buggyInstructionIndex;
+    const bool corruptMemory;
+};
+
+struct DifferentialCheckerTest : ::testing::Test {
+    void SetUp() override {
+        const u8 program[] = {
+            static_cast<u8>(OpCode::LDX_imm), 0x00,
+            static_cast<u8>(OpCode::INX),                 // loop:
+            static_cast<u8>(OpCode::STX_z), 0x10,
+            static_cast<u8>(OpCode::JMP_abs), 0x02, 0x80, // jmp loop
+        };
+        programImage = std::make_unique<MemoryImage>(0x8000, static_cast<u32>(sizeof(program)), program);
+        setUpProcessor(referenceProcessor);
+        setUpProcessor(testedProcessor);
+    }
+
+    void setUpProcessor(WhiteboxProcessor &processor) {
+        processor.mapMemoryImage(*programImage);
+        processor.loadProgramCounter(0x8000);
+    }
+
+    std::unique_ptr<MemoryImage> programImage{};
+    WhiteboxProcessor referenceProcessor{};
+    WhiteboxProcessor testedProcessor{};
+};
+
+TEST_F(DifferentialCheckerTest, givenTheSameEnginesWhenExecutingThenStatesMatch) {
+    ProcessorExecutionEngine reference{referenceProcessor};
+    ProcessorExecutionEngine tested{testedProcessor};
+    DifferentialChecker checker{reference, tested, 7};
+
+    EXPECT_EQ(DifferentialChecker::Result::Match, checker.executeInstructions(100));
+    EXPECT_EQ(100u, referenceProcessor.counters.instructionsProcessed);
+    EXPECT_EQ(100u, testedProcessor.counters.instructionsProcessed);
+    EXPECT_EQ(33u, testedProcessor.regs.x);
+}
+
+TEST_F(DifferentialCheckerTest, givenProcessorAndLockstepEngineWhenExecutingThenStatesMatch) {
+    LockstepEngine lockstepEngine{1};
+    ProcessorState initialState = testedProcessor.saveState();
+    lockstepEngine.restoreState(0, initialState);
+
+    ProcessorExecutionEngine reference{referenceProcessor};
+    LockstepExecutionEngine tested{lockstepEngine, 0};
+    DifferentialChecker checker{reference, tested, 10};
+
+    EXPECT_EQ(DifferentialChecker::Result::Match, checker.executeInstructions(100));
+    EXPECT_EQ(100u, lockstepEngine.getCounters(0).instructionsProcessed);
+    EXPECT_EQ(100u, lockstepEngine.getStatistics().lockstepSteps);
+}
+
+TEST_F(DifferentialCheckerTest, givenDivergingEngineWhenExecutingInBatchesThenReportFirstDivergentInstruction) {
+    for (u32 batchSize : {1u, 10u, 1000u}) {
+        setUpProcessor(referenceProcessor);
+        setUpProcessor(testedProcessor);
+        referenceProcessor.counters = {};
+        testedProcessor.counters = {};
+
+        ProcessorExecutionEngine reference{referenceProcessor};
+        BuggyExecutionEngine tested{testedProcessor, 23, false};
+        DifferentialChecker checker{reference, tested, batchSize};
+
+        EXPECT_EQ(DifferentialChecker::Result::Divergence, checker.executeInstructions(100));
+        const DifferentialChecker::Divergence &divergence = checker.getDivergence();
+        EXPECT_EQ(23u, divergence.instructionIndex);
+        EXPECT_EQ(0x8003, divergence.pc);
+        EXPECT_EQ(static_cast<u8>(OpCode::STX_z), divergence.opCode);
+        EXPECT_EQ("x: 0x08 != 0x09\n", divergence.description);
+        EXPECT_EQ(24u, referenceProcessor.counters.instructionsProcessed);
+
+        EXPECT_EQ(DifferentialChecker::Result::Divergence, checker.executeInstructions(100));
+        EXPECT_EQ(24u, referenceProcessor.counters.instructionsProcessed);
+    }
+}
+
+TEST_F(DifferentialCheckerTest, givenDivergentMemoryWhenExecutingThenReportDifferentAddresses) {
+    ProcessorExecutionEngine reference{referenceProcessor};
+    BuggyExecutionEngine tested{testedProcessor, 5, true};
+    DifferentialChecker checker{reference, tested, 50};
+
+    EXPECT_EQ(DifferentialChecker::Result::Divergence, checker.executeInstructions(100));
+    EXPECT_EQ(5u, checker.getDivergence().instructionIndex);
+    EXPECT_EQ("[0x0020]: 0x00 != 0xff\n", checker.getDivergence().description);
+}
+
+TEST_F(DifferentialCheckerTest, givenBothEnginesRaisingErrorWhenExecutingThenReportFault) {
+    const u8 program[] = {static_cast<u8>(OpCode::INX), 0x02};
+    const MemoryImage image{0x9000, sizeof(program), program};
+    referenceProcessor.mapMemoryImage(image);
+    testedProcessor.mapMemoryImage(image);
+    referenceProcessor.loadProgramCounter(0x9000);
+    testedProcessor.loadProgramCounter(0x9000);
+
+    ProcessorExecutionEngine reference{referenceProcessor};
+    ProcessorExecutionEngine tested{testedProcessor};
+    DifferentialChecker checker{reference, tested, 50};
+
+    EXPECT_EQ(DifferentialChecker::Result::Fault, checker.executeInstructions(100));
+    EXPECT_EQ(1u, checker.getDivergence().instructionIndex);
+    EXPECT_EQ(0x9001, checker.getDivergence().pc);
+    EXPECT_EQ(0x02, checker.getDivergence().opCode);
+}
+
+TEST_F(DifferentialCheckerTest, givenSavedProcessorStateWhenRestoringThenStateIsRestoredAndCanBeRestoredAgain) {
+    referenceProcessor.executeInstructions(5);
+    ProcessorState state = referenceProcessor.saveState();
+
+    for (u32 i = 0; i < 2; i++) {
+        referenceProcessor.executeInstructions(10);
+        EXPECT_FALSE(referenceProcessor.memory.isEqual(state.memory));
+
+        referenceProcessor.restoreState(state);
+        EXPECT_EQ(0x8003, referenceProcessor.regs.pc);
+        EXPECT_EQ(0x02, referenceProcessor.regs.x);
+        EXPECT_EQ(5u, referenceProcessor.counters.instructionsProcessed);
+        EXPECT_EQ(0x01, referenceProcessor.memory.read(0x0010));
+        EXPECT_TRUE(referenceProcessor.memory.isEqual(state.memory));
+    }
+}
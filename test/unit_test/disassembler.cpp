@@ -0,0 +1,86 @@
+#include "src/disassembler.h"
+#include "src/instructions.h"
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+std::string disassemble(Disassembler &disassembler, u16 address, std::initializer_list<u8> bytes) {
+    u8 instruction[Disassembler::maxInstructionSize] = {};
+    std::copy(bytes.begin(), bytes.end(), instruction);
+    u32 size = 0;
+    const std::string result{disassembler.disassembleInstruction(address, instruction, &size)};
+    EXPECT_EQ(bytes.size(), size);
+    return result;
+}
+} // namespace
+
+TEST(DisassemblerTest, givenInstructionsInAllAddressingModesThenRenderOperandSyntax) {
+    Disassembler disassembler{};
+    EXPECT_EQ("ASL A", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::ASL_acc)}));
+    EXPECT_EQ("NOP", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::NOP)}));
+    EXPECT_EQ("LDA #$42", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::LDA_imm), 0x42}));
+    EXPECT_EQ("LDA $42", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::LDA_z), 0x42}));
+    EXPECT_EQ("STX $42,Y", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::STX_zy), 0x42}));
+    EXPECT_EQ("LDA $1234", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::LDA_abs), 0x34, 0x12}));
+    EXPECT_EQ("LDA $1234,X", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::LDA_absx), 0x34, 0x12}));
+    EXPECT_EQ("LDA ($42,X)", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::LDA_ix), 0x42}));
+    EXPECT_EQ("LDA ($42),Y", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::LDA_iy), 0x42}));
+    EXPECT_EQ("JMP ($fffc)", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::JMP_i), 0xFC, 0xFF}));
+    EXPECT_EQ("BNE $0412", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::BNE), 0x10}));
+    EXPECT_EQ("BNE $03f2", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::BNE), 0xF0}));
+    EXPECT_EQ(".byte $02", disassemble(disassembler, 0x0400, {0x02}));
+}
+
+TEST(DisassemblerTest, givenSymbolsThenRenderLabelsAtExactOperandAddresses) {
+    SymbolTable symbols{};
+    symbols.add("start", 0x0400);
+    symbols.add("counter", 0x0042);
+    Disassembler disassembler{&symbols};
+
+    EXPECT_EQ("JSR start", disassemble(disassembler, 0x0410, {static_cast<u8>(OpCode::JSR), 0x00, 0x04}));
+    EXPECT_EQ("BNE start", disassemble(disassembler, 0x03F0, {static_cast<u8>(OpCode::BNE), 0x0E}));
+    EXPECT_EQ("LDA (counter),Y", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::LDA_iy), 0x42}));
+    EXPECT_EQ("LDA $43", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::LDA_z), 0x43}));
+    EXPECT_EQ("LDA #$42", disassemble(disassembler, 0x0400, {static_cast<u8>(OpCode::LDA_imm), 0x42}));
+}
+
+TEST(DisassemblerTest, givenMemoryRangeThenRenderLinesWithAddressesBytesAndLabels) {
+    Memory memory{};
+    const u8 program[] = {
+        static_cast<u8>(OpCode::LDA_imm), 0x42,       // LDA #$42
+        static_cast<u8>(OpCode::DEX),                 // DEX
+        static_cast<u8>(OpCode::BNE), 0xFD,           // BNE loop
+        static_cast<u8>(OpCode::JMP_abs), 0x00, 0x04, // JMP start
+    };
+    for (u32 i = 0; i < sizeof(program); i++) {
+        memory.write(static_cast<u16>(0x0400 + i), program[i]);
+    }
+    SymbolTable symbols{};
+    symbols.add("start", 0x0400);
+    symbols.add("loop", 0x0402);
+    Disassembler disassembler{&symbols};
+
+    const std::string expected = "start:\n"
+                                 "0400  a9 42     LDA #$42\n"
+                                 "loop:\n"
+                                 "0402  ca        DEX\n"
+                                 "0403  d0 fd     BNE loop\n"
+                                 "0405  4c 00 04  JMP start\n";
+    EXPECT_EQ(expected, disassembler.disassembleRange(memory, 0x0400, sizeof(program)));
+
+    // Last instruction can end past the range and the whole memory can be disassembled
+    EXPECT_EQ("0405  4c 00 04  JMP start\n", disassembler.disassembleRange(memory, 0x0405, 1));
+    const std::string_view wholeMemory = disassembler.disassembleRange(memory, 0x0000, memorySize);
+    EXPECT_EQ(memorySize - sizeof(program) + 4 + 2, static_cast<u32>(std::count(wholeMemory.begin(), wholeMemory.end(), '\n')));
+}
+
+TEST(DisassemblerTest, givenAnyOpCodeThenInstructionSizeMatchesAddressingMode) {
+    EXPECT_EQ(1u, Disassembler::getInstructionSize(static_cast<u8>(OpCode::NOP)));
+    EXPECT_EQ(1u, Disassembler::getInstructionSize(static_cast<u8>(OpCode::ASL_acc)));
+    EXPECT_EQ(2u, Disassembler::getInstructionSize(static_cast<u8>(OpCode::LDA_iy)));
+    EXPECT_EQ(2u, Disassembler::getInstructionSize(static_cast<u8>(OpCode::BNE)));
+    EXPECT_EQ(3u, Disassembler::getInstructionSize(static_cast<u8>(OpCode::JMP_i)));
+    EXPECT_EQ(1u, Disassembler::getInstructionSize(static_cast<u8>(OpCode::_INVALID)));
+}
@@ -0,0 +1,93 @@
+#include "src/bit_operations.h"
+#include "unit_test/fixtures/emos_test.h"
+
+struct ExecutionResultTest : EmosTest {};
+
+TEST_F(ExecutionResultTest, givenExecutedInstructionsWhenBudgetIsExhaustedThenReturnExecutedInstructionsAndCycles) {
+    std::fill_n(&processor.memory[startAddress], 10, static_cast<u8>(OpCode::INX));
+    processor.executeInstructions(2);
+
+    const ExecutionResult result = processor.executeInstructions(3);
+    EXPECT_TRUE(result);
+    EXPECT_EQ(StopReason::BudgetExhausted, result.stopReason);
+    EXPECT_EQ(startAddress + 5, result.pc);
+    EXPECT_EQ(3u, result.instructionsExecuted);
+    EXPECT_EQ(6u, result.cyclesExecuted);
+
+    expectedBytesProcessed = 5;
+    expectedCyclesProcessed = 10;
+}
+
+TEST_F(ExecutionResultTest, givenExecutedCyclesWhenBudgetIsExhaustedThenReturnWholeInstructions) {
+    std::fill_n(&processor.memory[startAddress], 10, static_cast<u8>(OpCode::INX));
+
+    const ExecutionResult result = processor.executeCycles(5);
+    EXPECT_TRUE(result);
+    EXPECT_EQ(3u, result.instructionsExecuted);
+    EXPECT_EQ(6u, result.cyclesExecuted);
+
+    expectedBytesProcessed = 3;
+    expectedCyclesProcessed = 6;
+}
+
+TEST_F(ExecutionResultTest, givenInvalidOpcodeWhenExecutingInstructionsThenStopAtInvalidOpcode) {
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::INX);
+    processor.memory[startAddress + 1] = 0x02;
+
+    const ExecutionResult result = processor.executeInstructions(10);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(StopReason::InvalidOpcode, result.stopReason);
+    EXPECT_EQ(startAddress + 1, result.pc);
+    EXPECT_EQ(startAddress + 1, processor.regs.pc);
+    EXPECT_EQ(1u, result.instructionsExecuted);
+    EXPECT_EQ(2u, result.cyclesExecuted);
+
+    expectedBytesProcessed = 1;
+    expectedCyclesProcessed = 2;
+}
+
+TEST_F(ExecutionResultTest, givenHangWhenExecutingInstructionsThenReturnAddressOfHungInstruction) {
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::JMP_abs);
+    processor.memory[startAddress + 1] = lo(startAddress);
+    processor.memory[startAddress + 2] = hi(startAddress);
+    processor.activateHangDetector();
+
+    const ExecutionResult result = processor.executeInstructions(50);
+    EXPECT_EQ(StopReason::Hang, result.stopReason);
+    EXPECT_EQ(startAddress, result.pc);
+
+    processor.counters.bytesProcessed = 0;
+    processor.counters.cyclesProcessed = 0;
+}
+
+TEST_F(ExecutionResultTest, givenInvalidBcdWhenExecutingInstructionsThenStopWithStickyGuestError) {
+    flags.expectDecimalFlag(true, true);
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::ADC_imm);
+    processor.memory[startAddress + 1] = 0x0A;
+    processor.memory[startAddress + 2] = static_cast<u8>(OpCode::INX);
+    processor.regs.a = 0x01;
+    const u8 initialX = processor.regs.x;
+
+    const ExecutionResult result = processor.executeInstructions(10);
+    EXPECT_EQ(StopReason::GuestError, result.stopReason);
+    EXPECT_STREQ("Invalid BCD", processor.getGuestError());
+    EXPECT_EQ(0u, result.instructionsExecuted);
+    EXPECT_EQ(0x01, processor.regs.a);
+
+    EXPECT_EQ(StopReason::GuestError, processor.executeInstructions(10).stopReason);
+    EXPECT_EQ(initialX, processor.regs.x);
+
+    processor.counters.bytesProcessed = 0;
+    processor.counters.cyclesProcessed = 0;
+}
+
+TEST_F(ExecutionResultTest, givenGuestErrorWhenRestoringStateThenErrorIsCleared) {
+    flags.expectDecimalFlag(true, true);
+    ProcessorState state = processor.saveState();
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::SBC_imm);
+    processor.memory[startAddress + 1] = 0xA0;
+    EXPECT_EQ(StopReason::GuestError, processor.executeInstructions(10).stopReason);
+
+    processor.restoreState(state);
+    EXPECT_EQ(nullptr, processor.getGuestError());
+}
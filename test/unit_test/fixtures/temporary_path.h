@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+
+// Returns a path in the temporary directory, which is not used by any other test, including tests running
+// in parallel in other processes. Nothing is created, so the caller decides between a file and a directory.
+inline std::string createTemporaryPath(const std::string &prefix) {
+    static std::mt19937_64 random{std::random_device{}()};
+    while (true) {
+        char suffix[17];
+        snprintf(suffix, sizeof(suffix), "%016llx", static_cast<unsigned long long>(random()));
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / (prefix + suffix);
+        if (!std::filesystem::exists(path)) {
+            return path.string();
+        }
+    }
+}
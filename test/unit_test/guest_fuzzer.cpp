@@ -0,0 +1,113 @@
+#include "src/guest_fuzzer.h"
+#include "unit_test/fixtures/emos_test.h"
+
+#include <numeric>
+#include <vector>
+
+u32 sumCoverageMap(const u8 *coverageMap) {
+    return std::accumulate(coverageMap, coverageMap + EdgeCoverage::mapSize, 0u);
+}
+
+TEST(EdgeCoverageTest, givenEdgeCoverageActiveWhenExecutingControlFlowInstructionsThenUpdateCoverageMap) {
+    const u8 program[] = {
+        static_cast<u8>(OpCode::LDX_imm), 0x03,
+        static_cast<u8>(OpCode::DEX),                 // loop:
+        static_cast<u8>(OpCode::BNE), 0xFD,           // bne loop
+        static_cast<u8>(OpCode::JSR), 0x0B, 0x80,     // jsr subroutine
+        static_cast<u8>(OpCode::JMP_abs), 0x08, 0x80, // jmp *
+        static_cast<u8>(OpCode::RTS),                 // subroutine:
+    };
+    const MemoryImage image{0x8000, sizeof(program), program};
+    std::vector<u8> coverageMap(EdgeCoverage::mapSize);
+
+    WhiteboxProcessor processor{};
+    processor.mapMemoryImage(image);
+    processor.loadProgramCounter(0x8000);
+    processor.regs.sp = 0xFF;
+    processor.activateEdgeCoverage(coverageMap.data());
+    processor.executeInstructions(1 + 3 * 2 + 2 + 3);
+
+    // 3 branches, JSR, RTS and 3 jumps
+    EXPECT_EQ(8u, sumCoverageMap(coverageMap.data()));
+    const u8 maxHitCount = *std::max_element(coverageMap.begin(), coverageMap.end());
+    EXPECT_EQ(3u, maxHitCount); // every jmp * goes from its own address to itself
+}
+
+struct GuestFuzzerTest : ::testing::Test {
+    void SetUp() override {
+        // Program counts executions at $10, so we can check the memory is restored between inputs.
+        const u8 program[] = {
+            static_cast<u8>(OpCode::INC_z), 0x10,
+            static_cast<u8>(OpCode::LDA_z), 0x10,
+            static_cast<u8>(OpCode::CMP_imm), 0x01,
+            static_cast<u8>(OpCode::BNE), 0x10,           // bne error
+            static_cast<u8>(OpCode::LDA_z), 0xFE,         // input size
+            static_cast<u8>(OpCode::CMP_imm), 0x03,
+            static_cast<u8>(OpCode::BEQ), 0x0A,           // beq error
+            static_cast<u8>(OpCode::LDA_abs), 0x00, 0x02, // first byte of input
+            static_cast<u8>(OpCode::CMP_imm), 0x42,
+            static_cast<u8>(OpCode::BEQ), 0x06,           // beq crash
+            static_cast<u8>(OpCode::JMP_abs), 0x15, 0x80, // success: jmp success
+            static_cast<u8>(OpCode::JMP_abs), 0x18, 0x80, // error: jmp error
+            0x02,                                         // crash: unsupported instruction
+        };
+        programImage = std::make_unique<MemoryImage>(0x8000, static_cast<u32>(sizeof(program)), program);
+        processor.mapMemoryImage(*programImage);
+        processor.loadProgramCounter(0x8000);
+
+        configuration.inputAddress = 0x0200;
+        configuration.inputSizeAddress = 0x00FE;
+        configuration.maxInputSize = 16;
+        configuration.successAddress = 0x8015;
+        configuration.instructionBudget = 1000;
+    }
+
+    std::unique_ptr<MemoryImage> programImage{};
+    WhiteboxProcessor processor{};
+    GuestFuzzer::Configuration configuration{};
+};
+
+TEST_F(GuestFuzzerTest, givenInputsWhenRunningThenEachInputStartsFromInitialState) {
+    GuestFuzzer fuzzer{processor, configuration};
+    const u8 input[] = {0x01, 0x02};
+    for (u32 i = 0; i < 3; i++) {
+        EXPECT_EQ(GuestFuzzer::Result::Success, fuzzer.run(input, sizeof(input)));
+        EXPECT_EQ(0x8015, fuzzer.getStopAddress());
+        EXPECT_EQ(0x01, processor.memory.read(0x0010));
+    }
+}
+
+TEST_F(GuestFuzzerTest, givenInputTriggeringBugWhenRunningThenReportCrashOrHang) {
+    GuestFuzzer fuzzer{processor, configuration};
+
+    const u8 crashingInput[] = {0x42};
+    EXPECT_EQ(GuestFuzzer::Result::Crash, fuzzer.run(crashingInput, sizeof(crashingInput)));
+
+    const u8 hangingInput[] = {0x00, 0x00, 0x00};
+    EXPECT_EQ(GuestFuzzer::Result::Hang, fuzzer.run(hangingInput, sizeof(hangingInput)));
+    EXPECT_EQ(0x8018, fuzzer.getStopAddress());
+
+    EXPECT_EQ(GuestFuzzer::Result::Success, fuzzer.run(nullptr, 0));
+}
+
+TEST_F(GuestFuzzerTest, givenTooSmallInstructionBudgetWhenRunningThenReportTimeout) {
+    configuration.instructionBudget = 5;
+    GuestFuzzer fuzzer{processor, configuration};
+    const u8 input[] = {0x01};
+    EXPECT_EQ(GuestFuzzer::Result::Timeout, fuzzer.run(input, sizeof(input)));
+}
+
+TEST_F(GuestFuzzerTest, givenInputsTakingDifferentPathsWhenRunningThenCoverageIsDifferent) {
+    GuestFuzzer fuzzer{processor, configuration};
+    const u8 successInput[] = {0x01};
+    const u8 crashingInput[] = {0x42};
+
+    fuzzer.run(successInput, sizeof(successInput));
+    const std::vector<u8> successCoverage(fuzzer.getCoverageMap(), fuzzer.getCoverageMap() + EdgeCoverage::mapSize);
+    fuzzer.clearCoverageMap();
+    EXPECT_EQ(0u, sumCoverageMap(fuzzer.getCoverageMap()));
+
+    fuzzer.run(crashingInput, sizeof(crashingInput));
+    const std::vector<u8> crashCoverage(fuzzer.getCoverageMap(), fuzzer.getCoverageMap() + EdgeCoverage::mapSize);
+    EXPECT_NE(successCoverage, crashCoverage);
+}
@@ -0,0 +1,122 @@
+#include "src/bit_operations.h"
+#include "src/guest_scheduler.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+struct GuestSchedulerTest : ::testing::Test {
+    void SetUp() override {
+        for (auto &processor : processors) {
+            processor.loadMemory(startAddress, sizeof(incrementLoop), incrementLoop);
+            processor.loadProgramCounter(startAddress);
+        }
+    }
+
+    // Waits for the scheduler to reach a state, which is checked on its counters. Time limit only keeps a
+    // broken scheduler from hanging the test, results never depend on timing.
+    template <typename Predicate>
+    static void waitUntil(Predicate predicate) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (!predicate()) {
+            ASSERT_LT(std::chrono::steady_clock::now(), deadline) << "Scheduler did not reach expected state";
+            std::this_thread::yield();
+        }
+    }
+
+    constexpr static u16 startAddress = 0x0400;
+    constexpr static u8 incrementLoop[] = {
+        static_cast<u8>(OpCode::INX),
+        static_cast<u8>(OpCode::JMP_abs),
+        lo(startAddress),
+        hi(startAddress),
+    };
+    Processor processors[20] = {};
+};
+
+TEST_F(GuestSchedulerTest, givenManyGuestsWhenSchedulerIsRunningThenAllGuestsMakeProgress) {
+    GuestScheduler scheduler{2, 100};
+    for (auto &processor : processors) {
+        scheduler.addGuest(processor);
+    }
+
+    scheduler.start();
+    waitUntil([&]() {
+        for (GuestScheduler::GuestId guestId = 0; guestId < scheduler.getGuestsCount(); guestId++) {
+            if (scheduler.getStatistics(guestId).quantaExecuted < 3) {
+                return false;
+            }
+        }
+        return true;
+    });
+    scheduler.stop();
+
+    for (GuestScheduler::GuestId guestId = 0; guestId < scheduler.getGuestsCount(); guestId++) {
+        const GuestScheduler::GuestStatistics statistics = scheduler.getStatistics(guestId);
+        EXPECT_LE(300u, statistics.cyclesExecuted);
+        EXPECT_LE(3u, statistics.quantaExecuted);
+        EXPECT_FALSE(statistics.finished);
+        EXPECT_EQ(statistics.cyclesExecuted, processors[guestId].getCounters().cyclesProcessed);
+    }
+}
+
+TEST_F(GuestSchedulerTest, givenStoppedSchedulerWhenStartingAgainThenGuestsContinue) {
+    GuestScheduler scheduler{2, 100};
+    scheduler.addGuest(processors[0]);
+
+    scheduler.start();
+    waitUntil([&]() { return scheduler.getStatistics(0).quantaExecuted >= 1; });
+    scheduler.stop();
+
+    // No quantum is running after stop, so statistics and the processor agree
+    const u64 cyclesAfterFirstRun = scheduler.getStatistics(0).cyclesExecuted;
+    EXPECT_EQ(cyclesAfterFirstRun, processors[0].getCounters().cyclesProcessed);
+
+    scheduler.start();
+    waitUntil([&]() { return scheduler.getStatistics(0).cyclesExecuted > cyclesAfterFirstRun; });
+    scheduler.stop();
+    EXPECT_EQ(scheduler.getStatistics(0).cyclesExecuted, processors[0].getCounters().cyclesProcessed);
+}
+
+TEST_F(GuestSchedulerTest, givenHungGuestWhenSchedulerIsRunningThenFinishOnlyThisGuest) {
+    const u8 hangLoop[] = {static_cast<u8>(OpCode::JMP_abs), lo(startAddress), hi(startAddress)};
+    processors[1].loadMemory(startAddress, sizeof(hangLoop), hangLoop);
+    processors[1].activateHangDetector();
+
+    GuestScheduler scheduler{2, 100};
+    scheduler.addGuest(processors[0]);
+    scheduler.addGuest(processors[1]);
+
+    scheduler.start();
+    waitUntil([&]() { return scheduler.getStatistics(1).finished && scheduler.getStatistics(0).quantaExecuted >= 1; });
+    scheduler.stop();
+
+    EXPECT_FALSE(scheduler.getStatistics(0).finished);
+    EXPECT_TRUE(scheduler.getStatistics(1).finished);
+    EXPECT_EQ(startAddress, processors[1].getHangAddress());
+}
+
+TEST_F(GuestSchedulerTest, givenThrottledGuestWhenSchedulerIsRunningThenDoNotExceedEmulatedFrequency) {
+    constexpr u32 cyclesPerSecond = 100'000;
+    constexpr u32 cycleQuantum = 100;
+
+    GuestScheduler scheduler{2, cycleQuantum};
+    scheduler.addGuest(processors[0]);
+    scheduler.addGuest(processors[1]);
+    scheduler.setThrottle(0, cyclesPerSecond);
+
+    // Elapsed time only bounds the throttled guest from above, so a slow machine can't fail the test
+    const auto startTime = std::chrono::steady_clock::now();
+    scheduler.start();
+    waitUntil([&]() { return scheduler.getStatistics(0).timesThrottled >= 2 && scheduler.getStatistics(1).quantaExecuted >= 1; });
+    scheduler.stop();
+    const auto endTime = std::chrono::steady_clock::now();
+
+    const u64 elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+    const u64 maxCycles = cyclesPerSecond * elapsedUs / 1'000'000 + 2 * cycleQuantum;
+    const GuestScheduler::GuestStatistics throttledStatistics = scheduler.getStatistics(0);
+    EXPECT_LT(0u, throttledStatistics.cyclesExecuted);
+    EXPECT_GE(maxCycles, throttledStatistics.cyclesExecuted);
+    EXPECT_LT(0u, throttledStatistics.timesThrottled);
+    EXPECT_EQ(0u, scheduler.getStatistics(1).timesThrottled);
+}
@@ -0,0 +1,62 @@
+#include "src/host_profiler.h"
+#include "unit_test/fixtures/emos_test.h"
+
+struct HostProfilerTest : EmosTest {
+    void writeProgram() {
+        // INX, INX, INY
+        processor.memory[startAddress + 0] = static_cast<u8>(OpCode::INX);
+        processor.memory[startAddress + 1] = static_cast<u8>(OpCode::INX);
+        processor.memory[startAddress + 2] = static_cast<u8>(OpCode::INY);
+        expectedBytesProcessed = 3;
+        expectedCyclesProcessed = 6;
+    }
+};
+
+TEST_F(HostProfilerTest, givenHostProfilerWhenExecutingInstructionsThenCountEmulatedInstructions) {
+    writeProgram();
+    HostProfiler profiler{false};
+    processor.activateHostProfiler(&profiler);
+
+    processor.executeInstructions(2);
+    processor.executeInstructions(1);
+    EXPECT_EQ(3u, profiler.getEmulatedInstructions());
+    EXPECT_EQ(0u, profiler.getOpCodeInstructions(static_cast<u8>(OpCode::INX)));
+}
+
+TEST_F(HostProfilerTest, givenPerOpCodeHostProfilerWhenExecutingInstructionsThenCountEmulatedInstructionsPerOpCode) {
+    writeProgram();
+    HostProfiler profiler{true};
+    processor.activateHostProfiler(&profiler);
+
+    processor.executeInstructions(3);
+    EXPECT_EQ(3u, profiler.getEmulatedInstructions());
+    EXPECT_EQ(2u, profiler.getOpCodeInstructions(static_cast<u8>(OpCode::INX)));
+    EXPECT_EQ(1u, profiler.getOpCodeInstructions(static_cast<u8>(OpCode::INY)));
+
+    profiler.reset();
+    EXPECT_EQ(0u, profiler.getEmulatedInstructions());
+    EXPECT_EQ(0u, profiler.getOpCodeInstructions(static_cast<u8>(OpCode::INX)));
+}
+
+TEST_F(HostProfilerTest, givenAvailableHostCountersWhenExecutingInstructionsThenCountHostInstructions) {
+    HostProfiler profiler{true};
+    if (!profiler.isAvailable()) {
+        GTEST_SKIP() << "Host hardware counters are not available";
+    }
+    writeProgram();
+    processor.activateHostProfiler(&profiler);
+
+    processor.executeInstructions(3);
+    EXPECT_LT(0u, profiler.getTotal()[HostEvent::Instructions]);
+    EXPECT_LT(0u, profiler.getOpCodeValues(static_cast<u8>(OpCode::INX))[HostEvent::Instructions]);
+}
+
+TEST_F(HostProfilerTest, givenHostProfilerWhenDeactivatingDebugFeaturesThenStopProfiling) {
+    writeProgram();
+    HostProfiler profiler{false};
+    processor.activateHostProfiler(&profiler);
+    processor.deactivateDebugFeatures();
+
+    processor.executeInstructions(3);
+    EXPECT_EQ(0u, profiler.getEmulatedInstructions());
+}
@@ -0,0 +1,185 @@
+#include "src/image_loader.h"
+#include "src/processor.h"
+#include "unit_test/fixtures/temporary_path.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+struct ImageLoaderTest : ::testing::Test {
+    void SetUp() override {
+        std::filesystem::create_directory(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    // Files are created in a directory of their own, so names of related files can be chosen by the test
+    std::string createFile(const std::string &name, const std::string &content) {
+        const std::string path = (std::filesystem::path(directory) / name).string();
+        std::ofstream file{path, std::ios::out | std::ios::binary};
+        file.write(content.data(), content.size());
+        return path;
+    }
+
+    const std::string directory = createTemporaryPath("emos_image_loader_");
+};
+
+TEST_F(ImageLoaderTest, givenRawImageThenShareFullPagesWithFileAndCopyPartialPages) {
+    std::string content(0x300, '\0');
+    for (size_t i = 0; i < content.size(); i++) {
+        content[i] = static_cast<char>(i * 7);
+    }
+    const std::shared_ptr<const MappedFile> file = MappedFile::open(createFile("raw.bin", content));
+    ASSERT_NE(nullptr, file);
+
+    LoadedImage image{};
+    ASSERT_TRUE(loadImage(file, 0, file->getSize(), ImageFormat::Raw, 0x1080, image));
+    EXPECT_EQ(nullptr, image.image.getPage(0x0F));
+    EXPECT_NE(nullptr, image.image.getPage(0x10));
+    EXPECT_NE(file->getData() - 0x80, image.image.getPage(0x10));
+    EXPECT_EQ(file->getData() + 0x80, image.image.getPage(0x11));
+    EXPECT_EQ(file->getData() + 0x180, image.image.getPage(0x12));
+    EXPECT_NE(nullptr, image.image.getPage(0x13));
+    EXPECT_EQ(nullptr, image.image.getPage(0x14));
+
+    Memory memory{};
+    memory.mapImage(image.image);
+    for (u32 i = 0; i < content.size(); i++) {
+        ASSERT_EQ(static_cast<u8>(content[i]), memory.read(static_cast<u16>(0x1080 + i)));
+    }
+    EXPECT_EQ(0u, memory.read(0x107F));
+    EXPECT_EQ(0u, memory.read(0x1380));
+}
+
+TEST_F(ImageLoaderTest, givenArchiveOfRawImagesThenAllImagesShareOneMapping) {
+    std::string content(0x200, '\x11');
+    content.replace(0x100, 0x100, 0x100, '\x22');
+    const std::shared_ptr<const MappedFile> file = MappedFile::open(createFile("archive.bin", content));
+
+    LoadedImage image0{};
+    LoadedImage image1{};
+    ASSERT_TRUE(loadImage(file, 0x000, 0x100, ImageFormat::Raw, 0x8000, image0));
+    ASSERT_TRUE(loadImage(file, 0x100, 0x100, ImageFormat::Raw, 0x8000, image1));
+    EXPECT_EQ(file->getData(), image0.image.getPage(0x80));
+    EXPECT_EQ(file->getData() + 0x100, image1.image.getPage(0x80));
+    EXPECT_EQ(3, file.use_count());
+
+    LoadedImage outOfBounds{};
+    EXPECT_FALSE(loadImage(file, 0x180, 0x100, ImageFormat::Raw, 0x8000, outOfBounds));
+    EXPECT_FALSE(loadImage(file, 0, 0x200, ImageFormat::Raw, 0xFF00, outOfBounds));
+}
+
+TEST_F(ImageLoaderTest, givenIntelHexThenLoadDataRecordsAndEntryPoint) {
+    const std::string content = ":020000040000FA\r\n"
+                                ":03020000A9428D83\r\n"
+                                ":02FFFC00000201\r\n"
+                                ":0400000500000200F5\r\n"
+                                ":00000001FF\r\n";
+    LoadedImage image{};
+    ASSERT_TRUE(loadImageFile(createFile("program.hex", content), getImageFormat("program.hex"), 0, image));
+    EXPECT_TRUE(image.hasEntryPoint);
+    EXPECT_EQ(0x0200, image.entryPoint);
+
+    Memory memory{};
+    memory.mapImage(image.image);
+    EXPECT_EQ(0xA9, memory.read(0x0200));
+    EXPECT_EQ(0x42, memory.read(0x0201));
+    EXPECT_EQ(0x8D, memory.read(0x0202));
+    EXPECT_EQ(0x00, memory.read(0x0203));
+    EXPECT_EQ(0x00, memory.read(0xFFFC));
+    EXPECT_EQ(0x02, memory.read(0xFFFD));
+}
+
+TEST_F(ImageLoaderTest, givenIntelHexRecordsCoveringPartsOfPageWhenMappingThenKeepBytesBetweenThem) {
+    const std::string content = ":03020000A9428D83\n"
+                                ":02021000EAEA18\n"
+                                ":00000001FF\n";
+    LoadedImage image{};
+    ASSERT_TRUE(loadImageFile(createFile("partial.hex", content), ImageFormat::IntelHex, 0, image));
+
+    Memory memory{};
+    memory.write(0x0205, 0xAA);
+    memory.write(0x0220, 0xBB);
+    memory.mapImage(image.image);
+    EXPECT_EQ(0xA9, memory.read(0x0200));
+    EXPECT_EQ(0x8D, memory.read(0x0202));
+    EXPECT_EQ(0xAA, memory.read(0x0205));
+    EXPECT_EQ(0xEA, memory.read(0x0210));
+    EXPECT_EQ(0xEA, memory.read(0x0211));
+    EXPECT_EQ(0xBB, memory.read(0x0220));
+}
+
+TEST_F(ImageLoaderTest, givenInvalidIntelHexThenReturnError) {
+    LoadedImage image{};
+    EXPECT_FALSE(loadImageFile(createFile("checksum.hex", ":03020000A9428D84\n"), ImageFormat::IntelHex, 0, image));
+    EXPECT_STREQ("Invalid Intel HEX checksum", image.error);
+    EXPECT_FALSE(loadImageFile(createFile("bounds.hex", ":02FFFF000102FD\n"), ImageFormat::IntelHex, 0, image));
+    EXPECT_STREQ("Intel HEX data out of memory bounds", image.error);
+    EXPECT_FALSE(loadImageFile(createFile("garbage.hex", "A9428D\n"), ImageFormat::IntelHex, 0, image));
+}
+
+TEST_F(ImageLoaderTest, givenSRecordThenLoadDataRecordsAndEntryPoint) {
+    const std::string content = "S00600004844521B\n"
+                                "S1060300A9428D7E\n"
+                                "S9030300F9\n";
+    LoadedImage image{};
+    ASSERT_TRUE(loadImageFile(createFile("program.s19", content), getImageFormat("program.s19"), 0, image));
+    EXPECT_TRUE(image.hasEntryPoint);
+    EXPECT_EQ(0x0300, image.entryPoint);
+
+    Memory memory{};
+    memory.mapImage(image.image);
+    EXPECT_EQ(0xA9, memory.read(0x0300));
+    EXPECT_EQ(0x42, memory.read(0x0301));
+    EXPECT_EQ(0x8D, memory.read(0x0302));
+
+    EXPECT_FALSE(loadImageFile(createFile("checksum.s19", "S1060300A9428D7F\n"), ImageFormat::SRecord, 0, image));
+    EXPECT_STREQ("Invalid S-record checksum", image.error);
+}
+
+TEST_F(ImageLoaderTest, givenAs65ListingThenFindLowestAssembledAddress) {
+    const std::string listing = "AS65 Assembler for R6502 [1.42].                                     Page    1\n"
+                                "000a =                  zero_page = $a\n"
+                                "                                org zero_page\n"
+                                "000c : 00               zpt     ds 1\n"
+                                "0400 : d8               start   cld\n"
+                                "0401 : a2ff                     ldx #$ff\n";
+    u16 address = 0;
+    EXPECT_TRUE(findAs65LoadAddress(listing.data(), listing.size(), address));
+    EXPECT_EQ(0x000C, address);
+
+    const std::string binaryPath = createFile("as65.bin", std::string{"\x11\x22"});
+    createFile("as65.lst", listing);
+    LoadedImage image{};
+    ASSERT_TRUE(loadImageFile(binaryPath, ImageFormat::As65, 0, image));
+    Memory memory{};
+    memory.mapImage(image.image);
+    EXPECT_EQ(0x11, memory.read(0x000C));
+    EXPECT_EQ(0x22, memory.read(0x000D));
+
+    EXPECT_FALSE(findAs65LoadAddress("no code\n", 8, address));
+}
+
+TEST_F(ImageLoaderTest, givenMappedImageWhenProgramWritesToItThenFileIsNotModified) {
+    const u8 program[] = {
+        static_cast<u8>(OpCode::INC_abs), 0x03, 0x80, // INC $8003
+        0x41,
+    };
+    const std::shared_ptr<const MappedFile> file = MappedFile::open(createFile("inc.bin", std::string{program, program + sizeof(program)}));
+    LoadedImage image{};
+    ASSERT_TRUE(loadImage(file, 0, file->getSize(), ImageFormat::Raw, 0x8000, image));
+
+    Processor processor{};
+    processor.mapMemoryImage(image.image);
+    processor.loadProgramCounter(0x8000);
+    processor.executeInstructions(1);
+    EXPECT_EQ(0x42, processor.getMemory().read(0x8003));
+    EXPECT_EQ(0x41, file->getData()[3]);
+
+    processor.unmapMemoryImages();
+    EXPECT_EQ(0x00, processor.getMemory().read(0x8000));
+}
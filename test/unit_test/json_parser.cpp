@@ -0,0 +1,74 @@
+#include "tools/conformance/json_parser.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+struct JsonParserTest : ::testing::Test {
+    void SetUp() override {
+#ifdef EMOS_NO_EXCEPTIONS
+        GTEST_SKIP() << "Parsing errors terminate the process";
+#endif
+    }
+
+    JsonParser createParser(const std::string &json) {
+        text = json;
+        return JsonParser{text.data(), text.size()};
+    }
+
+    std::string text = {};
+};
+
+TEST_F(JsonParserTest, givenStringWithEscapesThenReturnItUndecodedAndEndAtClosingQuote) {
+    JsonParser parser = createParser(R"( "a\"b\\" , "c" )");
+    EXPECT_EQ(R"(a\"b\\)", parser.parseString());
+    EXPECT_TRUE(parser.consume(','));
+    EXPECT_EQ("c", parser.parseString());
+    EXPECT_TRUE(parser.isAtEnd());
+}
+
+TEST_F(JsonParserTest, givenNestedContainersWhenSkippingValueThenContinueAfterThem) {
+    JsonParser parser = createParser(R"({"a": [1, {"b": [[], "]}", {}]}, "x"], "c": 7})");
+    parser.expect('{');
+    EXPECT_EQ("a", parser.parseKey());
+    parser.skipValue();
+    EXPECT_TRUE(parser.consume(','));
+    EXPECT_EQ("c", parser.parseKey());
+    EXPECT_EQ(7u, parser.parseUnsigned());
+    parser.expect('}');
+    EXPECT_TRUE(parser.isAtEnd());
+}
+
+TEST_F(JsonParserTest, givenUnsignedNumbersThenParseThemUpToU32Maximum) {
+    JsonParser parser = createParser(" 0, 00012 ,4294967295]");
+    EXPECT_EQ(0u, parser.parseUnsigned());
+    parser.expect(',');
+    EXPECT_EQ(12u, parser.parseUnsigned());
+    parser.expect(',');
+    EXPECT_EQ(4294967295u, parser.parseUnsigned());
+    parser.expect(']');
+}
+
+TEST_F(JsonParserTest, givenInvalidNumbersThenFail) {
+    EXPECT_ANY_THROW(createParser("4294967296").parseUnsigned());
+    EXPECT_ANY_THROW(createParser("99999999999").parseUnsigned());
+    EXPECT_ANY_THROW(createParser("-1").parseUnsigned());
+    EXPECT_ANY_THROW(createParser("\"1\"").parseUnsigned());
+    EXPECT_ANY_THROW(createParser("").parseUnsigned());
+}
+
+TEST_F(JsonParserTest, givenTruncatedInputThenFail) {
+    EXPECT_ANY_THROW(createParser("\"abc").parseString());
+    EXPECT_ANY_THROW(createParser("\"abc\\").parseString());
+    EXPECT_ANY_THROW(createParser("\"abc\\\"").parseString());
+    EXPECT_ANY_THROW(createParser("[1, [2]").skipValue());
+    EXPECT_ANY_THROW(createParser("{\"a\": \"}").skipValue());
+    EXPECT_ANY_THROW(createParser("\"a\"").parseKey());
+    EXPECT_ANY_THROW(createParser("  ").skipValue());
+
+    JsonParser parser = createParser("[1, 2");
+    parser.expect('[');
+    EXPECT_EQ(1u, parser.parseUnsigned());
+    parser.expect(',');
+    EXPECT_EQ(2u, parser.parseUnsigned());
+    EXPECT_ANY_THROW(parser.expect(']'));
+}
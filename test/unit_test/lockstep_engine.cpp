@@ -0,0 +1,143 @@
+#include "src/lockstep_engine.h"
+#include "unit_test/fixtures/emos_test.h"
+
+#include <vector>
+
+struct LockstepEngineTest : ::testing::Test {
+    void loadProgram(const std::vector<u8> &program) {
+        programImage = std::make_unique<MemoryImage>(0x8000, static_cast<u32>(program.size()), program.data());
+    }
+
+    void setUpEngine(LockstepEngine &engine, const std::vector<u8> &inputs) {
+        engine.mapMemoryImage(*programImage);
+        for (u32 lane = 0; lane < engine.getLaneCount(); lane++) {
+            engine.loadMemory(lane, 0x10, 1, &inputs[lane]);
+            Registers regs{};
+            regs.pc = 0x8000;
+            regs.sp = 0xFF;
+            engine.setRegisters(lane, regs);
+        }
+    }
+
+    void expectLanesMatchReferenceProcessors(LockstepEngine &engine, const std::vector<u8> &inputs, u32 instructionCount) {
+        for (u32 lane = 0; lane < engine.getLaneCount(); lane++) {
+            WhiteboxProcessor reference{};
+            reference.mapMemoryImage(*programImage);
+            reference.loadMemory(0x10, 1, &inputs[lane]);
+            reference.regs.pc = 0x8000;
+            reference.regs.sp = 0xFF;
+            reference.executeInstructions(instructionCount);
+
+            const Registers regs = engine.getRegisters(lane);
+            const Counters counters = engine.getCounters(lane);
+            EXPECT_EQ(reference.regs.a, regs.a);
+            EXPECT_EQ(reference.regs.x, regs.x);
+            EXPECT_EQ(reference.regs.y, regs.y);
+            EXPECT_EQ(reference.regs.sp, regs.sp);
+            EXPECT_EQ(reference.regs.pc, regs.pc);
+            EXPECT_EQ(reference.regs.flags.toU8(), regs.flags.toU8());
+            EXPECT_EQ(reference.counters.bytesProcessed, counters.bytesProcessed);
+            EXPECT_EQ(reference.counters.cyclesProcessed, counters.cyclesProcessed);
+            EXPECT_EQ(reference.counters.instructionsProcessed, counters.instructionsProcessed);
+            for (u16 address = 0; address < 0x20; address++) {
+                EXPECT_EQ(reference.memory.read(address), engine.readMemory(lane, address));
+            }
+        }
+    }
+
+    std::unique_ptr<MemoryImage> programImage{};
+};
+
+TEST_F(LockstepEngineTest, givenLanesExecutingTheSameInstructionsWhenExecutingThenExecuteAllLanesInLockstep) {
+    loadProgram({
+        static_cast<u8>(OpCode::LDX_imm), 0x00,
+        static_cast<u8>(OpCode::LDA_z), 0x10,
+        static_cast<u8>(OpCode::CLC),                // loop:
+        static_cast<u8>(OpCode::ADC_imm), 0x37,
+        static_cast<u8>(OpCode::ROL_acc),
+        static_cast<u8>(OpCode::EOR_imm), 0x5A,
+        static_cast<u8>(OpCode::STA_z), 0x11,
+        static_cast<u8>(OpCode::INX),
+        static_cast<u8>(OpCode::CPX_imm), 0x10,
+        static_cast<u8>(OpCode::BNE), 0xF3,          // bne loop
+        static_cast<u8>(OpCode::JMP_abs), 0x11, 0x80, // jmp *
+    });
+    const std::vector<u8> inputs = {0x00, 0x01, 0x7F, 0x80, 0xFF, 0x42, 0x13, 0xC8};
+    const u32 instructionCount = 2 + 16 * 8 + 10;
+
+    LockstepEngine engine{static_cast<u32>(inputs.size())};
+    setUpEngine(engine, inputs);
+    engine.executeInstructions(instructionCount);
+
+    expectLanesMatchReferenceProcessors(engine, inputs, instructionCount);
+    EXPECT_EQ(instructionCount, engine.getStatistics().lockstepSteps);
+    EXPECT_EQ(0u, engine.getStatistics().scalarInstructions);
+}
+
+TEST_F(LockstepEngineTest, givenLanesTakingDifferentBranchesWhenExecutingThenExecuteDivergedLanesSeparately) {
+    loadProgram({
+        static_cast<u8>(OpCode::LDA_z), 0x10,
+        static_cast<u8>(OpCode::BEQ), 0x02, // beq skip
+        static_cast<u8>(OpCode::INX),
+        static_cast<u8>(OpCode::INY),
+        static_cast<u8>(OpCode::PHA),       // skip:
+        static_cast<u8>(OpCode::TSX),
+        static_cast<u8>(OpCode::NOP),
+        static_cast<u8>(OpCode::NOP),
+        static_cast<u8>(OpCode::NOP),
+        static_cast<u8>(OpCode::NOP),
+    });
+    const std::vector<u8> inputs = {0x00, 0x05, 0x00, 0x07};
+    const u32 instructionCount = 6;
+
+    LockstepEngine engine{static_cast<u32>(inputs.size())};
+    setUpEngine(engine, inputs);
+    engine.executeInstructions(instructionCount);
+
+    expectLanesMatchReferenceProcessors(engine, inputs, instructionCount);
+    EXPECT_LT(0u, engine.getStatistics().lockstepSteps);
+    EXPECT_LT(0u, engine.getStatistics().scalarInstructions);
+}
+
+TEST_F(LockstepEngineTest, givenLaneExecutingUnsupportedInstructionWhenExecutingThenOnlyThisLaneIsFaulted) {
+    loadProgram({
+        static_cast<u8>(OpCode::LDA_z), 0x10,
+        static_cast<u8>(OpCode::BEQ), 0x01, // beq skip
+        0x02,                               // unsupported opcode
+        static_cast<u8>(OpCode::INX),       // skip:
+        static_cast<u8>(OpCode::INX),
+    });
+    const std::vector<u8> inputs = {0x00, 0x01, 0x00};
+
+    LockstepEngine engine{static_cast<u32>(inputs.size())};
+    setUpEngine(engine, inputs);
+    engine.executeInstructions(4);
+
+    EXPECT_FALSE(engine.isLaneFaulted(0));
+    EXPECT_TRUE(engine.isLaneFaulted(1));
+    EXPECT_FALSE(engine.isLaneFaulted(2));
+    EXPECT_EQ(0x02, engine.getRegisters(0).x);
+    EXPECT_EQ(2u, engine.getCounters(1).instructionsProcessed);
+    EXPECT_EQ(0x02, engine.getRegisters(2).x);
+}
+
+TEST_F(LockstepEngineTest, givenLanesModifyingInstructionDifferentlyWhenExecutingThenExecuteModifiedInstructionSeparately) {
+    loadProgram({
+        static_cast<u8>(OpCode::LDA_z), 0x10,
+        static_cast<u8>(OpCode::STA_abs), 0x06, 0x80, // modify operand of the next instruction
+        static_cast<u8>(OpCode::LDX_imm), 0x00,
+        static_cast<u8>(OpCode::NOP),
+        static_cast<u8>(OpCode::NOP),
+    });
+    const std::vector<u8> inputs = {0x11, 0x22, 0x33};
+    const u32 instructionCount = 5;
+
+    LockstepEngine engine{static_cast<u32>(inputs.size())};
+    setUpEngine(engine, inputs);
+    engine.executeInstructions(instructionCount);
+
+    expectLanesMatchReferenceProcessors(engine, inputs, instructionCount);
+    EXPECT_EQ(0x22, engine.getRegisters(1).x);
+    EXPECT_EQ(4u, engine.getStatistics().lockstepSteps);
+    EXPECT_EQ(inputs.size(), engine.getStatistics().scalarInstructions);
+}
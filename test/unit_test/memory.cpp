@@ -0,0 +1,190 @@
+#include "src/memory.h"
+#include "unit_test/fixtures/emos_test.h"
+
+#include <utility>
+#include <vector>
+
+TEST(MemoryTest, givenNewMemoryThenAllBytesAreZeroAndNoPagesAreAllocated) {
+    Memory memory{};
+    for (u32 address = 0; address < memorySize; address++) {
+        ASSERT_EQ(0, memory.read(static_cast<u16>(address)));
+    }
+    EXPECT_EQ(0u, memory.getPrivatePagesCount());
+}
+
+TEST(MemoryTest, givenWriteWhenPageIsSharedThenCopyOnlyThisPage) {
+    Memory memory{};
+    memory.write(0x1234, 0x56);
+    memory.write(0x1235, 0x57);
+
+    EXPECT_EQ(0x56, memory.read(0x1234));
+    EXPECT_EQ(0x57, memory.read(0x1235));
+    EXPECT_EQ(0x00, memory.read(0x1334));
+    EXPECT_EQ(1u, memory.getPrivatePagesCount());
+
+    Memory otherMemory{};
+    EXPECT_EQ(0x00, otherMemory.read(0x1234));
+}
+
+TEST(MemoryTest, givenImageMappedToMultipleMemoriesWhenWritingThenOtherMemoriesAreNotAffected) {
+    std::vector<u8> data(600);
+    for (u32 i = 0; i < data.size(); i++) {
+        data[i] = static_cast<u8>(i);
+    }
+    const MemoryImage image{0x80F0, static_cast<u32>(data.size()), data.data()};
+
+    Memory memory1{};
+    Memory memory2{};
+    memory1.mapImage(image);
+    memory2.mapImage(image);
+    EXPECT_EQ(0u, memory1.getPrivatePagesCount());
+    EXPECT_EQ(0u, memory2.getPrivatePagesCount());
+    EXPECT_EQ(0x00, memory1.read(0x80EF));
+    EXPECT_EQ(0x00, memory1.read(0x80F0));
+    EXPECT_EQ(0x10, memory1.read(0x8100));
+    EXPECT_EQ(static_cast<u8>(599), memory2.read(0x80F0 + 599));
+
+    memory1.write(0x8100, 0xFF);
+    EXPECT_EQ(0xFF, memory1.read(0x8100));
+    EXPECT_EQ(0x11, memory1.read(0x8101));
+    EXPECT_EQ(0x10, memory2.read(0x8100));
+    EXPECT_EQ(1u, memory1.getPrivatePagesCount());
+    EXPECT_EQ(0u, memory2.getPrivatePagesCount());
+}
+
+TEST(MemoryTest, givenImageCoveringPartOfPageWhenMappingThenKeepOtherBytesOfPage) {
+    Memory memory{};
+    for (u16 address = 0x0400; address < 0x0410; address++) {
+        memory.write(address, 0xAA);
+    }
+    memory.write(0x0420, 0xBB);
+
+    const u8 data[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    const MemoryImage image{0x0410, sizeof(data), data};
+    memory.mapImage(image);
+    for (u16 address = 0x0400; address < 0x0410; address++) {
+        EXPECT_EQ(0xAA, memory.read(address));
+    }
+    for (u16 i = 0; i < sizeof(data); i++) {
+        EXPECT_EQ(data[i], memory.read(static_cast<u16>(0x0410 + i)));
+    }
+    EXPECT_EQ(0xBB, memory.read(0x0420));
+
+    // Bytes written before mapping are modifications, but bytes of the image stay after reset
+    memory.reset();
+    EXPECT_EQ(0x00, memory.read(0x0400));
+    EXPECT_EQ(0x01, memory.read(0x0410));
+    EXPECT_EQ(0x00, memory.read(0x0420));
+}
+
+TEST(MemoryTest, givenImagesCoveringDifferentPartsOfPageWhenMappingBothThenKeepBothAfterReset) {
+    const u8 data1[] = {0x11, 0x12};
+    const u8 data2[] = {0x21, 0x22};
+    const MemoryImage image1{0x0500, sizeof(data1), data1};
+    const MemoryImage image2{0x0580, sizeof(data2), data2};
+
+    Memory memory{};
+    memory.mapImage(image1);
+    memory.mapImage(image2);
+    memory.write(0x0501, 0xFF);
+    memory.reset();
+    EXPECT_EQ(0x11, memory.read(0x0500));
+    EXPECT_EQ(0x12, memory.read(0x0501));
+    EXPECT_EQ(0x21, memory.read(0x0580));
+    EXPECT_EQ(0x22, memory.read(0x0581));
+    EXPECT_EQ(0x00, memory.read(0x0502));
+}
+
+TEST(MemoryTest, givenClonedMemoryWhenWritingThenBothMemoriesAreIndependent) {
+    Memory memory{};
+    memory.write(0x0010, 0x11);
+
+    Memory clone = memory.clone();
+    EXPECT_EQ(0x11, clone.read(0x0010));
+
+    memory.write(0x0010, 0x22);
+    clone.write(0x0011, 0x33);
+    EXPECT_EQ(0x22, memory.read(0x0010));
+    EXPECT_EQ(0x00, memory.read(0x0011));
+    EXPECT_EQ(0x11, clone.read(0x0010));
+    EXPECT_EQ(0x33, clone.read(0x0011));
+}
+
+TEST(MemoryTest, givenPageNoLongerSharedWhenWritingThenDoNotCopyItAgain) {
+    Memory memory{};
+    u8 &value = memory[0x0200];
+    value = 0x12;
+    {
+        Memory clone = memory.clone();
+    }
+
+    memory.write(0x0200, 0x34);
+    EXPECT_EQ(0x34, value);
+    EXPECT_EQ(1u, memory.getPrivatePagesCount());
+}
+
+struct RecordingWriteTrap : MemoryWriteTrap {
+    void onTrappedWrite(u16 address, u8 value) override {
+        writes.emplace_back(address, value);
+    }
+    std::vector<std::pair<u16, u8>> writes = {};
+};
+
+TEST(MemoryTest, givenTrappedPageWhenWritingThenPassWriteToTrapAndDoNotModifyPage) {
+    RecordingWriteTrap trap{};
+    Memory memory{};
+    memory[0x4010] = 0x11;
+    memory.trapWrites(0x40, &trap);
+
+    memory.write(0x4010, 0x22);
+    memory.write(0x40FF, 0x33);
+    memory.write(0x4100, 0x44);
+    ASSERT_EQ(2u, trap.writes.size());
+    EXPECT_EQ(std::make_pair(u16{0x4010}, u8{0x22}), trap.writes[0]);
+    EXPECT_EQ(std::make_pair(u16{0x40FF}, u8{0x33}), trap.writes[1]);
+    EXPECT_EQ(0x11, memory.read(0x4010));
+    EXPECT_EQ(0x44, memory.read(0x4100));
+
+    memory.untrapWrites(0x40);
+    memory.write(0x4010, 0x55);
+    EXPECT_EQ(2u, trap.writes.size());
+    EXPECT_EQ(0x55, memory.read(0x4010));
+}
+
+TEST(MemoryTest, givenTrappedPageWhenLoadingThenPageStaysTrapped) {
+    RecordingWriteTrap trap{};
+    Memory memory{};
+    memory.trapWrites(0x40, &trap);
+
+    const u8 data[] = {0x12, 0x34};
+    memory.load(0x4000, sizeof(data), data);
+    memory.write(0x4000, 0x56);
+    EXPECT_EQ(0x12, memory.read(0x4000));
+    EXPECT_EQ(1u, trap.writes.size());
+}
+
+struct MemoryImageTest : EmosTest {};
+
+TEST_F(MemoryImageTest, givenProgramInMemoryImageWhenExecutingThenUseImageWithoutModifyingIt) {
+    const u8 program[] = {
+        static_cast<u8>(OpCode::LDA_abs), 0x00, 0x90,
+        static_cast<u8>(OpCode::STA_abs), 0x01, 0x90,
+    };
+    const u8 data[] = {0x42, 0x00};
+    const MemoryImage programImage{0x8000, sizeof(program), program};
+    const MemoryImage dataImage{0x9000, sizeof(data), data};
+
+    WhiteboxProcessor otherProcessor{};
+    otherProcessor.mapMemoryImage(dataImage);
+    processor.mapMemoryImage(programImage);
+    processor.mapMemoryImage(dataImage);
+    processor.loadProgramCounter(0x8000);
+    processor.executeInstructions(2);
+
+    EXPECT_EQ(0x42, processor.regs.a);
+    EXPECT_EQ(0x42, processor.memory.read(0x9001));
+    EXPECT_EQ(0x00, otherProcessor.memory.read(0x9001));
+
+    expectedBytesProcessed = 6;
+    expectedCyclesProcessed = 8;
+}
@@ -0,0 +1,90 @@
+#include "src/processor_pool.h"
+#include "unit_test/fixtures/emos_test.h"
+
+#include <set>
+
+struct ResetTest : EmosTest {};
+
+TEST_F(ResetTest, whenResettingThenLoadProgramCounterFromResetVectorAndDropMemoryModifications) {
+    const u8 vector[] = {0x34, 0x12};
+    const MemoryImage image{0xFFFC, sizeof(vector), vector};
+    processor.mapMemoryImage(image);
+    processor.memory[0x0200] = 0x11;
+    processor.memory[0xFFFC] = 0x00;
+    processor.memory[0xFFFD] = 0x80;
+    processor.counters.cyclesProcessed = 100;
+    processor.counters.bytesProcessed = 50;
+
+    flags.expectInterruptFlag(true);
+    processor.reset();
+
+    EXPECT_EQ(0x1234, processor.regs.pc);
+    EXPECT_EQ(0xFD, processor.regs.sp);
+    EXPECT_EQ(0x00, processor.memory.read(0x0200));
+    EXPECT_EQ(0u, processor.memory.getPrivatePagesCount());
+    EXPECT_EQ(0u, processor.counters.instructionsProcessed);
+}
+
+TEST(ProcessorPoolTest, whenAcquiringProcessorsThenTheyAreAlignedToCacheLines) {
+    ProcessorPool pool{10};
+    std::set<Processor *> processors{};
+    for (u32 i = 0; i < pool.getCapacity(); i++) {
+        Processor *processor = pool.acquire();
+        ASSERT_NE(nullptr, processor);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(processor) % ProcessorPool::cacheLineSize);
+        processors.insert(processor);
+    }
+    EXPECT_EQ(pool.getCapacity(), processors.size());
+    EXPECT_EQ(nullptr, pool.acquire());
+
+    for (Processor *processor : processors) {
+        pool.release(processor);
+    }
+}
+
+TEST(ProcessorPoolTest, givenReleasedProcessorWhenAcquiringAgainThenItIsReset) {
+    const u8 program[] = {
+        static_cast<u8>(OpCode::LDX_imm), 0x05,
+        static_cast<u8>(OpCode::INX),
+    };
+    const u8 vector[] = {0x00, 0x80};
+    const MemoryImage programImage{0x8000, sizeof(program), program};
+    const MemoryImage vectorImage{0xFFFC, sizeof(vector), vector};
+
+    ProcessorPool pool{1};
+    Processor *processor = pool.acquire();
+    processor->mapMemoryImage(programImage);
+    processor->mapMemoryImage(vectorImage);
+    processor->reset();
+    processor->executeInstructions(2);
+    EXPECT_EQ(0x06, processor->getRegisters().x);
+    pool.release(processor);
+
+    processor = pool.acquire();
+    EXPECT_EQ(0x8000, processor->getRegisters().pc);
+    EXPECT_EQ(0x00, processor->getRegisters().x);
+    EXPECT_EQ(0u, processor->getCounters().cyclesProcessed);
+    processor->executeInstructions(2);
+    EXPECT_EQ(0x06, processor->getRegisters().x);
+    pool.release(processor);
+}
+
+TEST(ProcessorPoolTest, whenProcessorsWriteMemoryThenPagesAreAllocatedFromPoolArena) {
+    ProcessorPool pool{2, 1};
+    Processor *processor = pool.acquire();
+    const u8 data[] = {0x11, 0x22};
+    processor->loadMemory(0x0200, sizeof(data), data);
+    EXPECT_EQ(1u, pool.getPageArena().getUsedBlocksCount());
+
+    // Arena has space for two pages, the third one comes from the heap
+    processor->loadMemory(0x0300, sizeof(data), data);
+    processor->loadMemory(0x0400, sizeof(data), data);
+    EXPECT_EQ(2u, pool.getPageArena().getUsedBlocksCount());
+    EXPECT_EQ(0x22, processor->getMemory().read(0x0401));
+    pool.release(processor);
+
+    processor = pool.acquire();
+    EXPECT_EQ(0u, pool.getPageArena().getUsedBlocksCount());
+    EXPECT_EQ(0x00, processor->getMemory().read(0x0201));
+    pool.release(processor);
+}
@@ -0,0 +1,232 @@
+#include "src/bit_operations.h"
+#include "src/error.h"
+#include "src/semihosting.h"
+#include "unit_test/fixtures/emos_test.h"
+
+#include <vector>
+
+struct ReverseExecutionTest : EmosTest {
+    void initializeIncrementLoop() {
+        processor.memory[startAddress + 0] = static_cast<u8>(OpCode::INX);
+        processor.memory[startAddress + 1] = static_cast<u8>(OpCode::JMP_abs);
+        processor.memory[startAddress + 2] = lo(startAddress);
+        processor.memory[startAddress + 3] = hi(startAddress);
+    }
+};
+
+TEST_F(ReverseExecutionTest, givenExecutedInstructionsWhenSteppingBackThenRestoreRegistersAndCounters) {
+    std::fill_n(&processor.memory[startAddress], 50, static_cast<u8>(OpCode::INX));
+    const u8 initialX = processor.regs.x;
+
+    processor.activateReverseExecution(8, 100);
+    ASSERT_TRUE(processor.executeInstructions(30));
+    EXPECT_EQ(initialX + 30, processor.regs.x);
+
+    ASSERT_TRUE(processor.stepBack(10));
+    EXPECT_EQ(initialX + 20, processor.regs.x);
+    EXPECT_EQ(startAddress + 20, processor.regs.pc);
+    EXPECT_EQ(20u, processor.counters.instructionsProcessed);
+
+    expectedBytesProcessed = 20;
+    expectedCyclesProcessed = 40;
+}
+
+TEST_F(ReverseExecutionTest, givenMemoryModificationsWhenSteppingBackThenRestoreMemory) {
+    processor.regs.sp = 0xFF;
+    for (u16 i = 0; i < 20; i++) {
+        processor.memory[startAddress + 3 * i + 0] = static_cast<u8>(OpCode::INC_z);
+        processor.memory[startAddress + 3 * i + 1] = 0x10;
+        processor.memory[startAddress + 3 * i + 2] = static_cast<u8>(OpCode::PHA);
+    }
+    processor.memory[0x10] = 0;
+    processor.memory[0x1F0] = 0xAB;
+
+    processor.activateReverseExecution(4, 100);
+    ASSERT_TRUE(processor.executeInstructions(40));
+    EXPECT_EQ(20, processor.memory[0x10]);
+    EXPECT_EQ(processor.regs.a, processor.memory[0x1F0]);
+    EXPECT_EQ(0xEB, processor.regs.sp);
+
+    ASSERT_TRUE(processor.stepBack(30));
+    EXPECT_EQ(5, processor.memory[0x10]);
+    EXPECT_EQ(0xAB, processor.memory[0x1F0]);
+    EXPECT_EQ(0xFA, processor.regs.sp);
+    EXPECT_EQ(startAddress + 15, processor.regs.pc);
+
+    expectedBytesProcessed = 15;
+    expectedCyclesProcessed = 5 * 5 + 5 * 3;
+}
+
+TEST_F(ReverseExecutionTest, givenStepBackBeyondOldestCheckpointWhenSteppingBackThenFailAndKeepState) {
+    std::fill_n(&processor.memory[startAddress], 50, static_cast<u8>(OpCode::INX));
+    const u8 initialX = processor.regs.x;
+
+    processor.activateReverseExecution(4, 2);
+    ASSERT_TRUE(processor.executeInstructions(30));
+
+    EXPECT_FALSE(processor.stepBack(10));
+    EXPECT_EQ(initialX + 30, processor.regs.x);
+    EXPECT_EQ(30u, processor.counters.instructionsProcessed);
+
+    EXPECT_TRUE(processor.stepBack(5));
+    EXPECT_EQ(initialX + 25, processor.regs.x);
+
+    expectedBytesProcessed = 25;
+    expectedCyclesProcessed = 50;
+}
+
+TEST_F(ReverseExecutionTest, givenVisitedAddressWhenRunningBackToPcThenStopAtItsLastVisit) {
+    initializeIncrementLoop();
+    const u8 initialX = processor.regs.x;
+
+    processor.activateReverseExecution(4, 100);
+    ASSERT_TRUE(processor.executeInstructions(21));
+    EXPECT_EQ(startAddress + 1, processor.regs.pc);
+
+    ASSERT_TRUE(processor.runBackToPc(startAddress));
+    EXPECT_EQ(startAddress, processor.regs.pc);
+    EXPECT_EQ(initialX + 10, processor.regs.x);
+    EXPECT_EQ(20u, processor.counters.instructionsProcessed);
+
+    ASSERT_TRUE(processor.runBackToPc(startAddress + 1));
+    EXPECT_EQ(startAddress + 1, processor.regs.pc);
+    EXPECT_EQ(initialX + 10, processor.regs.x);
+    EXPECT_EQ(19u, processor.counters.instructionsProcessed);
+
+    expectedBytesProcessed = 10 * 1 + 9 * 3;
+    expectedCyclesProcessed = 10 * 2 + 9 * 3;
+}
+
+TEST_F(ReverseExecutionTest, givenNotVisitedAddressWhenRunningBackToPcThenFailAndKeepState) {
+    initializeIncrementLoop();
+    const u8 initialX = processor.regs.x;
+
+    processor.activateReverseExecution(4, 100);
+    ASSERT_TRUE(processor.executeInstructions(21));
+
+    EXPECT_FALSE(processor.runBackToPc(startAddress + 2));
+    EXPECT_EQ(startAddress + 1, processor.regs.pc);
+    EXPECT_EQ(initialX + 11, processor.regs.x);
+    EXPECT_EQ(21u, processor.counters.instructionsProcessed);
+
+    expectedBytesProcessed = 11 * 1 + 10 * 3;
+    expectedCyclesProcessed = 11 * 2 + 10 * 3;
+}
+
+TEST_F(ReverseExecutionTest, givenAddressVisitedBeforeLimitWhenRunningBackToPcThenFailAndKeepState) {
+    std::fill_n(&processor.memory[startAddress], 50, static_cast<u8>(OpCode::INX));
+    const u8 initialX = processor.regs.x;
+
+    processor.activateReverseExecution(4, 100);
+    ASSERT_TRUE(processor.executeInstructions(30));
+
+    EXPECT_FALSE(processor.runBackToPc(startAddress + 5, 10));
+    EXPECT_EQ(startAddress + 30, processor.regs.pc);
+    EXPECT_EQ(initialX + 30, processor.regs.x);
+    EXPECT_EQ(30u, processor.counters.instructionsProcessed);
+
+    ASSERT_TRUE(processor.runBackToPc(startAddress + 20, 10));
+    EXPECT_EQ(startAddress + 20, processor.regs.pc);
+    EXPECT_EQ(initialX + 20, processor.regs.x);
+
+    expectedBytesProcessed = 20;
+    expectedCyclesProcessed = 40;
+}
+
+TEST_F(ReverseExecutionTest, givenEdgeCoverageWhenSteppingBackThenDoNotCountReplayedEdges) {
+    initializeIncrementLoop();
+    std::vector<u8> coverageMap(EdgeCoverage::mapSize);
+
+    processor.activateEdgeCoverage(coverageMap.data());
+    processor.activateReverseExecution(4, 100);
+    ASSERT_TRUE(processor.executeInstructions(21));
+    const std::vector<u8> coverageBeforeStepBack = coverageMap;
+
+    ASSERT_TRUE(processor.stepBack(7));
+    EXPECT_EQ(14u, processor.counters.instructionsProcessed);
+    EXPECT_EQ(coverageBeforeStepBack, coverageMap);
+
+    expectedBytesProcessed = 7 * 1 + 7 * 3;
+    expectedCyclesProcessed = 7 * 2 + 7 * 3;
+}
+
+TEST_F(ReverseExecutionTest, givenHangWhenSteppingBackThenHangDetectorCanBeUsedAgain) {
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::JMP_abs);
+    processor.memory[startAddress + 1] = lo(startAddress);
+    processor.memory[startAddress + 2] = hi(startAddress);
+
+    processor.activateHangDetector();
+    processor.activateReverseExecution(4, 100);
+    ASSERT_FALSE(processor.executeInstructions(50));
+    EXPECT_EQ(startAddress, processor.getHangAddress());
+
+    ASSERT_TRUE(processor.stepBack(5));
+    EXPECT_EQ(4u, processor.counters.instructionsProcessed);
+    ASSERT_TRUE(processor.executeInstructions(3));
+
+    expectedBytesProcessed = 7 * 3;
+    expectedCyclesProcessed = 7 * 3;
+}
+
+TEST_F(ReverseExecutionTest, givenGuestExitWhenGoingBackThenReplayAndExitAgain) {
+    Semihosting semihosting{};
+    processor.attachSemihosting(&semihosting);
+    std::fill_n(&processor.memory[startAddress], 10, static_cast<u8>(OpCode::INX));
+    const u16 exitAddress = semihosting.getPageAddress() + static_cast<u16>(Semihosting::Command::Exit);
+    processor.memory[startAddress + 10] = static_cast<u8>(OpCode::STA_abs);
+    processor.memory[startAddress + 11] = lo(exitAddress);
+    processor.memory[startAddress + 12] = hi(exitAddress);
+    processor.memory[startAddress + 13] = static_cast<u8>(OpCode::INX);
+    const u8 initialX = processor.regs.x;
+
+    processor.activateReverseExecution(4, 100);
+    ASSERT_EQ(StopReason::GuestExit, processor.executeInstructions(20).stopReason);
+    EXPECT_EQ(11u, processor.counters.instructionsProcessed);
+
+    ASSERT_TRUE(processor.stepBack(3));
+    EXPECT_EQ(8u, processor.counters.instructionsProcessed);
+    EXPECT_EQ(startAddress + 8, processor.regs.pc);
+    EXPECT_EQ(initialX + 8, processor.regs.x);
+
+    const ExecutionResult result = processor.executeInstructions(20);
+    EXPECT_EQ(StopReason::GuestExit, result.stopReason);
+    EXPECT_EQ(3u, result.instructionsExecuted);
+    EXPECT_EQ(startAddress + 13, result.pc);
+
+    ASSERT_TRUE(processor.runBackToPc(startAddress + 2));
+    EXPECT_EQ(2u, processor.counters.instructionsProcessed);
+    EXPECT_EQ(initialX + 2, processor.regs.x);
+    processor.attachSemihosting(nullptr);
+
+    expectedBytesProcessed = 2;
+    expectedCyclesProcessed = 4;
+}
+
+TEST_F(ReverseExecutionTest, givenGuestErrorWhenGoingBackThenReplayAndFailAgain) {
+    flags.expectDecimalFlag(false, true);
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::SED);
+    std::fill_n(&processor.memory[startAddress + 1], 4, static_cast<u8>(OpCode::INX));
+    processor.memory[startAddress + 5] = static_cast<u8>(OpCode::ADC_imm);
+    processor.memory[startAddress + 6] = 0x0A; // invalid BCD
+    const u8 initialX = processor.regs.x;
+
+    processor.activateReverseExecution(2, 100);
+    ASSERT_EQ(StopReason::GuestError, processor.executeInstructions(20).stopReason);
+    EXPECT_EQ(5u, processor.counters.instructionsProcessed);
+
+    ASSERT_TRUE(processor.stepBack(2));
+    EXPECT_EQ(3u, processor.counters.instructionsProcessed);
+    EXPECT_EQ(startAddress + 3, processor.regs.pc);
+    EXPECT_EQ(nullptr, processor.getGuestError());
+
+    const ExecutionResult result = processor.executeInstructions(20);
+    EXPECT_EQ(StopReason::GuestError, result.stopReason);
+    EXPECT_EQ(2u, result.instructionsExecuted);
+
+    ASSERT_TRUE(processor.runBackToPc(startAddress + 1));
+    EXPECT_EQ(1u, processor.counters.instructionsProcessed);
+    EXPECT_EQ(initialX, processor.regs.x);
+
+    expectedBytesProcessed = 1;
+    expectedCyclesProcessed = 2;
+}
@@ -0,0 +1,105 @@
+#include "src/semihosting.h"
+#include "unit_test/fixtures/emos_test.h"
+
+struct SemihostingTest : EmosTest {
+    void SetUp() override {
+        EmosTest::SetUp();
+        processor.attachSemihosting(&semihosting);
+    }
+
+    void TearDown() override {
+        processor.attachSemihosting(nullptr);
+        EmosTest::TearDown();
+    }
+
+    // Writes STA abs to the command register at given address and returns the address after it
+    u16 writeCommand(u16 address, Semihosting::Command command) {
+        const u16 commandAddress = semihosting.getPageAddress() + static_cast<u16>(command);
+        processor.memory[address + 0] = static_cast<u8>(OpCode::STA_abs);
+        processor.memory[address + 1] = static_cast<u8>(commandAddress);
+        processor.memory[address + 2] = static_cast<u8>(commandAddress >> 8);
+        return address + 3;
+    }
+
+    Semihosting semihosting{};
+};
+
+TEST_F(SemihostingTest, givenPutcharCommandsThenBufferOutputAndDoNotModifyMemory) {
+    u16 address = startAddress;
+    for (const char character : {'h', 'i', '\n'}) {
+        processor.memory[address + 0] = static_cast<u8>(OpCode::LDA_imm);
+        processor.memory[address + 1] = static_cast<u8>(character);
+        address = writeCommand(address + 2, Semihosting::Command::Putchar);
+    }
+
+    const ExecutionResult result = processor.executeInstructions(6);
+    EXPECT_EQ(StopReason::BudgetExhausted, result.stopReason);
+    EXPECT_EQ("hi\n", semihosting.getOutput());
+    EXPECT_EQ(0x00, processor.memory.read(semihosting.getPageAddress() + 1));
+
+    expectedBytesProcessed = 15;
+    expectedCyclesProcessed = 18;
+    flags.ignoreZeroFlag();
+    flags.ignoreNegativeFlag();
+}
+
+TEST_F(SemihostingTest, givenExitCommandThenStopAfterTheInstructionWithExitCode) {
+    processor.memory[startAddress + 0] = static_cast<u8>(OpCode::LDA_imm);
+    processor.memory[startAddress + 1] = 0x2A;
+    const u16 nextAddress = writeCommand(startAddress + 2, Semihosting::Command::Exit);
+    processor.memory[nextAddress] = static_cast<u8>(OpCode::INX);
+    const u8 initialX = processor.regs.x;
+
+    const ExecutionResult result = processor.executeInstructions(10);
+    EXPECT_EQ(StopReason::GuestExit, result.stopReason);
+    EXPECT_EQ(nextAddress, result.pc);
+    EXPECT_EQ(2u, result.instructionsExecuted);
+    EXPECT_TRUE(semihosting.hasExited());
+    EXPECT_EQ(0x2A, semihosting.getExitCode());
+
+    // Exit is sticky
+    EXPECT_EQ(StopReason::GuestExit, processor.executeInstructions(10).stopReason);
+    EXPECT_EQ(initialX, processor.regs.x);
+
+    expectedBytesProcessed = 5;
+    expectedCyclesProcessed = 6;
+}
+
+TEST_F(SemihostingTest, givenStopwatchCommandsThenMeasureEmulatedCyclesBetweenThem) {
+    u16 address = writeCommand(startAddress, Semihosting::Command::StopwatchStart);
+    processor.memory[address++] = static_cast<u8>(OpCode::INX);
+    processor.memory[address++] = static_cast<u8>(OpCode::NOP);
+    writeCommand(address, Semihosting::Command::StopwatchStop);
+
+    processor.executeInstructions(4);
+    EXPECT_EQ(8u, semihosting.getStopwatchCycles());
+
+    expectedBytesProcessed = 8;
+    expectedCyclesProcessed = 12;
+    flags.ignoreZeroFlag();
+    flags.ignoreNegativeFlag();
+}
+
+TEST_F(SemihostingTest, givenDumpRegistersCommandThenAppendRegistersToOutput) {
+    processor.regs.a = 0x12;
+    writeCommand(startAddress, Semihosting::Command::DumpRegisters);
+
+    processor.executeInstructions(1);
+    EXPECT_EQ(0u, semihosting.getOutput().find("A=0x12 X=0x23 Y=0x33 SP=0x43 PC=0xff03"));
+
+    expectedBytesProcessed = 3;
+    expectedCyclesProcessed = 4;
+}
+
+TEST_F(SemihostingTest, givenSemihostingDetachedThenPageIsRegularMemory) {
+    processor.attachSemihosting(nullptr);
+    processor.regs.a = 0x12;
+    writeCommand(startAddress, Semihosting::Command::Exit);
+
+    EXPECT_EQ(StopReason::BudgetExhausted, processor.executeInstructions(1).stopReason);
+    EXPECT_FALSE(semihosting.hasExited());
+    EXPECT_EQ(0x12, processor.memory.read(semihosting.getPageAddress()));
+
+    expectedBytesProcessed = 3;
+    expectedCyclesProcessed = 4;
+}
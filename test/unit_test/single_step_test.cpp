@@ -0,0 +1,111 @@
+#include "tools/conformance/single_step_test.h"
+#include "unit_test/fixtures/temporary_path.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+struct SingleStepTest : ::testing::Test {
+    void TearDown() override {
+        if (!path.empty()) {
+            std::filesystem::remove(path);
+        }
+    }
+
+    SingleStepCase parseCase(const std::string &json) {
+        text = json;
+        JsonParser parser{text.data(), text.size()};
+        SingleStepCase result{};
+        parseSingleStepCase(parser, result);
+        return result;
+    }
+
+    const std::string &createFile(const std::string &content) {
+        path = createTemporaryPath("emos_single_step_");
+        std::ofstream file{path, std::ios::out | std::ios::binary};
+        file.write(content.data(), content.size());
+        return path;
+    }
+
+    // LDA #$12 at 0x1234
+    static std::string createLdaCase(const char *name, u32 expectedA) {
+        return std::string{"{\"name\": \""} + name + "\", " +
+               R"("initial": {"pc": 4660, "s": 253, "a": 1, "x": 2, "y": 3, "p": 36, "ram": [[4660, 169], [4661, 18]]}, )" +
+               R"("final": {"pc": 4662, "s": 253, "a": )" + std::to_string(expectedA) + R"(, "x": 2, "y": 3, "p": 36, "ram": [[4660, 169], [4661, 18]]}, )" +
+               R"("cycles": [[4660, 169, "read"], [4661, 18, "read"]]})";
+    }
+
+    std::string text = {};
+    std::string path = {};
+};
+
+TEST_F(SingleStepTest, givenCaseThenParseAllFieldsAndSkipUnknownOnes) {
+    const SingleStepCase testCase = parseCase(R"({"name": "a9 12", "unknown": {"nested": [1, "\"]"]},
+        "initial": {"pc": 4660, "s": 253, "a": 1, "x": 2, "y": 3, "p": 37, "ram": [[4660, 169], [4661, 18]]},
+        "final": {"pc": 4662, "s": 253, "a": 18, "x": 2, "y": 3, "p": 36, "ram": []},
+        "cycles": [[4660, 169, "read"], [4661, 18, "read"]]})");
+
+    EXPECT_EQ("a9 12", testCase.name);
+    EXPECT_EQ(0x1234, testCase.initial.regs.pc);
+    EXPECT_EQ(253, testCase.initial.regs.sp);
+    EXPECT_EQ(1, testCase.initial.regs.a);
+    EXPECT_EQ(2, testCase.initial.regs.x);
+    EXPECT_EQ(3, testCase.initial.regs.y);
+    EXPECT_EQ(37, testCase.initial.regs.flags.toU8());
+    ASSERT_EQ(2u, testCase.initial.ram.size());
+    EXPECT_EQ(0x1235, testCase.initial.ram[1].first);
+    EXPECT_EQ(18, testCase.initial.ram[1].second);
+    EXPECT_EQ(0x1236, testCase.expected.regs.pc);
+    EXPECT_EQ(18, testCase.expected.regs.a);
+    EXPECT_TRUE(testCase.expected.ram.empty());
+    EXPECT_EQ(2u, testCase.cyclesCount);
+}
+
+TEST_F(SingleStepTest, givenCasesThenRunnerReportsPassedFailedAndSkippedOnes) {
+    SingleStepRunner runner{};
+    std::string description{};
+    EXPECT_EQ(SingleStepRunner::Result::Passed, runner.run(parseCase(createLdaCase("pass", 18)), &description));
+    EXPECT_TRUE(description.empty());
+
+    EXPECT_EQ(SingleStepRunner::Result::Failed, runner.run(parseCase(createLdaCase("fail", 19)), &description));
+    EXPECT_EQ("a: 0x13 != 0x12\n", description);
+
+    SingleStepCase unsupported = parseCase(createLdaCase("skip", 18));
+    unsupported.initial.ram[0].second = 0x02;
+    EXPECT_EQ(SingleStepRunner::Result::Skipped, runner.run(unsupported, nullptr));
+}
+
+TEST_F(SingleStepTest, givenFileWithFailingCaseThenCountItAndRunRemainingCases) {
+    const std::string content = "[" + createLdaCase("first", 18) + "," + createLdaCase("second", 19) + "," + createLdaCase("third", 18) + "]";
+    const SingleStepFileResult result = runSingleStepFile(createFile(content), 10);
+    EXPECT_TRUE(result.parsed);
+    EXPECT_EQ(2u, result.passed);
+    EXPECT_EQ(1u, result.failed);
+    EXPECT_EQ(0u, result.skipped);
+    EXPECT_EQ(0u, result.failures.find("Case \"second\":\n"));
+}
+
+TEST_F(SingleStepTest, givenFileWithMalformedCaseThenCountItAsFailedAndStopParsing) {
+#ifdef EMOS_NO_EXCEPTIONS
+    GTEST_SKIP() << "Parsing errors terminate the process";
+#endif
+    std::string malformedCase = createLdaCase("second", 18);
+    malformedCase.replace(malformedCase.find("4660"), 4, "4294967296");
+    const std::string content = "[" + createLdaCase("first", 18) + "," + malformedCase + "," + createLdaCase("third", 18) + "]";
+    const SingleStepFileResult result = runSingleStepFile(createFile(content), 10);
+    EXPECT_FALSE(result.parsed);
+    EXPECT_EQ(1u, result.passed);
+    EXPECT_EQ(1u, result.failed);
+}
+
+TEST_F(SingleStepTest, givenTruncatedFileThenItIsNotParsed) {
+#ifdef EMOS_NO_EXCEPTIONS
+    GTEST_SKIP() << "Parsing errors terminate the process";
+#endif
+    const std::string content = "[" + createLdaCase("first", 18) + ",";
+    const SingleStepFileResult result = runSingleStepFile(createFile(content), 10);
+    EXPECT_FALSE(result.parsed);
+    EXPECT_EQ(1u, result.passed);
+    EXPECT_EQ(1u, result.failed);
+}
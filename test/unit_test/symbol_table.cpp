@@ -0,0 +1,118 @@
+#include "src/symbol_table.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+const std::string listing = "AS65 Assembler for R6502 [1.42].                                     Page    1\n"
+                            "---------------------------------------------------- 6502_test.a65 ----------------------------------------------------\n"
+                            "000a =                  zero_page = $a\n"
+                            "                        trap    macro\n"
+                            "                                jmp *           ;failed anyway\n"
+                            "                                endm\n"
+                            "                        success macro\n"
+                            "                                jmp *           ;test passed, no errors\n"
+                            "                                endm\n"
+                            "                                org zero_page\n"
+                            "000a : 00               zpt     ds 1\n"
+                            "0400 : d8               start   cld\n"
+                            "0401 : a2ff                     ldx #$ff\n"
+                            "                        test_case\n"
+                            "0403 : ca                       dex\n"
+                            "                        .loop:  ;a comment\n"
+                            "0404 : d0fe                     bne .loop\n"
+                            "                                trap\n"
+                            "0406 : 4c0604          >        jmp *           ;failed anyway\n"
+                            "                        done    org $500\n"
+                            "                                success\n"
+                            "0500 : 4c0005          >        jmp *           ;test passed, no errors\n"
+                            "\r\n"
+                            "Symbol table:\n"
+                            "start           0400*   zero_page       000a\n";
+} // namespace
+
+TEST(SymbolTableTest, givenAs65ListingThenLoadLabelsAtAddressesOfAssembledLines) {
+    SymbolTable symbols{};
+    ASSERT_TRUE(symbols.loadAs65Listing(listing.data(), listing.size()));
+    EXPECT_EQ(4u, symbols.getSymbolsCount(SymbolTable::Kind::Label));
+
+    u16 address = 0;
+    ASSERT_TRUE(symbols.findAddress("zpt", address));
+    EXPECT_EQ(0x000A, address);
+    ASSERT_TRUE(symbols.findAddress("start", address));
+    EXPECT_EQ(0x0400, address);
+    ASSERT_TRUE(symbols.findAddress("test_case", address));
+    EXPECT_EQ(0x0403, address);
+    ASSERT_TRUE(symbols.findAddress(".loop", address));
+    EXPECT_EQ(0x0404, address);
+
+    EXPECT_FALSE(symbols.findAddress("zero_page", address));
+    EXPECT_FALSE(symbols.findAddress("done", address));
+    EXPECT_FALSE(symbols.findAddress("trap", address));
+    EXPECT_FALSE(symbols.findAddress("Start", address));
+}
+
+TEST(SymbolTableTest, givenAs65ListingThenLoadMacroInvocationsAtAddressesOfTheirExpansions) {
+    SymbolTable symbols{};
+    ASSERT_TRUE(symbols.loadAs65Listing(listing.data(), listing.size()));
+    EXPECT_EQ(2u, symbols.getSymbolsCount(SymbolTable::Kind::MacroExpansion));
+
+    u16 address = 0;
+    ASSERT_TRUE(symbols.findAddress("trap", address, SymbolTable::Kind::MacroExpansion));
+    EXPECT_EQ(0x0406, address);
+    ASSERT_TRUE(symbols.findAddress("success", address, SymbolTable::Kind::MacroExpansion));
+    EXPECT_EQ(0x0500, address);
+    EXPECT_FALSE(symbols.findAddress("start", address, SymbolTable::Kind::MacroExpansion));
+}
+
+TEST(SymbolTableTest, givenTextWithoutAssembledLinesThenListingIsNotLoaded) {
+    SymbolTable symbols{};
+    EXPECT_FALSE(symbols.loadAs65Listing("nothing here\n", 13));
+    EXPECT_EQ(0u, symbols.getSymbolsCount(SymbolTable::Kind::Label));
+}
+
+TEST(SymbolTableTest, givenLabelFileThenLoadAllValueFormats) {
+    const std::string labels = "; labels\n"
+                               "start = $0400\n"
+                               "  vector equ 0xFFFA\r\n"
+                               "buffer=512 ; comment\n";
+    SymbolTable symbols{};
+    ASSERT_TRUE(symbols.loadLabelFile(labels.data(), labels.size()));
+    EXPECT_EQ(3u, symbols.getSymbolsCount(SymbolTable::Kind::Label));
+
+    u16 address = 0;
+    ASSERT_TRUE(symbols.findAddress("start", address));
+    EXPECT_EQ(0x0400, address);
+    ASSERT_TRUE(symbols.findAddress("vector", address));
+    EXPECT_EQ(0xFFFA, address);
+    ASSERT_TRUE(symbols.findAddress("buffer", address));
+    EXPECT_EQ(0x0200, address);
+
+    const std::string invalid = "start = $10000\n"
+                                "garbage\n";
+    EXPECT_FALSE(symbols.loadLabelFile(invalid.data(), invalid.size()));
+}
+
+TEST(SymbolTableTest, givenAddressThenFormatItWithNearestLabelBelow) {
+    SymbolTable symbols{};
+    symbols.add("loop", 0x0410);
+    symbols.add("start", 0x0400);
+    symbols.add("entry", 0x0400);
+    symbols.add("success", 0x0420, SymbolTable::Kind::MacroExpansion);
+
+    EXPECT_EQ("0x03ff", symbols.formatAddress(0x03FF));
+    EXPECT_EQ("start", symbols.formatAddress(0x0400));
+    EXPECT_EQ("start+0xf", symbols.formatAddress(0x040F));
+    EXPECT_EQ("loop", symbols.formatAddress(0x0410));
+    EXPECT_EQ("loop+0x11", symbols.formatAddress(0x0421));
+    EXPECT_EQ("loop+0xfbef", symbols.formatAddress(0xFFFF));
+
+    char buffer[8];
+    symbols.formatAddress(0x0415, buffer, sizeof(buffer));
+    EXPECT_STREQ("loop+0x", buffer);
+
+    u16 offset = 0;
+    EXPECT_EQ(nullptr, symbols.findLabel(0x0000, offset));
+    EXPECT_STREQ("start", symbols.findLabel(0x0401, offset));
+    EXPECT_EQ(1u, offset);
+}
@@ -0,0 +1,67 @@
+#include "src/work_stealing_thread_pool.h"
+
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+
+TEST(WorkStealingThreadPoolTest, givenManyTasksWhenWaitingForIdleThenAllTasksAreExecuted) {
+    std::atomic_uint32_t executedTasks = 0;
+    WorkStealingThreadPool pool{4};
+    for (u32 i = 0; i < 1000; i++) {
+        pool.submit([&]() { executedTasks++; });
+    }
+    pool.waitForIdle();
+    EXPECT_EQ(1000u, executedTasks.load());
+}
+
+TEST(WorkStealingThreadPoolTest, givenTasksSubmittingMoreTasksWhenWaitingForIdleThenAllTasksAreExecuted) {
+    std::atomic_uint32_t executedTasks = 0;
+    WorkStealingThreadPool pool{4};
+    std::function<void(u32)> spawn = [&](u32 depth) {
+        executedTasks++;
+        if (depth > 0) {
+            pool.submit([&, depth]() { spawn(depth - 1); });
+            pool.submit([&, depth]() { spawn(depth - 1); });
+        }
+    };
+    pool.submit([&]() { spawn(9); });
+    pool.waitForIdle();
+    EXPECT_EQ(1023u, executedTasks.load());
+}
+
+TEST(WorkStealingThreadPoolTest, givenTasksSubmittedFromOneWorkerThenOtherWorkersStealThem) {
+    WorkStealingThreadPool pool{4};
+    std::mutex mutex{};
+    std::set<u32> workerIndices{};
+    std::atomic_uint32_t startedTasks = 0;
+
+    pool.submit([&]() {
+        for (u32 i = 0; i < pool.getThreadsCount(); i++) {
+            pool.submit([&]() {
+                // Block until all tasks are started, which is only possible if they are stolen by other workers.
+                startedTasks++;
+                while (startedTasks.load() < pool.getThreadsCount()) {
+                    std::this_thread::yield();
+                }
+                std::lock_guard<std::mutex> lock{mutex};
+                workerIndices.insert(WorkStealingThreadPool::getCurrentWorkerIndex());
+            });
+        }
+    });
+    pool.waitForIdle();
+    EXPECT_EQ(pool.getThreadsCount(), workerIndices.size());
+    EXPECT_EQ(WorkStealingThreadPool::invalidWorkerIndex, WorkStealingThreadPool::getCurrentWorkerIndex());
+}
+
+TEST(WorkStealingThreadPoolTest, givenTasksSubmittedFromWorkerThenNewestRunsFirstUnlessSubmittedLast) {
+    WorkStealingThreadPool pool{1};
+    std::vector<u32> order{};
+    pool.submit([&]() {
+        pool.submitLast([&]() { order.push_back(0); });
+        pool.submit([&]() { order.push_back(1); });
+        pool.submit([&]() { order.push_back(2); });
+        pool.submitLast([&]() { order.push_back(3); });
+    });
+    pool.waitForIdle();
+    EXPECT_EQ((std::vector<u32>{2, 1, 0, 3}), order);
+}
@@ -0,0 +1,176 @@
+#include "batch_job.h"
+
+#include "src/error.h"
+#include "src/semihosting.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace {
+bool parseAddress(const std::string &text, u16 &outAddress) {
+    u32 value = 0;
+    if (!parseNumber(text, value) || value > 0xFFFF) {
+        return false;
+    }
+    outAddress = static_cast<u16>(value);
+    return true;
+}
+
+bool parsePath(const std::string &text, const std::filesystem::path &directory, Job &job) {
+    const size_t atPosition = text.rfind('@');
+    const size_t colonPosition = text.rfind(':');
+    job.path = (directory / text.substr(0, atPosition)).string();
+    job.format = getImageFormat(job.path);
+    if (atPosition == std::string::npos) {
+        return !text.empty();
+    }
+
+    u32 offset = 0;
+    u32 size = 0;
+    const bool valid = colonPosition != std::string::npos && colonPosition > atPosition &&
+                       parseNumber(text.substr(atPosition + 1, colonPosition - atPosition - 1), offset) &&
+                       parseNumber(text.substr(colonPosition + 1), size);
+    job.offset = offset;
+    job.size = size;
+    return valid && atPosition > 0 && job.format == ImageFormat::Raw;
+}
+} // namespace
+
+bool parseNumber(const std::string &text, u32 &outValue) {
+    const char *begin = text.c_str();
+    int base = 0;
+    if (*begin == '$') {
+        begin++;
+        base = 16;
+    }
+
+    char *end = nullptr;
+    const unsigned long value = strtoul(begin, &end, base);
+    if (end == begin || *end != '\0') {
+        return false;
+    }
+    outValue = static_cast<u32>(value);
+    return true;
+}
+
+bool parseFileAddress(const std::string &text, bool &outFromFile, u16 &outAddress) {
+    outFromFile = text == "-";
+    return outFromFile || parseAddress(text, outAddress);
+}
+
+bool parseStopCondition(const std::string &text, Job &job) {
+    if (text == "hang") {
+        job.stopCondition = StopCondition::Hang;
+        return true;
+    }
+    if (text.rfind("pc:", 0) == 0) {
+        u16 address = 0;
+        job.stopCondition = StopCondition::ProgramCounter;
+        const bool result = parseAddress(text.substr(3), address);
+        job.stopValue = address;
+        return result;
+    }
+    if (text.rfind("count:", 0) == 0) {
+        job.stopCondition = StopCondition::InstructionCount;
+        return parseNumber(text.substr(6), job.stopValue) && job.stopValue > 0;
+    }
+    if (text == "exit" || text.rfind("exit:", 0) == 0) {
+        u16 address = Semihosting::defaultPageAddress;
+        job.stopCondition = StopCondition::Exit;
+        const bool result = text == "exit" || parseAddress(text.substr(5), address);
+        job.stopValue = address;
+        return result && address % Memory::pageSize == 0;
+    }
+    return false;
+}
+
+std::vector<Job> readManifest(const std::string &manifestPath) {
+    std::ifstream file{manifestPath};
+    FATAL_ERROR_IF(!file, "Failed loading %s", manifestPath.c_str());
+    const std::filesystem::path manifestDirectory = std::filesystem::path(manifestPath).parent_path();
+
+    std::vector<Job> jobs{};
+    std::string line{};
+    for (u32 lineIndex = 1; std::getline(file, line); lineIndex++) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream stream{line};
+        std::string path{}, loadAddress{}, startPc{}, stopCondition{};
+        stream >> path >> loadAddress >> startPc >> stopCondition;
+
+        Job job{};
+        const bool valid = parsePath(path, manifestDirectory, job) &&
+                           parseFileAddress(loadAddress, job.loadAddressFromFile, job.loadAddress) &&
+                           parseFileAddress(startPc, job.startPcFromFile, job.startPc) &&
+                           parseStopCondition(stopCondition, job);
+        FATAL_ERROR_IF(!valid, "Invalid line %u in %s", lineIndex, manifestPath.c_str());
+        FATAL_ERROR_IF(job.loadAddressFromFile && job.size != SIZE_MAX, "Archive entry without load address at line %u in %s", lineIndex, manifestPath.c_str());
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+std::vector<Job> readDirectory(const std::string &directoryPath, const Job &jobTemplate) {
+    std::vector<Job> jobs{};
+    for (const auto &entry : std::filesystem::directory_iterator(directoryPath)) {
+        const std::string extension = entry.path().extension().string();
+        if (entry.is_regular_file() && (extension == ".bin" || getImageFormat(entry.path().string()) != ImageFormat::Raw)) {
+            Job job = jobTemplate;
+            job.path = entry.path().string();
+            job.format = getImageFormat(job.path);
+            jobs.push_back(job);
+        }
+    }
+    std::sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) { return a.path < b.path; });
+    return jobs;
+}
+
+void mapFiles(std::vector<Job> &jobs) {
+    std::map<std::string, std::shared_ptr<const MappedFile>> files{};
+    for (Job &job : jobs) {
+        auto it = files.find(job.path);
+        if (it == files.end()) {
+            it = files.emplace(job.path, MappedFile::open(job.path)).first;
+        }
+        job.file = it->second;
+    }
+}
+
+bool loadJobImage(Processor &processor, const Job &job) {
+    if (job.file == nullptr) {
+        return false;
+    }
+
+    // Raw binaries take the load address from the as65 listing, but stay shared with the mapping of the job
+    u16 loadAddress = job.loadAddress;
+    if (job.loadAddressFromFile && job.format == ImageFormat::Raw) {
+        const std::string listingPath = std::filesystem::path(job.path).replace_extension(".lst").string();
+        const std::shared_ptr<const MappedFile> listing = MappedFile::open(listingPath);
+        if (listing == nullptr || !findAs65LoadAddress(reinterpret_cast<const char *>(listing->getData()), listing->getSize(), loadAddress)) {
+            return false;
+        }
+    }
+
+    LoadedImage image{};
+    const size_t size = std::min(job.size, job.file->getSize() - std::min(job.offset, job.file->getSize()));
+    if (!loadImage(job.file, job.offset, size, job.format, loadAddress, image)) {
+        return false;
+    }
+
+    // Pooled processors still have images of previous jobs
+    processor.unmapMemoryImages();
+    processor.mapMemoryImage(image.image);
+    processor.reset();
+    if (!job.startPcFromFile) {
+        processor.loadProgramCounter(job.startPc);
+    } else if (image.hasEntryPoint) {
+        processor.loadProgramCounter(image.entryPoint);
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "src/image_loader.h"
+#include "src/processor.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Programs run by emos_batch. They can be listed in a manifest file, each line having a format:
+//     <path>[@<offset>:<size>] <load address> <start pc> <stop condition>
+// Files are raw binaries, Intel HEX or S-records, recognized by their extension. Offset and size select one
+// image from an archive of raw binaries. Every file is mapped only once and shared by all of its images.
+// Load address "-" takes the addresses from the file, which for raw binaries means an as65 listing next to
+// the file. Archive entries have no listings, so they need an explicit load address. Start pc "-" takes the
+// entry point from the file or, if it has none, from the reset vector.
+// Stop condition is one of:
+//     hang           - stop when the program hangs in an infinite loop
+//     pc:<address>   - stop when the program counter reaches given address
+//     count:<number> - stop after given number of instructions
+//     exit[:<page>]  - stop when the program exits through semihosting page, 0xFE00 by default
+// Alternatively, all image files from a directory can be run with the same parameters.
+
+enum class StopCondition {
+    Hang,
+    ProgramCounter,
+    InstructionCount,
+    Exit,
+};
+
+struct Job {
+    std::string path = {};
+    size_t offset = 0;
+    size_t size = SIZE_MAX; // whole file
+    ImageFormat format = ImageFormat::Raw;
+    std::shared_ptr<const MappedFile> file = {};
+    bool loadAddressFromFile = false;
+    u16 loadAddress = 0;
+    bool startPcFromFile = false;
+    u16 startPc = 0;
+    StopCondition stopCondition = StopCondition::Hang;
+    u32 stopValue = 0;
+};
+
+bool parseNumber(const std::string &text, u32 &outValue);
+bool parseFileAddress(const std::string &text, bool &outFromFile, u16 &outAddress);
+bool parseStopCondition(const std::string &text, Job &job);
+
+std::vector<Job> readManifest(const std::string &manifestPath);
+std::vector<Job> readDirectory(const std::string &directoryPath, const Job &jobTemplate);
+void mapFiles(std::vector<Job> &jobs); // maps every file once, so images from the same archive share one mapping
+
+// Maps the image of the job into a pooled processor, dropping images of previous jobs, and sets the pc
+bool loadJobImage(Processor &processor, const Job &job);
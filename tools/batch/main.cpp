@@ -0,0 +1,198 @@
+#include "src/error.h"
+#include "src/processor_pool.h"
+#include "src/work_stealing_thread_pool.h"
+#include "tools/batch/batch_job.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Runs many 6502 programs to completion in parallel. Programs are listed in a manifest file or taken from a
+// directory, see batch_job.h. Results are written as CSV, one line per program.
+
+struct JobResult {
+    const char *status = "not_run";
+    u16 exitPc = 0;
+    u8 exitCode = 0;
+    u32 cycles = 0;
+    u32 instructions = 0;
+    u64 wallTimeUs = 0;
+};
+
+void executeJob(Processor &processor, const Job &job, u32 instructionBudget, JobResult &result) {
+    if (!loadJobImage(processor, job)) {
+        result.status = "load_failed";
+        return;
+    }
+
+    ExecutionResult executionResult{};
+    Semihosting semihosting{static_cast<u16>(job.stopCondition == StopCondition::Exit ? job.stopValue : 0)};
+    switch (job.stopCondition) {
+    case StopCondition::Hang:
+        processor.activateHangDetector();
+        executionResult = processor.executeInstructions(instructionBudget);
+        break;
+    case StopCondition::ProgramCounter:
+        processor.setBreakpoint(static_cast<u16>(job.stopValue));
+        executionResult = processor.executeInstructions(instructionBudget);
+        break;
+    case StopCondition::InstructionCount:
+        executionResult = processor.executeInstructions(instructionBudget == 0 ? job.stopValue : std::min(job.stopValue, instructionBudget));
+        break;
+    case StopCondition::Exit:
+        processor.attachSemihosting(&semihosting);
+        executionResult = processor.executeInstructions(instructionBudget);
+        processor.attachSemihosting(nullptr);
+        break;
+    default:
+        UNREACHABLE_CODE();
+    }
+
+    switch (executionResult.stopReason) {
+    case StopReason::BudgetExhausted: {
+        const bool countReached = job.stopCondition == StopCondition::InstructionCount && executionResult.instructionsExecuted == job.stopValue;
+        result.status = countReached ? "count_reached" : "budget_exhausted";
+        break;
+    }
+    case StopReason::Hang:
+        result.status = "hang";
+        break;
+    case StopReason::Breakpoint:
+        result.status = "pc_reached";
+        break;
+    case StopReason::InvalidOpcode:
+        result.status = "invalid_opcode";
+        break;
+    case StopReason::GuestError:
+        result.status = "guest_error";
+        break;
+    case StopReason::GuestExit:
+        result.status = "exit";
+        result.exitCode = semihosting.getExitCode();
+        break;
+    default:
+        UNREACHABLE_CODE();
+    }
+    result.exitPc = executionResult.pc;
+}
+
+void runJob(ProcessorPool &processorPool, const Job &job, u32 instructionBudget, JobResult &result) {
+    const auto startTime = std::chrono::steady_clock::now();
+
+    Processor *processor = processorPool.acquire();
+    FATAL_ERROR_IF(processor == nullptr, "No free processors in the pool");
+    try {
+        executeJob(*processor, job, instructionBudget, result);
+    } catch (const std::exception &) {
+        result.status = "error";
+        result.exitPc = processor->getRegisters().pc;
+    }
+
+    result.cycles = processor->getCounters().cyclesProcessed;
+    result.instructions = processor->getCounters().instructionsProcessed;
+    processorPool.release(processor);
+
+    const auto endTime = std::chrono::steady_clock::now();
+    result.wallTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+}
+
+void printUsage() {
+    INFO("Usage: emos_batch [options] (-m <manifest> | -d <directory>)");
+    INFO("Options:");
+    INFO("  -j <threads>   number of threads, all hardware threads by default");
+    INFO("  -o <file>      output CSV file, stdout by default");
+    INFO("  -b <count>     maximum number of instructions per program, unlimited by default");
+    INFO("Options for -d:");
+    INFO("  -l <address>   load address of raw binaries or - for addresses from files, 0 by default");
+    INFO("  -p <address>   start program counter or - for entry point from files, 0 by default");
+    INFO("  -s <stop>      stop condition (hang, pc:<address>, count:<number>, exit[:<page>]), hang by default");
+}
+
+int main(int argc, char **argv) {
+    u32 threadsCount = 0;
+    u32 instructionBudget = 0;
+    std::string manifestPath{};
+    std::string directoryPath{};
+    std::string outputPath{};
+    Job jobTemplate{};
+
+    for (int argIndex = 1; argIndex < argc; argIndex++) {
+        const char *arg = argv[argIndex];
+        const bool hasValue = argIndex + 1 < argc;
+        const std::string value = hasValue ? argv[argIndex + 1] : "";
+        bool valid = hasValue;
+
+        if (strcmp(arg, "-j") == 0) {
+            valid = valid && parseNumber(value, threadsCount);
+        } else if (strcmp(arg, "-o") == 0) {
+            outputPath = value;
+        } else if (strcmp(arg, "-b") == 0) {
+            valid = valid && parseNumber(value, instructionBudget);
+        } else if (strcmp(arg, "-m") == 0) {
+            manifestPath = value;
+        } else if (strcmp(arg, "-d") == 0) {
+            directoryPath = value;
+        } else if (strcmp(arg, "-l") == 0) {
+            valid = valid && parseFileAddress(value, jobTemplate.loadAddressFromFile, jobTemplate.loadAddress);
+        } else if (strcmp(arg, "-p") == 0) {
+            valid = valid && parseFileAddress(value, jobTemplate.startPcFromFile, jobTemplate.startPc);
+        } else if (strcmp(arg, "-s") == 0) {
+            valid = valid && parseStopCondition(value, jobTemplate);
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            printUsage();
+            return 1;
+        }
+        argIndex++;
+    }
+    if (manifestPath.empty() == directoryPath.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<Job> jobs = manifestPath.empty() ? readDirectory(directoryPath, jobTemplate) : readManifest(manifestPath);
+    mapFiles(jobs);
+    std::vector<JobResult> results(jobs.size());
+
+    // Execute all jobs. Every worker uses at most one processor at a time, so the pool is never exhausted.
+    const auto startTime = std::chrono::steady_clock::now();
+    {
+        WorkStealingThreadPool threadPool{threadsCount};
+        ProcessorPool processorPool{threadPool.getThreadsCount()};
+        for (size_t jobIndex = 0; jobIndex < jobs.size(); jobIndex++) {
+            threadPool.submit([&, jobIndex]() {
+                runJob(processorPool, jobs[jobIndex], instructionBudget, results[jobIndex]);
+            });
+        }
+        threadPool.waitForIdle();
+    }
+    const auto endTime = std::chrono::steady_clock::now();
+
+    // Write results
+    std::ofstream outputFile{};
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath);
+        FATAL_ERROR_IF(!outputFile, "Failed opening %s", outputPath.c_str());
+    }
+    std::ostream &output = outputPath.empty() ? std::cout : outputFile;
+    output << "file,status,exit_pc,exit_code,cycles,instructions,wall_time_us\n";
+    for (size_t jobIndex = 0; jobIndex < jobs.size(); jobIndex++) {
+        const JobResult &result = results[jobIndex];
+        char exitPc[7];
+        snprintf(exitPc, sizeof(exitPc), "0x%04x", result.exitPc);
+        output << jobs[jobIndex].path << ',' << result.status << ',' << exitPc << ',' << static_cast<u32>(result.exitCode) << ','
+               << result.cycles << ',' << result.instructions << ',' << result.wallTimeUs << '\n';
+    }
+
+    const auto totalTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    fprintf(stderr, "Executed %zu programs in %lld ms\n", jobs.size(), static_cast<long long>(totalTimeMs));
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "src/control_flow_graph.h"
+#include "src/error.h"
+#include "src/image_loader.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Recovers the control flow graph of a ROM image statically and writes it as DOT or JSON. Code is followed
+// from the reset, IRQ and NMI vectors, from the entry point of the image and from additional entry points.
+
+bool parseNumber(const std::string &text, u32 &outValue) {
+    const char *begin = text.c_str();
+    int base = 0;
+    if (*begin == '$') {
+        begin++;
+        base = 16;
+    }
+
+    char *end = nullptr;
+    const unsigned long value = strtoul(begin, &end, base);
+    if (end == begin || *end != '\0') {
+        return false;
+    }
+    outValue = static_cast<u32>(value);
+    return true;
+}
+
+bool parseAddress(const std::string &text, u16 &outAddress) {
+    u32 value = 0;
+    if (!parseNumber(text, value) || value > 0xFFFF) {
+        return false;
+    }
+    outAddress = static_cast<u16>(value);
+    return true;
+}
+
+void printUsage() {
+    INFO("Usage: emos_cfg [options] <image>");
+    INFO("Options:");
+    INFO("  -l <address>   load address of raw binaries or - for the address from as65 listing, 0 by default");
+    INFO("  -e <address>   additional entry point, can be used many times");
+    INFO("  -s <file>      symbols from as65 listing or label file, listing of as65 binaries by default");
+    INFO("  -f <format>    output format (dot, json), dot by default");
+    INFO("  -o <file>      output file, stdout by default");
+}
+
+int main(int argc, char **argv) {
+    std::string imagePath{};
+    std::string symbolsPath{};
+    std::string outputPath{};
+    std::string format = "dot";
+    u16 loadAddress = 0;
+    bool loadAddressFromListing = false;
+    std::vector<u16> entryPoints{};
+
+    for (int argIndex = 1; argIndex < argc; argIndex++) {
+        const char *arg = argv[argIndex];
+        if (arg[0] != '-') {
+            imagePath = arg;
+            continue;
+        }
+
+        const bool hasValue = argIndex + 1 < argc;
+        const std::string value = hasValue ? argv[argIndex + 1] : "";
+        bool valid = hasValue;
+        u16 address = 0;
+        if (strcmp(arg, "-l") == 0) {
+            loadAddressFromListing = value == "-";
+            valid = valid && (loadAddressFromListing || parseAddress(value, loadAddress));
+        } else if (strcmp(arg, "-e") == 0) {
+            valid = valid && parseAddress(value, address);
+            entryPoints.push_back(address);
+        } else if (strcmp(arg, "-s") == 0) {
+            symbolsPath = value;
+        } else if (strcmp(arg, "-f") == 0) {
+            format = value;
+            valid = valid && (format == "dot" || format == "json");
+        } else if (strcmp(arg, "-o") == 0) {
+            outputPath = value;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            printUsage();
+            return 1;
+        }
+        argIndex++;
+    }
+    if (imagePath.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    // Load the image and symbols
+    ImageFormat imageFormat = getImageFormat(imagePath);
+    if (loadAddressFromListing && imageFormat == ImageFormat::Raw) {
+        imageFormat = ImageFormat::As65;
+        if (symbolsPath.empty()) {
+            symbolsPath = std::filesystem::path(imagePath).replace_extension(".lst").string();
+        }
+    }
+    LoadedImage image{};
+    FATAL_ERROR_IF(!loadImageFile(imagePath, imageFormat, loadAddress, image), "Failed loading %s: %s", imagePath.c_str(), image.error);
+    Memory memory{};
+    memory.mapImage(image.image);
+
+    SymbolTable symbols{};
+    FATAL_ERROR_IF(!symbolsPath.empty() && !symbols.loadFile(symbolsPath), "Failed loading symbols from %s", symbolsPath.c_str());
+
+    // Build the graph
+    const auto startTime = std::chrono::steady_clock::now();
+    ControlFlowGraph graph{};
+    graph.addVectorEntryPoints(memory);
+    if (image.hasEntryPoint) {
+        graph.addEntryPoint(image.entryPoint);
+    }
+    for (const u16 entryPoint : entryPoints) {
+        graph.addEntryPoint(entryPoint);
+    }
+    graph.build(memory);
+    const auto endTime = std::chrono::steady_clock::now();
+
+    // Write the graph
+    std::string text{};
+    if (format == "dot") {
+        graph.writeDot(memory, &symbols, text);
+    } else {
+        graph.writeJson(&symbols, text);
+    }
+    std::ofstream outputFile{};
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath);
+        FATAL_ERROR_IF(!outputFile, "Failed opening %s", outputPath.c_str());
+    }
+    std::ostream &output = outputPath.empty() ? std::cout : outputFile;
+    output << text;
+
+    const auto totalTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+    fprintf(stderr, "Found %zu blocks and %zu edges in %lld us\n", graph.getBlocks().size(), graph.getEdges().size(), static_cast<long long>(totalTimeUs));
+    return 0;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "src/error.h"
+#include "src/types.h"
+
+#include <limits>
+#include <string_view>
+
+// Minimal pull parser for JSON documents. It works directly on the mapped file, so strings are returned as
+// views into it and nothing is allocated. Only the subset of JSON used by the test corpora is supported:
+// strings, whose escape sequences are skipped but not decoded, and unsigned 32-bit integers. Errors raise
+// FATAL_ERROR with the offset in the file.
+//
+// Arrays and objects are iterated with:
+//     parser.expect('[');
+//     if (!parser.consume(']')) {
+//         do { ... } while (parser.consume(','));
+//         parser.expect(']');
+//     }
+class JsonParser {
+public:
+    JsonParser(const char *begin, size_t size) : begin(begin), current(begin), end(begin + size) {}
+
+    bool isAtEnd() {
+        skipWhitespace();
+        return current == end;
+    }
+
+    bool consume(char character) {
+        skipWhitespace();
+        if (current != end && *current == character) {
+            current++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char character) {
+        if (!consume(character)) {
+            char message[] = "'?' expected";
+            message[1] = character;
+            fail(message);
+        }
+    }
+
+    std::string_view parseString() {
+        expect('"');
+        const char *stringBegin = current;
+        while (current != end && *current != '"') {
+            if (*current == '\\' && ++current == end) {
+                break;
+            }
+            current++;
+        }
+        if (current == end) {
+            fail("unterminated string");
+        }
+        return std::string_view{stringBegin, static_cast<size_t>(current++ - stringBegin)};
+    }
+
+    u32 parseUnsigned() {
+        skipWhitespace();
+        if (current == end || !isDigit(*current)) {
+            fail("number expected");
+        }
+        u32 result = 0;
+        while (current != end && isDigit(*current)) {
+            const u32 digit = static_cast<u32>(*current - '0');
+            if (result > (std::numeric_limits<u32>::max() - digit) / 10) {
+                fail("number too large");
+            }
+            result = result * 10 + digit;
+            current++;
+        }
+        return result;
+    }
+
+    // Parses "key": and returns the key
+    std::string_view parseKey() {
+        const std::string_view key = parseString();
+        expect(':');
+        return key;
+    }
+
+    void skipValue() {
+        skipWhitespace();
+        if (current == end) {
+            fail("value expected");
+        }
+        switch (*current) {
+        case '"':
+            parseString();
+            return;
+        case '[':
+        case '{':
+            skipContainer();
+            return;
+        default:
+            // Numbers and literals
+            while (current != end && !isDelimiter(*current)) {
+                current++;
+            }
+        }
+    }
+
+    size_t getOffset() const { return static_cast<size_t>(current - begin); }
+
+private:
+    static bool isDigit(char character) { return character >= '0' && character <= '9'; }
+    static bool isWhitespace(char character) { return character == ' ' || character == '\n' || character == '\r' || character == '\t'; }
+    static bool isDelimiter(char character) { return isWhitespace(character) || character == ',' || character == ']' || character == '}'; }
+
+    void skipWhitespace() {
+        while (current != end && isWhitespace(*current)) {
+            current++;
+        }
+    }
+
+    void skipContainer() {
+        u32 depth = 0;
+        do {
+            if (current == end) {
+                fail("unterminated container");
+            }
+            switch (*current) {
+            case '"':
+                parseString();
+                continue;
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                depth--;
+                break;
+            }
+            current++;
+        } while (depth > 0);
+    }
+
+    [[noreturn]] void fail(const char *message) {
+        FATAL_ERROR("JSON parsing failed at offset %zu: %s", getOffset(), message);
+    }
+
+    const char *const begin;
+    const char *current;
+    const char *const end;
+};
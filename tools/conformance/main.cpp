@@ -0,0 +1,116 @@
+#include "src/error.h"
+#include "src/work_stealing_thread_pool.h"
+#include "tools/conformance/single_step_test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Runs per-opcode single-step test corpora, one JSON file per opcode with thousands of cases each. Every case
+// sets up registers and memory, executes one instruction and compares registers, memory and cycle count with
+// the expected values. Files are processed in parallel, each file by one thread.
+
+struct Options {
+    std::vector<std::string> paths = {};
+    u32 threadsCount = 0;
+    u32 maxReportedFailures = 3;
+};
+
+void printUsage() {
+    INFO("Usage: emos_conformance [options] <file or directory>...");
+    INFO("Options:");
+    INFO("  -j <count>  number of threads, all hardware threads by default");
+    INFO("  -f <count>  number of failed cases reported per file, 3 by default");
+    INFO("Directories are searched for .json files.");
+}
+
+bool parseOptions(int argc, char **argv, Options &options) {
+    for (int argIndex = 1; argIndex < argc; argIndex++) {
+        const char *arg = argv[argIndex];
+        if (strcmp(arg, "-j") == 0 || strcmp(arg, "-f") == 0) {
+            if (argIndex + 1 == argc) {
+                return false;
+            }
+            char *end = nullptr;
+            const char *value = argv[++argIndex];
+            const u32 number = static_cast<u32>(strtoul(value, &end, 0));
+            if (end == value || *end != '\0') {
+                return false;
+            }
+            (arg[1] == 'j' ? options.threadsCount : options.maxReportedFailures) = number;
+        } else {
+            options.paths.push_back(arg);
+        }
+    }
+    return !options.paths.empty();
+}
+
+std::vector<std::string> findFiles(const std::vector<std::string> &paths) {
+    std::vector<std::string> result{};
+    for (const std::string &path : paths) {
+        if (!std::filesystem::is_directory(path)) {
+            result.push_back(path);
+            continue;
+        }
+        for (const auto &entry : std::filesystem::directory_iterator(path)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                result.push_back(entry.path().string());
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+int main(int argc, char **argv) {
+    Options options{};
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+    const std::vector<std::string> files = findFiles(options.paths);
+
+    // Run all files. Larger files would be better scheduled first, but all files of a corpus have similar sizes.
+    const auto startTime = std::chrono::steady_clock::now();
+    std::vector<SingleStepFileResult> results(files.size());
+    {
+        WorkStealingThreadPool threadPool{options.threadsCount};
+        for (size_t fileIndex = 0; fileIndex < files.size(); fileIndex++) {
+            threadPool.submit([&, fileIndex]() {
+                results[fileIndex] = runSingleStepFile(files[fileIndex], options.maxReportedFailures);
+            });
+        }
+        threadPool.waitForIdle();
+    }
+    const auto endTime = std::chrono::steady_clock::now();
+
+    // Report results
+    SingleStepFileResult total{};
+    u32 failedFiles = 0;
+    for (size_t fileIndex = 0; fileIndex < files.size(); fileIndex++) {
+        const SingleStepFileResult &result = results[fileIndex];
+        const std::string fileName = std::filesystem::path(files[fileIndex]).filename().string();
+        if (!result.parsed) {
+            INFO("%s: invalid file after %u cases", fileName.c_str(), result.passed + result.failed + result.skipped);
+        } else if (result.failed > 0) {
+            INFO("%s: %u passed, %u failed, %u skipped", fileName.c_str(), result.passed, result.failed, result.skipped);
+            printf("%s", result.failures.c_str());
+        }
+        failedFiles += !result.parsed || result.failed > 0;
+        total.passed += result.passed;
+        total.failed += result.failed;
+        total.skipped += result.skipped;
+    }
+
+    const auto totalTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    INFO("Files:   %zu (%u failed)", files.size(), failedFiles);
+    INFO("Passed:  %u", total.passed);
+    INFO("Failed:  %u", total.failed);
+    INFO("Skipped: %u", total.skipped);
+    INFO("Time:    %lld ms", static_cast<long long>(totalTimeMs));
+    return failedFiles == 0 ? 0 : 2;
+}
@@ -0,0 +1,226 @@
+#include "single_step_test.h"
+
+#include "src/os_memory.h"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+
+namespace {
+void parseState(JsonParser &parser, SingleStepState &outState) {
+    outState.ram.clear();
+
+    parser.expect('{');
+    if (parser.consume('}')) {
+        return;
+    }
+    do {
+        const std::string_view key = parser.parseKey();
+        if (key == "pc") {
+            outState.regs.pc = static_cast<u16>(parser.parseUnsigned());
+        } else if (key == "s") {
+            outState.regs.sp = static_cast<u8>(parser.parseUnsigned());
+        } else if (key == "a") {
+            outState.regs.a = static_cast<u8>(parser.parseUnsigned());
+        } else if (key == "x") {
+            outState.regs.x = static_cast<u8>(parser.parseUnsigned());
+        } else if (key == "y") {
+            outState.regs.y = static_cast<u8>(parser.parseUnsigned());
+        } else if (key == "p") {
+            outState.regs.flags = StatusFlags::fromU8(static_cast<u8>(parser.parseUnsigned()));
+        } else if (key == "ram") {
+            parser.expect('[');
+            if (!parser.consume(']')) {
+                do {
+                    parser.expect('[');
+                    const u16 address = static_cast<u16>(parser.parseUnsigned());
+                    parser.expect(',');
+                    const u8 value = static_cast<u8>(parser.parseUnsigned());
+                    parser.expect(']');
+                    outState.ram.emplace_back(address, value);
+                } while (parser.consume(','));
+                parser.expect(']');
+            }
+        } else {
+            parser.skipValue();
+        }
+    } while (parser.consume(','));
+    parser.expect('}');
+}
+
+u32 parseCyclesCount(JsonParser &parser) {
+    u32 result = 0;
+    parser.expect('[');
+    if (!parser.consume(']')) {
+        do {
+            parser.skipValue();
+            result++;
+        } while (parser.consume(','));
+        parser.expect(']');
+    }
+    return result;
+}
+} // namespace
+
+void parseSingleStepCase(JsonParser &parser, SingleStepCase &outCase) {
+    outCase.name = {};
+    outCase.cyclesCount = 0;
+
+    parser.expect('{');
+    if (parser.consume('}')) {
+        return;
+    }
+    do {
+        const std::string_view key = parser.parseKey();
+        if (key == "name") {
+            outCase.name = parser.parseString();
+        } else if (key == "initial") {
+            parseState(parser, outCase.initial);
+        } else if (key == "final") {
+            parseState(parser, outCase.expected);
+        } else if (key == "cycles") {
+            outCase.cyclesCount = parseCyclesCount(parser);
+        } else {
+            parser.skipValue();
+        }
+    } while (parser.consume(','));
+    parser.expect('}');
+}
+
+SingleStepRunner::Result SingleStepRunner::run(const SingleStepCase &testCase, std::string *outDescription) {
+    if (isSkipped(testCase)) {
+        return Result::Skipped;
+    }
+
+    // Set the initial state
+    state.regs = testCase.initial.regs;
+    state.counters = {};
+    state.memory.reset();
+    for (const auto &[address, value] : testCase.initial.ram) {
+        state.memory.write(address, value);
+    }
+    processor.restoreState(state);
+
+    // Execute
+    if (!processor.executeInstructions(1)) {
+        if (outDescription != nullptr) {
+            *outDescription += "Processor stopped before completing the instruction\n";
+        }
+        return Result::Failed;
+    }
+
+    // Compare with the expected state
+    bool passed = true;
+    char line[64];
+    auto compare = [&](const char *name, u32 expectedValue, u32 actualValue) {
+        if (expectedValue != actualValue) {
+            passed = false;
+            if (outDescription != nullptr) {
+                snprintf(line, sizeof(line), "%s: 0x%02x != 0x%02x\n", name, expectedValue, actualValue);
+                *outDescription += line;
+            }
+        }
+    };
+    const Registers &expectedRegs = testCase.expected.regs;
+    const Registers &actualRegs = processor.getRegisters();
+    compare("a", expectedRegs.a, actualRegs.a);
+    compare("x", expectedRegs.x, actualRegs.x);
+    compare("y", expectedRegs.y, actualRegs.y);
+    compare("sp", expectedRegs.sp, actualRegs.sp);
+    compare("pc", expectedRegs.pc, actualRegs.pc);
+
+    // Break and reserved bits exist only in the copies of flags pushed on the stack, which are compared as memory
+    constexpr u8 flagsMask = 0b1100'1111;
+    compare("flags", expectedRegs.flags.toU8() & flagsMask, actualRegs.flags.toU8() & flagsMask);
+    compare("cycles", testCase.cyclesCount, processor.getCounters().cyclesProcessed);
+
+    for (const auto &[address, value] : testCase.expected.ram) {
+        char name[16];
+        snprintf(name, sizeof(name), "[0x%04x]", address);
+        compare(name, value, processor.getMemory().read(address));
+    }
+    return passed ? Result::Passed : Result::Failed;
+}
+
+bool SingleStepRunner::isSkipped(const SingleStepCase &testCase) {
+    u8 opCode = 0;
+    for (const auto &[address, value] : testCase.initial.ram) {
+        if (address == testCase.initial.regs.pc) {
+            opCode = value;
+        }
+    }
+    if (!Processor::isInstructionSupported(opCode)) {
+        return true;
+    }
+
+    // Zero, overflow and negative flags are not modelled for decimal arithmetic and invalid BCD values stop
+    // the processor. Decimal results for valid BCD values are verified exhaustively by AluTests.
+    // All ADC opcodes have a form of 011xxx01 and all SBC opcodes have a form of 111xxx01.
+    const u8 group = opCode & 0b11100011;
+    return testCase.initial.regs.flags.d && (group == 0b01100001 || group == 0b11100001);
+}
+
+SingleStepFileResult runSingleStepFile(const std::string &path, u32 maxReportedFailures) {
+    SingleStepFileResult result{};
+    size_t size = 0;
+    const u8 *data = nullptr;
+    try {
+        data = OsMemory::mapFile(path.c_str(), size);
+    } catch (const std::exception &) {
+        result.parsed = false;
+        return result;
+    }
+
+    JsonParser parser{reinterpret_cast<const char *>(data), size};
+    SingleStepRunner runner{};
+    SingleStepCase testCase{};
+    std::string description{};
+    auto reportFailure = [&](std::string_view name) {
+        if (result.failed++ < maxReportedFailures) {
+            result.failures += "Case \"" + std::string{name} + "\":\n" + description;
+        }
+    };
+
+    // Errors are handled per case. A case, which cannot be executed, fails and the rest of the file still runs.
+    // A case, which cannot be parsed, fails too, but the position of the next case is unknown after it.
+    try {
+        parser.expect('[');
+        if (!parser.consume(']')) {
+            do {
+                const size_t caseOffset = parser.getOffset();
+                try {
+                    parseSingleStepCase(parser, testCase);
+                } catch (const std::exception &) {
+                    description = "Parsing failed at offset " + std::to_string(parser.getOffset()) + "\n";
+                    reportFailure("at offset " + std::to_string(caseOffset));
+                    throw;
+                }
+
+                description.clear();
+                const bool isReported = result.failed < maxReportedFailures;
+                SingleStepRunner::Result caseResult = SingleStepRunner::Result::Failed;
+                try {
+                    caseResult = runner.run(testCase, isReported ? &description : nullptr);
+                } catch (const std::exception &) {
+                    description += "Execution raised an error\n";
+                }
+                switch (caseResult) {
+                case SingleStepRunner::Result::Passed:
+                    result.passed++;
+                    break;
+                case SingleStepRunner::Result::Failed:
+                    reportFailure(testCase.name);
+                    break;
+                case SingleStepRunner::Result::Skipped:
+                    result.skipped++;
+                    break;
+                }
+            } while (parser.consume(','));
+            parser.expect(']');
+        }
+    } catch (const std::exception &) {
+        result.parsed = false;
+    }
+    OsMemory::unmapFile(data, size);
+    return result;
+}
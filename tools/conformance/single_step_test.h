@@ -0,0 +1,59 @@
+#pragma once
+
+#include "src/processor.h"
+#include "tools/conformance/json_parser.h"
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Case of a per-opcode single-step test corpus. Every file is a JSON array of cases like:
+//     {"name": "a9 12 34",
+//      "initial": {"pc": 1234, "s": 253, "a": 1, "x": 2, "y": 3, "p": 36, "ram": [[1234, 169], [1235, 18]]},
+//      "final":   {"pc": 1236, "s": 253, "a": 18, "x": 2, "y": 3, "p": 36, "ram": [[1234, 169], [1235, 18]]},
+//      "cycles":  [[1234, 169, "read"], [1235, 18, "read"]]}
+// Addresses on the bus are not modelled by the processor, so only the number of cycles is compared.
+struct SingleStepState {
+    Registers regs = {};
+    std::vector<std::pair<u16, u8>> ram = {};
+};
+
+struct SingleStepCase {
+    std::string_view name = {};
+    SingleStepState initial = {};
+    SingleStepState expected = {};
+    u32 cyclesCount = 0;
+};
+
+// Parses next case of the array. Vectors of the case are reused, so parsing does not allocate in steady state.
+void parseSingleStepCase(JsonParser &parser, SingleStepCase &outCase);
+
+// Executes cases on one processor. Initial state is set with restoreState(), so only the pages touched by
+// the previous case are remapped.
+class SingleStepRunner {
+public:
+    enum class Result {
+        Passed,
+        Failed,
+        Skipped, // the case uses a feature, which is not implemented
+    };
+
+    Result run(const SingleStepCase &testCase, std::string *outDescription);
+
+private:
+    static bool isSkipped(const SingleStepCase &testCase);
+
+    Processor processor = {};
+    ProcessorState state = {};
+};
+
+struct SingleStepFileResult {
+    u32 passed = 0;
+    u32 failed = 0;
+    u32 skipped = 0;
+    bool parsed = true;
+    std::string failures = {}; // descriptions of the first failed cases
+};
+
+SingleStepFileResult runSingleStepFile(const std::string &path, u32 maxReportedFailures);
@@ -0,0 +1,304 @@
+#include "src/error.h"
+#include "src/guest_fuzzer.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Coverage-guided fuzzer for 6502 programs. The program is loaded into memory, inputs are written to
+// a configured memory region and executed until the program hangs. Inputs reaching new edges or new hit
+// counts of already seen edges are added to the corpus, like in AFL. Inputs crashing the processor or hanging
+// anywhere else than the success address are saved to the output directory, one for each stop address.
+
+using Input = std::vector<u8>;
+
+struct Options {
+    std::string programPath = {};
+    u16 loadAddress = 0;
+    u16 startPc = 0;
+    bool startPcSet = false;
+    GuestFuzzer::Configuration configuration = {};
+    u64 executionsCount = 1000000;
+    u32 seed = 0;
+    std::string outputDirectory = ".";
+    std::string corpusDirectory = {};
+};
+
+bool parseNumber(const char *text, u32 &outValue) {
+    int base = 0;
+    if (*text == '$') {
+        text++;
+        base = 16;
+    }
+
+    char *end = nullptr;
+    const unsigned long value = strtoul(text, &end, base);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    outValue = static_cast<u32>(value);
+    return true;
+}
+
+bool parseAddress(const char *text, u16 &outAddress) {
+    u32 value = 0;
+    if (!parseNumber(text, value) || value > 0xFFFF) {
+        return false;
+    }
+    outAddress = static_cast<u16>(value);
+    return true;
+}
+
+Input readFile(const std::string &path) {
+    std::ifstream file{path, std::ios::in | std::ios::binary};
+    FATAL_ERROR_IF(!file, "Failed loading %s", path.c_str());
+    return Input{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+void writeFile(const std::string &path, const Input &input) {
+    std::ofstream file{path, std::ios::out | std::ios::binary};
+    file.write(reinterpret_cast<const char *>(input.data()), input.size());
+    FATAL_ERROR_IF(!file, "Failed writing %s", path.c_str());
+}
+
+// Hit counts are grouped into buckets, so loop iterations don't produce endless new inputs. Every bucket is
+// a separate bit, like in AFL, so a bucket seen before never hides a different one.
+u8 getHitCountBucket(u8 hitCount) {
+    static const auto buckets = []() {
+        std::array<u8, 256> result{};
+        for (u32 count = 1; count < result.size(); count++) {
+            if (count <= 3) {
+                result[count] = static_cast<u8>(1 << (count - 1));
+            } else if (count <= 7) {
+                result[count] = 8;
+            } else if (count <= 15) {
+                result[count] = 16;
+            } else if (count <= 31) {
+                result[count] = 32;
+            } else if (count <= 127) {
+                result[count] = 64;
+            } else {
+                result[count] = 128;
+            }
+        }
+        return result;
+    }();
+    return buckets[hitCount];
+}
+
+// Returns true if the coverage contains buckets never seen before and marks them as seen.
+bool updateSeenCoverage(const u8 *coverageMap, std::vector<u8> &seenBuckets) {
+    bool result = false;
+    for (u32 wordIndex = 0; wordIndex < EdgeCoverage::mapSize; wordIndex += sizeof(u64)) {
+        // Most of the map is empty, so skip whole words of zeros.
+        u64 word = 0;
+        memcpy(&word, coverageMap + wordIndex, sizeof(word));
+        if (word == 0) {
+            continue;
+        }
+
+        for (u32 index = wordIndex; index < wordIndex + sizeof(u64); index++) {
+            const u8 bucket = getHitCountBucket(coverageMap[index]);
+            if ((seenBuckets[index] & bucket) != bucket) {
+                seenBuckets[index] |= bucket;
+                result = true;
+            }
+        }
+    }
+    return result;
+}
+
+void mutate(Input &input, std::mt19937 &random, u16 maxInputSize) {
+    static const u8 interestingValues[] = {0x00, 0x01, 0x7F, 0x80, 0xFF};
+    std::uniform_int_distribution<u32> distribution{};
+
+    const u32 mutationsCount = 1 + distribution(random) % 4;
+    for (u32 i = 0; i < mutationsCount; i++) {
+        const u32 position = input.empty() ? 0 : distribution(random) % input.size();
+        switch (input.empty() ? 3 : distribution(random) % 6) {
+        case 0:
+            input[position] ^= static_cast<u8>(1 << (distribution(random) % 8));
+            break;
+        case 1:
+            input[position] = static_cast<u8>(distribution(random));
+            break;
+        case 2:
+            input[position] = interestingValues[distribution(random) % sizeof(interestingValues)];
+            break;
+        case 3:
+            if (input.size() < maxInputSize) {
+                input.insert(input.begin() + position, static_cast<u8>(distribution(random)));
+            }
+            break;
+        case 4:
+            input.erase(input.begin() + position);
+            break;
+        case 5:
+            input[position] += static_cast<u8>(distribution(random) % 16 - 8);
+            break;
+        default:
+            UNREACHABLE_CODE();
+        }
+    }
+}
+
+void printUsage() {
+    INFO("Usage: emos_guest_fuzz [options] -r <program>");
+    INFO("Options:");
+    INFO("  -l <address>   load address of the program, 0 by default");
+    INFO("  -p <address>   start program counter, taken from the reset vector by default");
+    INFO("  -i <address>   address of the input region, 0x0200 by default");
+    INFO("  -z <address>   address of 16-bit input size, 0x00FE by default");
+    INFO("  -n <size>      maximum input size, 256 by default");
+    INFO("  -e <address>   hang address meaning, that the input was processed correctly");
+    INFO("  -b <count>     maximum number of instructions per input, 100000 by default");
+    INFO("  -x <count>     number of executions, 1000000 by default");
+    INFO("  -s <seed>      seed of the random generator, 0 by default");
+    INFO("  -c <dir>       directory with initial corpus");
+    INFO("  -o <dir>       directory to save crashing and hanging inputs in, current directory by default");
+}
+
+bool parseOptions(int argc, char **argv, Options &options) {
+    options.configuration.inputAddress = 0x0200;
+    options.configuration.inputSizeAddress = 0x00FE;
+    options.configuration.maxInputSize = 256;
+    options.configuration.instructionBudget = 100000;
+
+    for (int argIndex = 1; argIndex + 1 < argc; argIndex += 2) {
+        const char *arg = argv[argIndex];
+        const char *value = argv[argIndex + 1];
+        u32 number = 0;
+        bool valid = true;
+        if (strcmp(arg, "-r") == 0) {
+            options.programPath = value;
+        } else if (strcmp(arg, "-l") == 0) {
+            valid = parseAddress(value, options.loadAddress);
+        } else if (strcmp(arg, "-p") == 0) {
+            valid = parseAddress(value, options.startPc);
+            options.startPcSet = true;
+        } else if (strcmp(arg, "-i") == 0) {
+            valid = parseAddress(value, options.configuration.inputAddress);
+        } else if (strcmp(arg, "-z") == 0) {
+            valid = parseAddress(value, options.configuration.inputSizeAddress);
+        } else if (strcmp(arg, "-n") == 0) {
+            valid = parseAddress(value, options.configuration.maxInputSize);
+        } else if (strcmp(arg, "-e") == 0) {
+            valid = parseAddress(value, options.configuration.successAddress);
+        } else if (strcmp(arg, "-b") == 0) {
+            valid = parseNumber(value, options.configuration.instructionBudget) && options.configuration.instructionBudget > 0;
+        } else if (strcmp(arg, "-x") == 0) {
+            valid = parseNumber(value, number);
+            options.executionsCount = number;
+        } else if (strcmp(arg, "-s") == 0) {
+            valid = parseNumber(value, options.seed);
+        } else if (strcmp(arg, "-c") == 0) {
+            options.corpusDirectory = value;
+        } else if (strcmp(arg, "-o") == 0) {
+            options.outputDirectory = value;
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && !options.programPath.empty();
+}
+
+int main(int argc, char **argv) {
+    Options options{};
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    // Prepare the initial state
+    const Input program = readFile(options.programPath);
+    FATAL_ERROR_IF(options.loadAddress + program.size() > memorySize, "Program does not fit in memory");
+    const MemoryImage programImage{options.loadAddress, static_cast<u32>(program.size()), program.data()};
+    Processor processor{};
+    processor.mapMemoryImage(programImage);
+    processor.reset();
+    if (options.startPcSet) {
+        processor.loadProgramCounter(options.startPc);
+    }
+    GuestFuzzer fuzzer{processor, options.configuration};
+
+    // Load the initial corpus
+    std::vector<Input> corpus{};
+    if (!options.corpusDirectory.empty()) {
+        for (const auto &entry : std::filesystem::directory_iterator(options.corpusDirectory)) {
+            if (entry.is_regular_file()) {
+                corpus.push_back(readFile(entry.path().string()));
+            }
+        }
+    }
+    if (corpus.empty()) {
+        corpus.push_back(Input(1));
+    }
+
+    // Main fuzzing loop
+    const size_t initialCorpusSize = corpus.size();
+    std::mt19937 random{options.seed};
+    std::vector<u8> seenBuckets(EdgeCoverage::mapSize);
+    std::set<u16> crashAddresses{};
+    std::set<u16> hangAddresses{};
+    u64 timeouts = 0;
+    const auto startTime = std::chrono::steady_clock::now();
+    for (u64 executionIndex = 0; executionIndex < options.executionsCount; executionIndex++) {
+        // Initial corpus is executed without mutations
+        const bool isInitialInput = executionIndex < initialCorpusSize;
+        Input input = isInitialInput ? corpus[executionIndex] : corpus[random() % corpus.size()];
+        if (!isInitialInput) {
+            mutate(input, random, options.configuration.maxInputSize);
+        }
+
+        fuzzer.clearCoverageMap();
+        const GuestFuzzer::Result result = fuzzer.run(input.data(), input.size());
+        const u16 stopAddress = fuzzer.getStopAddress();
+        switch (result) {
+        case GuestFuzzer::Result::Success:
+            break;
+        case GuestFuzzer::Result::Hang:
+            if (hangAddresses.insert(stopAddress).second) {
+                writeFile(options.outputDirectory + "/hang-" + std::to_string(stopAddress) + ".bin", input);
+            }
+            break;
+        case GuestFuzzer::Result::Crash:
+            if (crashAddresses.insert(stopAddress).second) {
+                writeFile(options.outputDirectory + "/crash-" + std::to_string(stopAddress) + ".bin", input);
+            }
+            break;
+        case GuestFuzzer::Result::Timeout:
+            timeouts++;
+            break;
+        default:
+            UNREACHABLE_CODE();
+        }
+
+        if (updateSeenCoverage(fuzzer.getCoverageMap(), seenBuckets) && !isInitialInput) {
+            corpus.push_back(std::move(input));
+        }
+    }
+    const auto endTime = std::chrono::steady_clock::now();
+
+    const u32 edgesCount = static_cast<u32>(std::count_if(seenBuckets.begin(), seenBuckets.end(), [](u8 bucket) { return bucket != 0; }));
+    const auto totalTimeMs = std::max<long long>(1, std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count());
+    INFO("Executions:     %llu (%llu per second)", static_cast<unsigned long long>(options.executionsCount),
+         static_cast<unsigned long long>(options.executionsCount * 1000 / totalTimeMs));
+    INFO("Corpus size:    %zu", corpus.size());
+    INFO("Edges covered:  %u", edgesCount);
+    INFO("Unique crashes: %zu", crashAddresses.size());
+    INFO("Unique hangs:   %zu", hangAddresses.size());
+    INFO("Timeouts:       %llu", static_cast<unsigned long long>(timeouts));
+    return crashAddresses.empty() ? 0 : 2;
+}